@@ -0,0 +1,183 @@
+#include "common.h"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @description: ObjectPool/Arena 与 glibc malloc 的对比压测,结果以 JSON 输出到标准输出
+ * @details 用法: allocator_bench [ops],ops 默认 2000000
+ *          same_thread: 每个线程成批分配 kBatch 个 64 字节对象再全部释放;
+ *          cross_thread: 一个线程分配,经 SpscQueue 交给另一个线程释放;
+ *          shared_ptr: make_shared 与 ObjectPool::MakeShared;
+ *          arena: 分配 kBatch 个 16~80 字节的小块后整体回收,以及 std::pmr::vector 与 std::vector 的构建
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t kBatch = 256;
+
+struct Object {
+    uint64_t data[8];
+};
+
+struct MallocAlloc {
+    static Object* New() { return new Object(); }
+    static void Delete(Object* obj) { delete obj; }
+};
+
+struct PoolAlloc {
+    static Object* New() { return why::ObjectPool<Object>::New(); }
+    static void Delete(Object* obj) { why::ObjectPool<Object>::Delete(obj); }
+};
+
+template<typename Func>
+static double Run(int threads, size_t ops, Func&& func) {
+    std::vector<std::thread> workers{};
+    auto begin = Clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back(func);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+    return threads * ops / sec / 1e6;
+}
+
+template<typename Alloc>
+static double SameThread(int threads, size_t ops) {
+    return Run(threads, ops, [ops] {
+        std::vector<Object*> objs(kBatch);
+        for (size_t i = 0; i < ops; i += kBatch) {
+            for (auto& obj : objs) {
+                obj = Alloc::New();
+            }
+            for (auto obj : objs) {
+                Alloc::Delete(obj);
+            }
+        }
+    });
+}
+
+template<typename Alloc>
+static double CrossThread(size_t ops) {
+    why::SpscQueue<Object*> queue(1024);
+    auto begin = Clock::now();
+    std::thread consumer([&queue, ops] {
+        Object* obj = nullptr;
+        for (size_t i = 0; i < ops;) {
+            if (queue.TryPop(obj)) {
+                Alloc::Delete(obj);
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (size_t i = 0; i < ops; ++i) {
+        Object* obj = Alloc::New();
+        while (!queue.TryPush(obj)) {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+    return ops / sec / 1e6;
+}
+
+template<bool kPooled>
+static double SharedPtr(size_t ops) {
+    return Run(1, ops, [ops] {
+        std::vector<std::shared_ptr<Object>> objs(kBatch);
+        for (size_t i = 0; i < ops; i += kBatch) {
+            for (auto& obj : objs) {
+                obj = kPooled ? why::ObjectPool<Object>::MakeShared() : std::make_shared<Object>();
+            }
+            for (auto& obj : objs) {
+                obj.reset();
+            }
+        }
+    });
+}
+
+template<bool kArena>
+static double SmallBlocks(size_t ops) {
+    return Run(1, ops, [ops] {
+        why::Arena arena{};
+        std::vector<void*> blocks(kBatch);
+        for (size_t i = 0; i < ops; i += kBatch) {
+            for (size_t k = 0; k < kBatch; ++k) {
+                size_t size = 16 + (k % 5) * 16;
+                blocks[k] = kArena ? arena.Allocate(size) : ::malloc(size);
+                static_cast<char*>(blocks[k])[0] = 1;
+            }
+            if (kArena) {
+                arena.Reset();
+            } else {
+                for (auto block : blocks) {
+                    ::free(block);
+                }
+            }
+        }
+    });
+}
+
+template<bool kArena>
+static double BuildVector(size_t ops) {
+    return Run(1, ops, [ops] {
+        why::Arena arena{};
+        why::ArenaResource resource(arena);
+        for (size_t i = 0; i < ops; i += kBatch) {
+            if (kArena) {
+                std::pmr::vector<uint64_t> vec(&resource);
+                for (size_t k = 0; k < kBatch; ++k) {
+                    vec.push_back(k);
+                }
+                arena.Reset();
+            } else {
+                std::vector<uint64_t> vec{};
+                for (size_t k = 0; k < kBatch; ++k) {
+                    vec.push_back(k);
+                }
+            }
+        }
+    });
+}
+
+static std::string Result(const char* scenario, const char* allocator, int threads, double mops) {
+    std::stringstream ss;
+    ss << "{\"scenario\": \"" << scenario << "\", \"allocator\": \"" << allocator << "\", \"threads\": " << threads
+       << ", \"mops\": " << mops << "}";
+    return ss.str();
+}
+
+int main(int argc, char** argv) {
+    size_t ops = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    std::stringstream ss;
+    ss << "{\"ops\": " << ops << ", \"hardware_concurrency\": " << std::thread::hardware_concurrency()
+       << ", \"results\": [";
+    size_t idx = 0;
+    auto add = [&ss, &idx](const std::string& result) {
+        ss << (idx++ ? ",\n  " : "\n  ") << result;
+    };
+    for (int threads : {1, 4}) {
+        add(Result("same_thread", "malloc", threads, SameThread<MallocAlloc>(threads, ops)));
+        add(Result("same_thread", "ObjectPool", threads, SameThread<PoolAlloc>(threads, ops)));
+    }
+    add(Result("cross_thread", "malloc", 2, CrossThread<MallocAlloc>(ops)));
+    add(Result("cross_thread", "ObjectPool", 2, CrossThread<PoolAlloc>(ops)));
+    add(Result("shared_ptr", "make_shared", 1, SharedPtr<false>(ops)));
+    add(Result("shared_ptr", "ObjectPool::MakeShared", 1, SharedPtr<true>(ops)));
+    add(Result("small_blocks", "malloc", 1, SmallBlocks<false>(ops)));
+    add(Result("small_blocks", "Arena", 1, SmallBlocks<true>(ops)));
+    add(Result("vector_build", "std::vector", 1, BuildVector<false>(ops)));
+    add(Result("vector_build", "pmr::vector+Arena", 1, BuildVector<true>(ops)));
+    ss << "\n]}";
+    std::cout << ss.str() << std::endl;
+    return 0;
+}
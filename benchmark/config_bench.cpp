@@ -0,0 +1,201 @@
+#include "config.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @description: 配置模块的性能与竞争压测,结果以 JSON 输出到标准输出
+ * @details 用法: config_bench [max_keys],max_keys 默认 100000
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedNs(Clock::time_point begin) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+}
+
+/**
+ * @description: 一个写线程持续 SetValue/LoadFromYaml 的同时,readers 个线程读取 GetValue
+ */
+static std::string BenchGetValue(int readers) {
+    static auto var = why::ConfigVarManager::LookUp("bench.contention.value", (int)0, "bench value");
+    YAML::Node node = YAML::Load("bench:\n    contention:\n        value: 1");
+
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+    uint64_t writes = 0;
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back([&] {
+            while (!start.load(std::memory_order_acquire)) {}
+            uint64_t count = 0;
+            int64_t sum = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                sum += var->GetValue();
+                ++count;
+            }
+            reads.fetch_add(count);
+            (void)sum;
+        });
+    }
+    std::thread writer([&] {
+        while (!start.load(std::memory_order_acquire)) {}
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (writes % 2) {
+                var->SetValue(static_cast<int>(writes));
+            } else {
+                why::ConfigVarManager::LoadFromYaml(node);
+            }
+            ++writes;
+        }
+    });
+
+    constexpr auto kDuration = std::chrono::milliseconds(200);
+    auto begin = Clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(kDuration);
+    stop.store(true);
+    for (auto &t : threads) {
+        t.join();
+    }
+    writer.join();
+    double sec = ElapsedNs(begin) / 1e9;
+
+    std::stringstream ss;
+    ss << "{\"readers\": " << readers
+       << ", \"reads_per_sec\": " << static_cast<uint64_t>(reads.load() / sec)
+       << ", \"writes_per_sec\": " << static_cast<uint64_t>(writes / sec) << "}";
+    return ss.str();
+}
+
+static std::string BenchLookUp() {
+    constexpr int kIterations = 1000000;
+    auto var = why::ConfigVarManager::LookUp("bench.lookup.value", (int)0, "bench lookup");
+    std::stringstream ss;
+    ss << "{";
+
+    auto begin = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        auto tmp = why::ConfigVarManager::LookUp("bench.lookup.value", (int)0, "bench lookup");
+        (void)tmp;
+    }
+    ss << "\"existing_string_ns\": " << ElapsedNs(begin) / kIterations;
+
+    begin = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        auto tmp = why::ConfigVarManager::LookUp(WHY_CONFIG_KEY("bench.lookup.value"), (int)0, "bench lookup");
+        (void)tmp;
+    }
+    ss << ", \"existing_key_ns\": " << ElapsedNs(begin) / kIterations;
+
+    const std::string missing = "bench.lookup.missing";
+    begin = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        auto tmp = why::ConfigVarManager::LookUpBase(missing);
+        (void)tmp;
+    }
+    ss << ", \"missing_string_ns\": " << ElapsedNs(begin) / kIterations;
+
+    begin = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        auto tmp = why::ConfigVarManager::LookUpBase(WHY_CONFIG_KEY("bench.lookup.missing"));
+        (void)tmp;
+    }
+    ss << ", \"missing_key_ns\": " << ElapsedNs(begin) / kIterations << "}";
+    return ss.str();
+}
+
+/**
+ * @description: 注册 keys 个配置变量(一半 vector<int>,一半 map<string, int>),测量加载 YAML 的耗时
+ */
+static std::string BenchLoad(size_t keys) {
+    const std::string prefix = "load" + std::to_string(keys);
+    YAML::Node root(YAML::NodeType::Map);
+    YAML::Node group(YAML::NodeType::Map);
+    for (size_t i = 0; i < keys; ++i) {
+        std::string name = "k" + std::to_string(i);
+        if (i % 2) {
+            why::ConfigVarManager::LookUp(prefix + "." + name, std::vector<int>{}, "bench vector");
+            YAML::Node vec(YAML::NodeType::Sequence);
+            for (int j = 0; j < 4; ++j) {
+                vec.push_back(static_cast<int>(i) + j);
+            }
+            group[name] = vec;
+        } else {
+            why::ConfigVarManager::LookUp(prefix + "." + name, std::map<std::string, int>{}, "bench map");
+            YAML::Node map(YAML::NodeType::Map);
+            map["a"] = static_cast<int>(i);
+            map["b"] = static_cast<int>(i) + 1;
+            group[name] = map;
+        }
+    }
+    root[prefix] = group;
+
+    auto begin = Clock::now();
+    why::ConfigVarManager::LoadFromYaml(root);
+    double ms = ElapsedNs(begin) / 1e6;
+
+    std::stringstream ss;
+    ss << "{\"keys\": " << keys << ", \"load_ms\": " << ms << "}";
+    return ss.str();
+}
+
+/**
+ * @description: 测量一个配置变量挂载 listeners 个监听者时 SetValue 的延迟
+ */
+static std::string BenchListener(size_t listeners) {
+    auto var = why::ConfigVarManager::LookUp("bench.listener.l" + std::to_string(listeners), (int)0, "bench listener");
+    std::atomic<uint64_t> calls{0};
+    for (size_t i = 0; i < listeners; ++i) {
+        var->AddListener([&calls](const int&, const int&) {
+            calls.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    constexpr int kIterations = 10000;
+    auto begin = Clock::now();
+    for (int i = 1; i <= kIterations; ++i) {
+        var->SetValue(i);
+    }
+    double ns = ElapsedNs(begin) / kIterations;
+    var->ClearListener();
+
+    std::stringstream ss;
+    ss << "{\"listeners\": " << listeners << ", \"set_value_ns\": " << ns
+       << ", \"per_listener_ns\": " << (listeners ? ns / listeners : 0) << "}";
+    return ss.str();
+}
+
+template<typename T, typename F>
+static void EmitArray(std::ostream& os, const std::vector<T>& args, F&& func) {
+    os << "[";
+    for (size_t i = 0; i < args.size(); ++i) {
+        os << (i ? ", " : "") << func(args[i]);
+    }
+    os << "]";
+}
+
+int main(int argc, char** argv) {
+    size_t max_keys = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    std::vector<size_t> keys{};
+    for (size_t k = 1000; k <= max_keys; k *= 10) {
+        keys.push_back(k);
+    }
+
+    std::stringstream ss;
+    ss << "{\n  \"get_value\": ";
+    EmitArray(ss, std::vector<int>{1, 2, 4, 8, 16, 32, 64}, BenchGetValue);
+    ss << ",\n  \"lookup\": " << BenchLookUp();
+    ss << ",\n  \"load\": ";
+    EmitArray(ss, keys, BenchLoad);
+    ss << ",\n  \"listener\": ";
+    EmitArray(ss, std::vector<size_t>{1, 10, 100, 1000}, BenchListener);
+    ss << "\n}";
+    std::cout << ss.str() << std::endl;
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "config.h"
+#include "config_source.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/**
+ * @description: 生成 groups 组机器生成风格的配置,每组包含标量、数组与嵌套 map
+ */
+static void GenerateConfig(size_t groups, std::string& json, std::string& yaml, std::string& properties) {
+    std::stringstream js, ys, ps;
+    js << "{\n";
+    for (size_t i = 0; i < groups; ++i) {
+        std::string name = "group" + std::to_string(i);
+        js << "  \"" << name << "\": {\"port\": " << 8000 + i << ", \"ratio\": " << i * 0.5
+           << ", \"name\": \"service_" << i << "\", \"hosts\": [\"10.0.0.1\", \"10.0.0.2\", \"10.0.0.3\"]"
+           << ", \"limits\": {\"qps\": " << i * 10 << ", \"burst\": " << i * 20 << "}}"
+           << (i + 1 == groups ? "\n" : ",\n");
+        ys << name << ":\n  port: " << 8000 + i << "\n  ratio: " << i * 0.5
+           << "\n  name: service_" << i << "\n  hosts: [10.0.0.1, 10.0.0.2, 10.0.0.3]"
+           << "\n  limits:\n    qps: " << i * 10 << "\n    burst: " << i * 20 << "\n";
+        ps << name << ".port=" << 8000 + i << "\n" << name << ".ratio=" << i * 0.5 << "\n"
+           << name << ".name=service_" << i << "\n" << name << ".hosts=[10.0.0.1, 10.0.0.2, 10.0.0.3]\n"
+           << name << ".limits.qps=" << i * 10 << "\n" << name << ".limits.burst=" << i * 20 << "\n";
+    }
+    js << "}\n";
+    json = js.str();
+    yaml = ys.str();
+    properties = ps.str();
+}
+
+static void Bench(const why::ConfigSource& source, const std::string& content, int iterations) {
+    size_t items = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        why::ConfigEntries entries{};
+        source.Parse(content, entries);
+        items = entries.items.size();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    double mb = static_cast<double>(content.size()) * iterations / (1024.0 * 1024.0);
+    std::cout << source.GetName() << ": size=" << content.size() << "B items=" << items
+              << " throughput=" << mb / sec << "MB/s" << std::endl;
+}
+
+int main() {
+    for (size_t groups : {1000, 10000}) {
+        std::string json, yaml, properties;
+        GenerateConfig(groups, json, yaml, properties);
+        int iterations = groups >= 10000 ? 3 : 20;
+        std::cout << "groups=" << groups << std::endl;
+        Bench(why::YamlConfigSource(), yaml, iterations);
+        Bench(why::JsonConfigSource(), json, iterations);
+        Bench(why::PropertiesConfigSource(), properties, iterations);
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "common.h"
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @description: 读多写少的注册表场景下 ConcurrentHashMap 的扩展性压测,结果以 JSON 输出到标准输出
+ * @details 用法: hash_map_bench [ops_per_thread],默认 1000000
+ *          kKeys 个字符串 key 预先插入,每个线程按 write_ratio 的比例做 InsertOrAssign,其余用 string_view 查找,
+ *          与 std::mutex / std::shared_mutex + std::unordered_map 比较
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t kKeys = 1024;
+
+/**
+ * @description: 对照组,接口与 ConcurrentHashMap 相同;std::unordered_map 在 C++17 不支持异构查找,需要构造临时字符串
+ */
+template<typename Mutex, typename ReadLock>
+class LockedMap {
+public:
+    bool Find(std::string_view key, uint64_t& val) const {
+        std::string str(key);
+        ReadLock lock(m_mutex);
+        auto iter = m_map.find(str);
+        if (iter == m_map.end()) {
+            return false;
+        }
+        val = iter->second;
+        return true;
+    }
+
+    void InsertOrAssign(std::string_view key, uint64_t val) {
+        std::string str(key);
+        std::lock_guard<Mutex> lock(m_mutex);
+        m_map[str] = val;
+    }
+
+private:
+    mutable Mutex m_mutex;
+    std::unordered_map<std::string, uint64_t> m_map;
+};
+
+class ShardedMap {
+public:
+    bool Find(std::string_view key, uint64_t& val) const {
+        return m_map.Visit(key, [&val](const uint64_t& item) { val = item; });
+    }
+
+    void InsertOrAssign(std::string_view key, uint64_t val) {
+        m_map.InsertOrAssign(std::string(key), val);
+    }
+
+private:
+    why::ConcurrentHashMap<std::string, uint64_t> m_map;
+};
+
+template<typename Map>
+static double Bench(const std::vector<std::string>& keys, int threads, size_t ops, double write_ratio) {
+    Map map{};
+    for (size_t i = 0; i < keys.size(); ++i) {
+        map.InsertOrAssign(keys[i], i);
+    }
+    size_t write_every = write_ratio > 0 ? static_cast<size_t>(1 / write_ratio) : 0;
+    std::vector<std::thread> workers{};
+    auto begin = Clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&map, &keys, t, ops, write_every] {
+            uint64_t sum = 0;
+            size_t idx = t * 131;
+            for (size_t i = 0; i < ops; ++i) {
+                idx = (idx + 7) % keys.size();
+                if (write_every && i % write_every == 0) {
+                    map.InsertOrAssign(keys[idx], i);
+                } else {
+                    uint64_t val = 0;
+                    map.Find(keys[idx], val);
+                    sum += val;
+                }
+            }
+            volatile uint64_t sink = sum;
+            (void)sink;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+    return threads * ops / sec / 1e6;
+}
+
+static std::string Result(const char* map, int threads, double write_ratio, double mops) {
+    std::stringstream ss;
+    ss << "{\"map\": \"" << map << "\", \"threads\": " << threads << ", \"write_ratio\": " << write_ratio
+       << ", \"mops\": " << mops << "}";
+    return ss.str();
+}
+
+int main(int argc, char** argv) {
+    size_t ops = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::vector<std::string> keys{};
+    for (size_t i = 0; i < kKeys; ++i) {
+        keys.push_back("system.module_" + std::to_string(i) + ".logger");
+    }
+    using MutexMap = LockedMap<std::mutex, std::lock_guard<std::mutex>>;
+    using SharedMutexMap = LockedMap<std::shared_mutex, std::shared_lock<std::shared_mutex>>;
+
+    std::stringstream ss;
+    ss << "{\"ops_per_thread\": " << ops << ", \"keys\": " << kKeys
+       << ", \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ", \"results\": [";
+    size_t idx = 0;
+    auto add = [&ss, &idx](const std::string& result) {
+        ss << (idx++ ? ",\n  " : "\n  ") << result;
+    };
+    for (double write_ratio : {0.0, 0.01, 0.1}) {
+        for (int threads : {1, 2, 4, 8}) {
+            add(Result("ConcurrentHashMap", threads, write_ratio, Bench<ShardedMap>(keys, threads, ops, write_ratio)));
+            add(Result("mutex+unordered_map", threads, write_ratio, Bench<MutexMap>(keys, threads, ops, write_ratio)));
+            add(Result("shared_mutex+unordered_map", threads, write_ratio,
+                       Bench<SharedMutexMap>(keys, threads, ops, write_ratio)));
+        }
+    }
+    ss << "\n]}";
+    std::cout << ss.str() << std::endl;
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "common.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @description: 大页与普通页的随机访问对比压测,结果以 JSON 输出到标准输出
+ * @details 用法: huge_page_bench [size_mb] [ops],size_mb 默认 256,ops 默认 20000000
+ *          在区域内按随机排列的 64 字节槽位做指针追逐,每次访问都依赖上一次的结果,TLB 未命中无法被乱序执行掩盖
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t kSlot = 64;
+
+static double Chase(const why::HugePageOptions& options, size_t size, size_t ops, const char** backing) {
+    why::HugePageRegion region(size, options);
+    *backing = why::HugePageRegion::BackingToString(region.GetBacking());
+    size_t slots = region.GetSize() / kSlot;
+    auto base = static_cast<char*>(region.GetData());
+    // 用固定种子的 xorshift 打乱槽位,把所有槽位串成一个环
+    std::vector<uint32_t> order(slots);
+    for (size_t i = 0; i < slots; ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    uint64_t seed = 88172645463325252ull;
+    for (size_t i = slots - 1; i > 0; --i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        std::swap(order[i], order[seed % (i + 1)]);
+    }
+    for (size_t i = 0; i < slots; ++i) {
+        *reinterpret_cast<void**>(base + order[i] * kSlot) = base + order[(i + 1) % slots] * kSlot;
+    }
+
+    void* ptr = base + order[0] * kSlot;
+    auto begin = Clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        ptr = *static_cast<void**>(ptr);
+    }
+    double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+    // 防止循环被优化掉
+    if (ptr == nullptr) {
+        std::cerr << "unreachable" << std::endl;
+    }
+    return sec * 1e9 / ops;
+}
+
+static std::string Result(const char* mode, const char* backing, double ns) {
+    std::stringstream ss;
+    ss << "{\"mode\": \"" << mode << "\", \"backing\": \"" << backing << "\", \"ns_per_access\": " << ns << "}";
+    return ss.str();
+}
+
+int main(int argc, char** argv) {
+    size_t size = (argc > 1 ? std::stoul(argv[1]) : 256) << 20;
+    size_t ops = argc > 2 ? std::stoul(argv[2]) : 20000000;
+    std::stringstream ss;
+    ss << "{\"size\": " << size << ", \"ops\": " << ops << ", \"huge_page_size\": "
+       << why::HugePageRegion::GetHugePageSize() << ", \"results\": [";
+
+    const char* backing = nullptr;
+    why::HugePageOptions normal{};
+    normal.hugetlb = false;
+    normal.transparent = false;
+    normal.prefault = true;
+    double ns = Chase(normal, size, ops, &backing);
+    ss << "\n  " << Result("normal", backing, ns);
+
+    why::HugePageOptions huge{};
+    huge.prefault = true;
+    ns = Chase(huge, size, ops, &backing);
+    ss << ",\n  " << Result("huge", backing, ns);
+    ss << "\n]}";
+    std::cout << ss.str() << std::endl;
+    return 0;
+}
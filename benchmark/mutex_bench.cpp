@@ -0,0 +1,267 @@
+#include "common.h"
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <pthread.h>
+#include <semaphore.h>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/**
+ * @description: 比较 futex 同步原语与 std/POSIX 对应实现在竞争下的开销,结果以 JSON 输出到标准输出
+ * @details mutex: 每个线程反复加锁并递增一个计数器(很短的临界区),why::Mutex / std::mutex / pthread_spinlock_t
+ *          rwlock: 99% 读 1% 写,why::RWMutex / std::shared_mutex / pthread_rwlock_t
+ *          semaphore: 两个线程通过一对信号量乒乓,why::Semaphore / sem_t
+ *          event: 两个线程通过一对事件乒乓,why::Event / std::mutex + std::condition_variable
+ *          latch: 每轮所有线程在一个新的 latch 上汇合,why::Latch / std::mutex + std::condition_variable
+ *          barrier: 所有线程反复在同一个屏障上汇合,why::Barrier / pthread_barrier_t
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int kLockOps = 200000;
+static constexpr int kPingPongs = 50000;
+static constexpr int kRounds = 5000;
+
+template<typename Func>
+static double RunThreads(int num, Func&& func) {
+    std::vector<std::thread> threads{};
+    auto begin = Clock::now();
+    for (int i = 0; i < num; ++i) {
+        threads.emplace_back(func, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+}
+
+class SpinLock {
+public:
+    SpinLock() { pthread_spin_init(&m_lock, PTHREAD_PROCESS_PRIVATE); }
+    ~SpinLock() { pthread_spin_destroy(&m_lock); }
+    void lock() { pthread_spin_lock(&m_lock); }
+    void unlock() { pthread_spin_unlock(&m_lock); }
+
+private:
+    pthread_spinlock_t m_lock;
+};
+
+class PosixRWLock {
+public:
+    PosixRWLock() { pthread_rwlock_init(&m_lock, nullptr); }
+    ~PosixRWLock() { pthread_rwlock_destroy(&m_lock); }
+    void lock() { pthread_rwlock_wrlock(&m_lock); }
+    void unlock() { pthread_rwlock_unlock(&m_lock); }
+    void lock_shared() { pthread_rwlock_rdlock(&m_lock); }
+    void unlock_shared() { pthread_rwlock_unlock(&m_lock); }
+
+private:
+    pthread_rwlock_t m_lock;
+};
+
+class CondVarEvent {
+public:
+    void Set() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_set = true;
+        m_cv.notify_all();
+    }
+    void Reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_set = false;
+    }
+    void Wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_set; });
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_set{false};
+};
+
+class CondVarLatch {
+public:
+    explicit CondVarLatch(uint32_t count) : m_count(count) {}
+    void ArriveAndWait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (--m_count == 0) {
+            m_cv.notify_all();
+            return;
+        }
+        m_cv.wait(lock, [this] { return m_count == 0; });
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    uint32_t m_count;
+};
+
+class PosixBarrier {
+public:
+    explicit PosixBarrier(uint32_t count) { pthread_barrier_init(&m_barrier, nullptr, count); }
+    ~PosixBarrier() { pthread_barrier_destroy(&m_barrier); }
+    void ArriveAndWait() { pthread_barrier_wait(&m_barrier); }
+
+private:
+    pthread_barrier_t m_barrier;
+};
+
+class PosixSemaphore {
+public:
+    PosixSemaphore() { sem_init(&m_sem, 0, 0); }
+    ~PosixSemaphore() { sem_destroy(&m_sem); }
+    void Wait() { sem_wait(&m_sem); }
+    void Post() { sem_post(&m_sem); }
+
+private:
+    sem_t m_sem;
+};
+
+template<typename Lock>
+static double BenchLock(int threads) {
+    Lock lock;
+    uint64_t counter = 0;
+    double ns = RunThreads(threads, [&](int) {
+        for (int i = 0; i < kLockOps; ++i) {
+            std::lock_guard<Lock> guard(lock);
+            ++counter;
+        }
+    });
+    return ns / (static_cast<double>(kLockOps) * threads);
+}
+
+template<typename Lock>
+static double BenchRWLock(int threads) {
+    Lock lock;
+    uint64_t data[8] = {};
+    double ns = RunThreads(threads, [&](int idx) {
+        uint64_t sum = 0;
+        for (int i = 0; i < kLockOps; ++i) {
+            if ((i + idx) % 100 == 0) {
+                std::unique_lock<Lock> guard(lock);
+                ++data[i % 8];
+            } else {
+                std::shared_lock<Lock> guard(lock);
+                sum += data[i % 8];
+            }
+        }
+        volatile uint64_t sink = sum;
+        (void)sink;
+    });
+    return ns / (static_cast<double>(kLockOps) * threads);
+}
+
+template<typename Sem>
+static double BenchSemaphore() {
+    Sem ping;
+    Sem pong;
+    double ns = RunThreads(2, [&](int idx) {
+        for (int i = 0; i < kPingPongs; ++i) {
+            if (idx == 0) {
+                ping.Post();
+                pong.Wait();
+            } else {
+                ping.Wait();
+                pong.Post();
+            }
+        }
+    });
+    return ns / kPingPongs;
+}
+
+template<typename Ev>
+static double BenchEvent() {
+    Ev ping;
+    Ev pong;
+    double ns = RunThreads(2, [&](int idx) {
+        for (int i = 0; i < kPingPongs; ++i) {
+            // 等待者自己复位,对方下一次 Set 之前一定已经复位
+            if (idx == 0) {
+                ping.Set();
+                pong.Wait();
+                pong.Reset();
+            } else {
+                ping.Wait();
+                ping.Reset();
+                pong.Set();
+            }
+        }
+    });
+    return ns / kPingPongs;
+}
+
+template<typename Latch>
+static double BenchLatch(int threads) {
+    std::vector<std::unique_ptr<Latch>> latches{};
+    for (int i = 0; i < kRounds; ++i) {
+        latches.emplace_back(new Latch(threads));
+    }
+    double ns = RunThreads(threads, [&](int) {
+        for (int i = 0; i < kRounds; ++i) {
+            latches[i]->ArriveAndWait();
+        }
+    });
+    return ns / kRounds;
+}
+
+template<typename Barrier>
+static double BenchBarrier(int threads) {
+    Barrier barrier(threads);
+    double ns = RunThreads(threads, [&](int) {
+        for (int i = 0; i < kRounds; ++i) {
+            barrier.ArriveAndWait();
+        }
+    });
+    return ns / kRounds;
+}
+
+static std::string Result(const std::string& name, int threads, double ns) {
+    std::stringstream ss;
+    ss << "{\"impl\": \"" << name << "\", \"threads\": " << threads << ", \"ns_per_op\": " << ns << "}";
+    return ss.str();
+}
+
+int main() {
+    const std::vector<int> thread_nums{1, 2, 4, 8};
+    std::stringstream ss;
+    ss << "{\n  \"mutex\": [";
+    size_t idx = 0;
+    for (int threads : thread_nums) {
+        ss << (idx++ ? ",\n    " : "\n    ") << Result("why::Mutex", threads, BenchLock<why::Mutex>(threads))
+           << ",\n    " << Result("std::mutex", threads, BenchLock<std::mutex>(threads))
+           << ",\n    " << Result("pthread_spinlock", threads, BenchLock<SpinLock>(threads));
+    }
+    ss << "\n  ],\n  \"rwlock\": [";
+    idx = 0;
+    for (int threads : thread_nums) {
+        ss << (idx++ ? ",\n    " : "\n    ") << Result("why::RWMutex", threads, BenchRWLock<why::RWMutex>(threads))
+           << ",\n    " << Result("std::shared_mutex", threads, BenchRWLock<std::shared_mutex>(threads))
+           << ",\n    " << Result("pthread_rwlock", threads, BenchRWLock<PosixRWLock>(threads));
+    }
+    ss << "\n  ],\n  \"semaphore\": [\n    " << Result("why::Semaphore", 2, BenchSemaphore<why::Semaphore>())
+       << ",\n    " << Result("sem_t", 2, BenchSemaphore<PosixSemaphore>())
+       << "\n  ],\n  \"event\": [\n    " << Result("why::Event", 2, BenchEvent<why::Event>())
+       << ",\n    " << Result("condition_variable", 2, BenchEvent<CondVarEvent>())
+       << "\n  ],\n  \"latch\": [";
+    idx = 0;
+    for (int threads : thread_nums) {
+        ss << (idx++ ? ",\n    " : "\n    ") << Result("why::Latch", threads, BenchLatch<why::Latch>(threads))
+           << ",\n    " << Result("condition_variable", threads, BenchLatch<CondVarLatch>(threads));
+    }
+    ss << "\n  ],\n  \"barrier\": [";
+    idx = 0;
+    for (int threads : thread_nums) {
+        ss << (idx++ ? ",\n    " : "\n    ") << Result("why::Barrier", threads, BenchBarrier<why::Barrier>(threads))
+           << ",\n    " << Result("pthread_barrier", threads, BenchBarrier<PosixBarrier>(threads));
+    }
+    ss << "\n  ]\n}";
+    std::cout << ss.str() << std::endl;
+    return 0;
+}
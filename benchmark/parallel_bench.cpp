@@ -0,0 +1,91 @@
+#include "common.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @description: 比较 parallel_* 算法与串行 std:: 算法的耗时,结果以 JSON 输出到标准输出
+ * @details 用法: parallel_bench [threads],threads 默认为硬件线程数
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int kRepeat = 5;
+
+/**
+ * @description: 执行 kRepeat 次 func,返回最短耗时(毫秒),prepare 在每次计时前执行
+ */
+template<typename Prepare, typename F>
+static double MinMs(Prepare&& prepare, F&& func) {
+    double best = 1e100;
+    for (int i = 0; i < kRepeat; ++i) {
+        prepare();
+        auto begin = Clock::now();
+        func();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+    }
+    return best;
+}
+
+static std::string Bench(why::ThreadPool& pool, size_t n) {
+    std::vector<double> src(n);
+    std::mt19937_64 rng(n);
+    std::uniform_real_distribution<double> dist(0, 1000);
+    for (auto &v : src) {
+        v = dist(rng);
+    }
+    std::vector<double> dst(n);
+    std::vector<double> data{};
+    auto nop = [] {};
+    auto copy = [&] { data = src; };
+    auto work = [](double v) { return std::sqrt(v) * std::sin(v); };
+    volatile double sink = 0;
+
+    std::stringstream ss;
+    ss << "{\"n\": " << n;
+    auto emit = [&ss](const char* name, double serial, double parallel) {
+        ss << ", \"" << name << "\": {\"std_ms\": " << serial << ", \"parallel_ms\": " << parallel
+           << ", \"speedup\": " << serial / parallel << "}";
+    };
+
+    emit("for",
+         MinMs(nop, [&] { for (size_t i = 0; i < n; ++i) { dst[i] = work(src[i]); } }),
+         MinMs(nop, [&] { why::parallel_for(pool, size_t(0), n, [&](size_t i) { dst[i] = work(src[i]); }); }));
+    emit("reduce",
+         MinMs(nop, [&] { sink = std::accumulate(src.begin(), src.end(), 0.0); }),
+         MinMs(nop, [&] { sink = why::parallel_reduce(pool, src.begin(), src.end(), 0.0); }));
+    emit("transform",
+         MinMs(nop, [&] { std::transform(src.begin(), src.end(), dst.begin(), work); }),
+         MinMs(nop, [&] { why::parallel_transform(pool, src.begin(), src.end(), dst.begin(), work); }));
+    emit("sort",
+         MinMs(copy, [&] { std::sort(data.begin(), data.end()); }),
+         MinMs(copy, [&] { why::parallel_sort(pool, data.begin(), data.end()); }));
+    emit("scan",
+         MinMs(nop, [&] { std::partial_sum(src.begin(), src.end(), dst.begin()); }),
+         MinMs(nop, [&] { why::parallel_scan(pool, src.begin(), src.end(), dst.begin()); }));
+    (void)sink;
+    ss << "}";
+    return ss.str();
+}
+
+int main(int argc, char** argv) {
+    int threads = argc > 1 ? std::stoi(argv[1]) : 0;
+    why::ThreadPool pool(threads, why::ThreadPool::Mode::WORK_STEALING);
+    pool.Start();
+
+    std::stringstream ss;
+    ss << "{\n  \"threads\": " << pool.GetThreadNum() << ",\n  \"results\": [";
+    size_t idx = 0;
+    for (size_t n : {size_t(10000), size_t(100000), size_t(1000000), size_t(10000000)}) {
+        ss << (idx++ ? ",\n    " : "\n    ") << Bench(pool, n);
+    }
+    ss << "\n  ]\n}";
+    std::cout << ss.str() << std::endl;
+    pool.Shutdown();
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "common.h"
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/**
+ * @description: 有界无锁队列的吞吐压测,结果以 JSON 输出到标准输出
+ * @details 用法: queue_bench [items],items 默认 2000000
+ *          每种队列在 1p1c / 4p1c / 4p4c 下传递 items 个 uint64_t,batch 为每次批量入队/出队的个数,
+ *          与 std::mutex + std::deque 的有界队列比较;操作失败时让出 CPU,避免线程数超过核数时空转
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t kCapacity = 4096;
+
+/**
+ * @description: 对照组,接口与无锁队列相同
+ */
+class MutexQueue {
+public:
+    explicit MutexQueue(size_t capacity) : m_capacity(capacity) {}
+
+    bool TryPush(uint64_t item) {
+        return TryPushBatch(&item, 1) == 1;
+    }
+
+    size_t TryPushBatch(uint64_t* items, size_t n) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        n = std::min(n, m_capacity - m_items.size());
+        m_items.insert(m_items.end(), items, items + n);
+        return n;
+    }
+
+    size_t TryPopBatch(uint64_t* items, size_t n) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        n = std::min(n, m_items.size());
+        std::copy(m_items.begin(), m_items.begin() + n, items);
+        m_items.erase(m_items.begin(), m_items.begin() + n);
+        return n;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<uint64_t> m_items;
+    size_t m_capacity;
+};
+
+template<typename Queue>
+static double Bench(size_t items, int producers, int consumers, size_t batch) {
+    Queue queue(kCapacity);
+    size_t per_producer = items / producers;
+    size_t total = per_producer * producers;
+    std::atomic<size_t> popped{0};
+    std::vector<std::thread> threads{};
+    auto begin = Clock::now();
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, per_producer, batch] {
+            std::vector<uint64_t> buffer(batch);
+            size_t sent = 0;
+            while (sent < per_producer) {
+                size_t n = std::min(batch, per_producer - sent);
+                for (size_t i = 0; i < n; ++i) {
+                    buffer[i] = sent + i;
+                }
+                size_t pushed = batch == 1 ? queue.TryPush(buffer[0]) : queue.TryPushBatch(buffer.data(), n);
+                sent += pushed;
+                if (!pushed) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&queue, &popped, total, batch] {
+            std::vector<uint64_t> buffer(batch);
+            uint64_t sum = 0;
+            while (popped.load(std::memory_order_relaxed) < total) {
+                size_t n = queue.TryPopBatch(buffer.data(), batch);
+                if (!n) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    sum += buffer[i];
+                }
+                popped.fetch_add(n, std::memory_order_relaxed);
+            }
+            volatile uint64_t sink = sum;
+            (void)sink;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double sec = std::chrono::duration<double>(Clock::now() - begin).count();
+    return total / sec / 1e6;
+}
+
+static std::string Result(const char* queue, int producers, int consumers, size_t batch, double mops) {
+    std::stringstream ss;
+    ss << "{\"queue\": \"" << queue << "\", \"producers\": " << producers << ", \"consumers\": " << consumers
+       << ", \"batch\": " << batch << ", \"mops\": " << mops << "}";
+    return ss.str();
+}
+
+int main(int argc, char** argv) {
+    size_t items = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    std::stringstream ss;
+    ss << "{\"items\": " << items << ", \"results\": [";
+    size_t idx = 0;
+    auto add = [&ss, &idx](const std::string& result) {
+        ss << (idx++ ? ",\n  " : "\n  ") << result;
+    };
+    for (size_t batch : {1, 32}) {
+        add(Result("SpscQueue", 1, 1, batch, Bench<why::SpscQueue<uint64_t>>(items, 1, 1, batch)));
+        add(Result("MpscQueue", 1, 1, batch, Bench<why::MpscQueue<uint64_t>>(items, 1, 1, batch)));
+        add(Result("MpmcQueue", 1, 1, batch, Bench<why::MpmcQueue<uint64_t>>(items, 1, 1, batch)));
+        add(Result("mutex+deque", 1, 1, batch, Bench<MutexQueue>(items, 1, 1, batch)));
+        add(Result("MpscQueue", 4, 1, batch, Bench<why::MpscQueue<uint64_t>>(items, 4, 1, batch)));
+        add(Result("MpmcQueue", 4, 1, batch, Bench<why::MpmcQueue<uint64_t>>(items, 4, 1, batch)));
+        add(Result("mutex+deque", 4, 1, batch, Bench<MutexQueue>(items, 4, 1, batch)));
+        add(Result("MpmcQueue", 4, 4, batch, Bench<why::MpmcQueue<uint64_t>>(items, 4, 4, batch)));
+        add(Result("mutex+deque", 4, 4, batch, Bench<MutexQueue>(items, 4, 4, batch)));
+    }
+    ss << "\n]}";
+    std::cout << ss.str() << std::endl;
+    return 0;
+}
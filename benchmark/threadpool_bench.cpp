@@ -0,0 +1,82 @@
+#include "common.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+/**
+ * @description: 比较 SHARED 与 WORK_STEALING 两种模式在细粒度任务下的吞吐
+ * @details flat: 外部线程通过 execute/post 提交大量空任务
+ *          tree: 任务在工作线程内递归派生两个子任务,形成深度为 kDepth 的二叉任务树
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int kFlatTasks = 200000;
+static constexpr int kDepth = 16;
+
+static void WaitFor(const std::atomic<int>& counter, int target) {
+    while (counter.load(std::memory_order_acquire) < target) {
+        std::this_thread::yield();
+    }
+}
+
+static void Spawn(why::ThreadPool& pool, std::atomic<int>& leaves, int depth) {
+    if (depth == 0) {
+        leaves.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    for (int i = 0; i < 2; ++i) {
+        pool.post([&pool, &leaves, depth] {
+            Spawn(pool, leaves, depth - 1);
+        });
+    }
+}
+
+static void Bench(why::ThreadPool::Mode mode, const char* name, int threads) {
+    why::ThreadPool pool(threads, mode);
+    pool.Start();
+
+    std::atomic<int> counter{0};
+    auto begin = Clock::now();
+    for (int i = 0; i < kFlatTasks; ++i) {
+        pool.execute([&counter] {
+            counter.fetch_add(1, std::memory_order_release);
+        });
+    }
+    WaitFor(counter, kFlatTasks);
+    double flat_execute = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    counter = 0;
+    begin = Clock::now();
+    for (int i = 0; i < kFlatTasks; ++i) {
+        pool.post([&counter] {
+            counter.fetch_add(1, std::memory_order_release);
+        });
+    }
+    WaitFor(counter, kFlatTasks);
+    double flat = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::atomic<int> leaves{0};
+    begin = Clock::now();
+    pool.post([&pool, &leaves] {
+        Spawn(pool, leaves, kDepth);
+    });
+    WaitFor(leaves, 1 << kDepth);
+    double tree = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::cout << name << " threads=" << threads
+              << " flat_execute=" << static_cast<uint64_t>(kFlatTasks / flat_execute) << " tasks/s"
+              << " flat_post=" << static_cast<uint64_t>(kFlatTasks / flat) << " tasks/s"
+              << " tree=" << static_cast<uint64_t>(((2 << kDepth) - 1) / tree) << " tasks/s" << std::endl;
+    pool.Shutdown();
+}
+
+int main() {
+    int hw = std::max(1u, std::thread::hardware_concurrency());
+    for (int threads : {1, 4, hw}) {
+        Bench(why::ThreadPool::Mode::SHARED, "shared", threads);
+        Bench(why::ThreadPool::Mode::WORK_STEALING, "work_stealing", threads);
+    }
+    return 0;
+}
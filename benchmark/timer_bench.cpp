@@ -0,0 +1,137 @@
+#include "common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/**
+ * @description: 定时器压测,结果以 JSON 输出到标准输出
+ * @details 用法: timer_bench [timers],timers 默认 1000000
+ *          insert: 插入 timers 个分布在未来 10 分钟内的定时器(模拟连接超时),测量插入耗时
+ *          fire: 插入 timers / 10 个分布在未来 1 秒内的定时器,测量触发延迟分布
+ *          coalesce: 500 个 20ms 周期的低优先级定时器运行 1 秒,比较不同时钟源与 slack 下的唤醒频率
+ *          precise: 每 500us 一个定时器(模拟发包节奏控制)运行 1 秒,比较普通模式与高精度模式的触发抖动
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static std::string BenchInsert(size_t timers) {
+    auto timer = std::make_shared<why::Timer::TimerQueue>(2);
+    std::mt19937_64 rng(1);
+    auto now = Clock::now();
+    auto begin = Clock::now();
+    for (size_t i = 0; i < timers; ++i) {
+        timer->AddTaskAtTimePoint(now + std::chrono::milliseconds(1000 + rng() % 600000), [] {});
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / timers;
+
+    std::stringstream ss;
+    ss << "{\"timers\": " << timers << ", \"insert_ns\": " << ns
+       << ", \"pending\": " << timer->GetPendingCount() << "}";
+    return ss.str();
+}
+
+static std::string BenchFire(size_t timers) {
+    auto timer = std::make_shared<why::Timer::TimerQueue>(2);
+    timer->Start();
+    std::vector<int64_t> lateness(timers);
+    std::atomic<size_t> fired{0};
+    std::mt19937_64 rng(2);
+    auto now = Clock::now();
+    for (size_t i = 0; i < timers; ++i) {
+        auto tp = now + std::chrono::microseconds(rng() % 1000000);
+        timer->AddTaskAtTimePoint(tp, [tp, i, &lateness, &fired] {
+            lateness[i] = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - tp).count();
+            fired.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    timer->Shutdown();
+    std::sort(lateness.begin(), lateness.end());
+
+    std::stringstream ss;
+    ss << "{\"timers\": " << timers << ", \"fired\": " << fired.load()
+       << ", \"lateness_us\": {\"p50\": " << lateness[timers / 2]
+       << ", \"p99\": " << lateness[timers * 99 / 100]
+       << ", \"max\": " << lateness.back() << "}}";
+    return ss.str();
+}
+
+static std::string BenchCoalesce(why::Timer::ClockSource clock, std::chrono::milliseconds slack) {
+    why::Timer::TimerQueue::Options options{};
+    options.pool_size = 2;
+    options.clock = clock;
+    options.default_slack = slack;
+    auto timer = std::make_shared<why::Timer::TimerQueue>(options);
+    timer->Start();
+    std::mt19937_64 rng(3);
+    for (int i = 0; i < 500; ++i) {
+        // 周期略有不同,触发时间逐渐错开
+        timer->AddPeriodicTask(std::chrono::milliseconds(20) + std::chrono::microseconds(rng() % 1000),
+                               why::Timer::RepeatMode::FIXED_RATE, [] {});
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    timer->Shutdown();
+    auto stats = timer->GetStats();
+
+    std::stringstream ss;
+    ss << "{\"clock\": \"" << (clock == why::Timer::ClockSource::TIMERFD ? "timerfd" : "condvar")
+       << "\", \"slack_ms\": " << slack.count()
+       << ", \"wakeups_per_sec\": " << static_cast<uint64_t>(stats.wakeups_per_sec)
+       << ", \"fired\": " << stats.fired
+       << ", \"lateness_p50_us\": " << stats.lateness_p50_ns / 1000
+       << ", \"lateness_p99_us\": " << stats.lateness_p99_ns / 1000 << "}";
+    return ss.str();
+}
+
+static std::string BenchPrecise(why::Timer::ClockSource clock, std::chrono::microseconds guard) {
+    why::Timer::TimerQueue::Options options{};
+    options.pool_size = 1;
+    options.clock = clock;
+    options.tick = std::chrono::microseconds(1);
+    options.spin_guard = guard;
+    auto timer = std::make_shared<why::Timer::TimerQueue>(options);
+    timer->Start();
+    auto now = Clock::now();
+    for (int i = 0; i < 2000; ++i) {
+        timer->AddTaskAtTimePoint(now + std::chrono::microseconds(1000 + i * 500), [] {});
+    }
+    timer->Shutdown();
+    auto stats = timer->GetStats();
+
+    std::stringstream ss;
+    ss << "{\"clock\": \"" << (clock == why::Timer::ClockSource::PRECISE ? "precise" : "condvar")
+       << "\", \"guard_us\": " << guard.count()
+       << ", \"fired\": " << stats.fired
+       << ", \"jitter_ns\": {\"p50\": " << stats.lateness_p50_ns
+       << ", \"p99\": " << stats.lateness_p99_ns
+       << ", \"p999\": " << stats.lateness_p999_ns
+       << ", \"max\": " << stats.lateness_max_ns
+       << "}, \"spin_sec\": " << stats.spin_sec
+       << ", \"late_wakeups\": " << stats.late_wakeups << "}";
+    return ss.str();
+}
+
+int main(int argc, char** argv) {
+    size_t timers = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::stringstream ss;
+    ss << "{\n  \"insert\": " << BenchInsert(timers)
+       << ",\n  \"fire\": " << BenchFire(std::max<size_t>(timers / 10, 1))
+       << ",\n  \"coalesce\": [";
+    size_t idx = 0;
+    for (auto clock : {why::Timer::ClockSource::CONDVAR, why::Timer::ClockSource::TIMERFD}) {
+        for (auto slack : {std::chrono::milliseconds(0), std::chrono::milliseconds(5), std::chrono::milliseconds(20)}) {
+            ss << (idx++ ? ",\n    " : "\n    ") << BenchCoalesce(clock, slack);
+        }
+    }
+    ss << "\n  ],\n  \"precise\": [\n    " << BenchPrecise(why::Timer::ClockSource::CONDVAR, std::chrono::microseconds(0));
+    for (auto guard : {std::chrono::microseconds(50), std::chrono::microseconds(200)}) {
+        ss << ",\n    " << BenchPrecise(why::Timer::ClockSource::PRECISE, guard);
+    }
+    ss << "\n  ]\n}";
+    std::cout << ss.str() << std::endl;
+    return 0;
+}
@@ -21,5 +21,19 @@
 #include "common/struct.h"
 #include "common/thread.h"
 #include "common/mutex.h"
+#include "common/work_stealing_deque.h"
+#include "common/unique_task.h"
+#include "common/ring_buffer.h"
+#include "common/future.h"
+#include "common/parallel.h"
+#include "common/histogram.h"
+#include "common/strand.h"
+#include "common/thread_stats.h"
+#include "common/lock_profiler.h"
+#include "common/concurrent_queue.h"
+#include "common/concurrent_hash_map.h"
+#include "common/huge_page.h"
+#include "common/object_pool.h"
+#include "common/arena.h"
 
 #endif
\ No newline at end of file
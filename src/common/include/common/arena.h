@@ -0,0 +1,163 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 22:30:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 22:30:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/arena.h
+ * @Description: 指针碰撞分配的内存区域,以及 std::pmr::memory_resource 适配
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_ARENA_H__
+#define __WHY_ARENA_H__
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+#include "noncopyable.h"
+
+namespace why {
+
+/**
+ * @description: 非线程安全的 bump 分配器,单个对象不能释放,Reset 时整体回收
+ * @details 内存按块向系统申请,块大小从 chunk_size 开始翻倍增长到 kMaxChunkSize;
+ *          超过当前块大小 1/4 的分配单独申请一块,不打断当前块的分配;
+ *          Reset 保留当前块,之后同样规模的使用不再申请内存;
+ *          Create 创建的非平凡析构对象在 Reset/Release/析构时按创建的逆序析构
+ */
+class Arena : public Noncopyable {
+public:
+    static constexpr size_t kDefaultChunkSize = 4096;
+    static constexpr size_t kMaxChunkSize = 1 << 20;
+
+    explicit Arena(size_t chunk_size = kDefaultChunkSize);
+
+    /**
+     * @description: 先从调用者提供的 buffer(如栈上数组)分配,用完后才向系统申请,buffer 不归 Arena 释放
+     */
+    Arena(void* buffer, size_t size, size_t chunk_size = kDefaultChunkSize);
+
+    ~Arena();
+
+    void* Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        uintptr_t ptr = (m_ptr + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+        // 同时排除了对齐或加上 size 后回绕的情况;size 为 0 时走慢路径
+        if (ptr + size <= m_end && ptr + size > m_ptr) {
+            m_ptr = ptr + size;
+            m_used += size;
+            return reinterpret_cast<void*>(ptr);
+        }
+        return AllocateSlow(size, align);
+    }
+
+    /**
+     * @description: 分配 n 个未初始化的 T
+     */
+    template<typename T>
+    T* AllocateArray(size_t n) {
+        return static_cast<T*>(Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    template<typename T, typename ...Args>
+    T* Create(Args&& ...args) {
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        } else {
+            // 先登记再构造,构造抛异常时登记项的 obj 为空,不会被析构
+            auto cleanup = static_cast<Cleanup*>(Allocate(sizeof(Cleanup), alignof(Cleanup)));
+            cleanup->obj = nullptr;
+            cleanup->destroy = [](void* obj) { static_cast<T*>(obj)->~T(); };
+            cleanup->next = m_cleanups;
+            m_cleanups = cleanup;
+            T* obj = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            cleanup->obj = obj;
+            return obj;
+        }
+    }
+
+    /**
+     * @description: 析构 Create 的对象并回收所有分配,保留当前块供之后复用
+     */
+    void Reset();
+
+    /**
+     * @description: 析构 Create 的对象并把所有块还给系统
+     */
+    void Release();
+
+    /**
+     * @description: 已分配给调用者的字节数,不含对齐填充
+     */
+    size_t GetUsed() const { return m_used; }
+
+    /**
+     * @description: 向系统申请的字节数,不含调用者提供的 buffer
+     */
+    size_t GetCapacity() const { return m_capacity; }
+
+private:
+    struct Chunk {
+        Chunk* prev;
+        size_t size;
+    };
+
+    struct Cleanup {
+        Cleanup* next;
+        void (*destroy)(void*);
+        void* obj;
+    };
+
+    void* AllocateSlow(size_t size, size_t align);
+
+    Chunk* NewChunk(size_t size);
+
+    void RunCleanups();
+
+    void FreeChunks(Chunk* keep);
+
+    static uintptr_t ChunkBegin(Chunk* chunk) { return reinterpret_cast<uintptr_t>(chunk + 1); }
+
+private:
+    uintptr_t m_ptr{0};
+    uintptr_t m_end{0};
+    // 当前块,它之前的块通过 prev 串起来,单独申请的大块插在当前块之后
+    Chunk* m_chunks{nullptr};
+    Cleanup* m_cleanups{nullptr};
+    void* m_buffer{nullptr};
+    size_t m_bufferSize{0};
+    size_t m_chunkSize;
+    size_t m_nextChunkSize;
+    size_t m_used{0};
+    size_t m_capacity{0};
+};
+
+/**
+ * @description: 把 Arena 适配为 std::pmr::memory_resource,供 std::pmr 容器使用
+ * @details deallocate 不做任何事,内存在 Arena Reset 时统一回收;和 Arena 一样不是线程安全的
+ */
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaResource(Arena& arena) : m_arena(arena) {}
+
+    Arena& GetArena() const { return m_arena; }
+
+private:
+    void* do_allocate(size_t bytes, size_t align) override { return m_arena.Allocate(bytes, align); }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        auto rhs = dynamic_cast<const ArenaResource*>(&other);
+        return rhs && &rhs->m_arena == &m_arena;
+    }
+
+private:
+    Arena& m_arena;
+};
+
+}
+
+#endif
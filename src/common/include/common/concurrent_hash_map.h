@@ -0,0 +1,402 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 22:00:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 22:00:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/concurrent_hash_map.h
+ * @Description: 分片的并发哈希表,用于读多写少的注册表
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_CONCURRENT_HASH_MAP_H__
+#define __WHY_CONCURRENT_HASH_MAP_H__
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <stdint.h>
+#include "mutex.h"
+#include "noncopyable.h"
+
+namespace why {
+
+namespace detail {
+
+/**
+ * @description: ConcurrentHashMap 默认的哈希函数,std::string 做 key 时可以用 std::string_view/const char* 查找,不构造临时字符串
+ */
+template<typename K>
+struct MapHash : std::hash<K> {};
+
+template<>
+struct MapHash<std::string> {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+};
+
+/**
+ * @description: 对哈希值再做一次混合,整数的 std::hash 是恒等映射,直接取低位和高位分布很差
+ */
+inline uint64_t MixHash(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+}
+
+/**
+ * @description: 锁分片 + 开放寻址的并发哈希表
+ * @details 哈希值的高 8 位选择分片,每个分片有一把 RWMutex 和一张线性探测的平坦表,查找只加读锁;
+ *          每个槽位有一个字节的控制位(空/墓碑/已占用 + 7 位哈希标签),探测时先比较标签,命中后才比较 key,
+ *          控制字节连续存放,一次探测通常只访问一到两条缓存行
+ *          Hash 和 KeyEqual 支持异构类型 Q 时,所有带 Q 的接口都可以不构造 K 直接查找,KeyEqual 以 (const K&, const Q&) 调用;
+ *          GetOrCreate 插入时用 K(key) 构造 key
+ *          回调(ForEach/Visit/GetOrCreate 的 factory)在分片锁内执行,不能再访问同一个 map
+ */
+template<typename K, typename V, typename Hash = detail::MapHash<K>, typename KeyEqual = std::equal_to<>>
+class ConcurrentHashMap : public Noncopyable {
+public:
+    using value_type = std::pair<K, V>;
+
+    static constexpr size_t kDefaultShards = 16;
+    static constexpr size_t kMaxShards = 256;
+
+    /**
+     * @param {size_t} shards 分片数,向上取整为 2 的幂,不超过 kMaxShards
+     * @param {size_t} capacity 预计的元素个数,用于预分配各分片的槽位
+     */
+    explicit ConcurrentHashMap(size_t shards = kDefaultShards, size_t capacity = 0,
+                               const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : m_hash(hash), m_equal(equal) {
+        size_t num = 1;
+        while (num < shards && num < kMaxShards) {
+            num <<= 1;
+        }
+        m_shardMask = num - 1;
+        m_shards.reset(new Shard[num]);
+        size_t slots = kMinSlots;
+        while (slots * 3 < capacity / num * 4) {
+            slots <<= 1;
+        }
+        for (size_t i = 0; i < num; ++i) {
+            m_shards[i].Allocate(slots);
+        }
+    }
+
+    template<typename Q>
+    std::optional<V> Find(const Q& key) const {
+        uint64_t hash = HashOf(key);
+        const Shard& shard = GetShard(hash);
+        std::shared_lock<RWMutex> lock(shard.mutex);
+        size_t idx = FindIndex(shard, key, hash);
+        if (idx == kNpos) {
+            return std::nullopt;
+        }
+        return shard.entries[idx].Get()->second;
+    }
+
+    template<typename Q>
+    bool Contains(const Q& key) const {
+        return Visit(key, [](const V&) {});
+    }
+
+    /**
+     * @description: 在读锁内以 func(const V&) 访问 key 对应的值,避免拷贝
+     * @return: key 是否存在
+     */
+    template<typename Q, typename Func>
+    bool Visit(const Q& key, Func&& func) const {
+        uint64_t hash = HashOf(key);
+        const Shard& shard = GetShard(hash);
+        std::shared_lock<RWMutex> lock(shard.mutex);
+        size_t idx = FindIndex(shard, key, hash);
+        if (idx == kNpos) {
+            return false;
+        }
+        func(shard.entries[idx].Get()->second);
+        return true;
+    }
+
+    /**
+     * @description: 插入键值对,key 已存在时不覆盖
+     * @return: 是否插入
+     */
+    bool Insert(K key, V value) {
+        uint64_t hash = HashOf(key);
+        Shard& shard = GetShard(hash);
+        std::lock_guard<RWMutex> lock(shard.mutex);
+        auto [idx, found] = Probe(shard, key, hash);
+        if (found) {
+            return false;
+        }
+        Construct(shard, idx, hash, std::move(key), std::move(value));
+        return true;
+    }
+
+    /**
+     * @description: 插入键值对,key 已存在时覆盖
+     * @return: 是否是新插入的 key
+     */
+    bool InsertOrAssign(K key, V value) {
+        uint64_t hash = HashOf(key);
+        Shard& shard = GetShard(hash);
+        std::lock_guard<RWMutex> lock(shard.mutex);
+        auto [idx, found] = Probe(shard, key, hash);
+        if (found) {
+            shard.entries[idx].Get()->second = std::move(value);
+            return false;
+        }
+        Construct(shard, idx, hash, std::move(key), std::move(value));
+        return true;
+    }
+
+    /**
+     * @description: 查找 key 对应的值,不存在时调用 factory() 创建并插入,同一个 key 的 factory 只会被调用一次
+     * @details 先在读锁内查找,命中时不会加写锁
+     */
+    template<typename Q, typename Factory>
+    V GetOrCreate(const Q& key, Factory&& factory) {
+        uint64_t hash = HashOf(key);
+        Shard& shard = GetShard(hash);
+        {
+            std::shared_lock<RWMutex> lock(shard.mutex);
+            size_t idx = FindIndex(shard, key, hash);
+            if (idx != kNpos) {
+                return shard.entries[idx].Get()->second;
+            }
+        }
+        std::lock_guard<RWMutex> lock(shard.mutex);
+        auto [idx, found] = Probe(shard, key, hash);
+        if (!found) {
+            V value = factory();
+            // factory 抛异常时表没有被修改
+            idx = Construct(shard, idx, hash, K(key), std::move(value));
+        }
+        return shard.entries[idx].Get()->second;
+    }
+
+    /**
+     * @return: key 是否存在
+     */
+    template<typename Q>
+    bool Erase(const Q& key) {
+        uint64_t hash = HashOf(key);
+        Shard& shard = GetShard(hash);
+        std::lock_guard<RWMutex> lock(shard.mutex);
+        size_t idx = FindIndex(shard, key, hash);
+        if (idx == kNpos) {
+            return false;
+        }
+        shard.entries[idx].Get()->~value_type();
+        // 下一个槽位为空时探测序列在这里结束,不需要留下墓碑
+        if (shard.ctrl[(idx + 1) & shard.mask] == kEmpty) {
+            shard.ctrl[idx] = kEmpty;
+        } else {
+            shard.ctrl[idx] = kDeleted;
+            ++shard.tombstones;
+        }
+        shard.size.store(shard.size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @description: 逐个分片在读锁内以 func(const K&, const V&) 遍历,不是整个表的一致快照
+     */
+    template<typename Func>
+    void ForEach(Func&& func) const {
+        for (size_t s = 0; s <= m_shardMask; ++s) {
+            const Shard& shard = m_shards[s];
+            std::shared_lock<RWMutex> lock(shard.mutex);
+            for (size_t i = 0; i <= shard.mask; ++i) {
+                if (shard.ctrl[i] & kFull) {
+                    const value_type& item = *shard.entries[i].Get();
+                    func(item.first, item.second);
+                }
+            }
+        }
+    }
+
+    void Clear() {
+        for (size_t s = 0; s <= m_shardMask; ++s) {
+            Shard& shard = m_shards[s];
+            std::lock_guard<RWMutex> lock(shard.mutex);
+            shard.Destroy();
+            std::fill(shard.ctrl.get(), shard.ctrl.get() + shard.mask + 1, kEmpty);
+            shard.size.store(0, std::memory_order_relaxed);
+            shard.tombstones = 0;
+        }
+    }
+
+    /**
+     * @description: 不加锁地累加各分片的元素个数,并发修改时是近似值
+     */
+    size_t Size() const {
+        size_t size = 0;
+        for (size_t s = 0; s <= m_shardMask; ++s) {
+            size += m_shards[s].size.load(std::memory_order_relaxed);
+        }
+        return size;
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    size_t GetShardCount() const { return m_shardMask + 1; }
+
+private:
+    static constexpr uint8_t kEmpty = 0;
+    static constexpr uint8_t kDeleted = 1;
+    static constexpr uint8_t kFull = 0x80;
+    static constexpr size_t kMinSlots = 8;
+    static constexpr size_t kNpos = static_cast<size_t>(-1);
+
+    struct Entry {
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+        value_type* Get() { return reinterpret_cast<value_type*>(storage); }
+        const value_type* Get() const { return reinterpret_cast<const value_type*>(storage); }
+    };
+
+    struct alignas(64) Shard {
+        ~Shard() { Destroy(); }
+
+        void Allocate(size_t slots) {
+            ctrl.reset(new uint8_t[slots]());
+            entries.reset(new Entry[slots]);
+            mask = slots - 1;
+        }
+
+        void Destroy() {
+            if (!ctrl) {
+                return;
+            }
+            for (size_t i = 0; i <= mask; ++i) {
+                if (ctrl[i] & kFull) {
+                    entries[i].Get()->~value_type();
+                }
+            }
+        }
+
+        mutable RWMutex mutex;
+        std::unique_ptr<uint8_t[]> ctrl;
+        std::unique_ptr<Entry[]> entries;
+        size_t mask{0};
+        size_t tombstones{0};
+        // 只在写锁内修改,Size 不加锁读取
+        std::atomic<size_t> size{0};
+    };
+
+    template<typename Q>
+    uint64_t HashOf(const Q& key) const {
+        return detail::MixHash(static_cast<uint64_t>(m_hash(key)));
+    }
+
+    // 高 8 位选择分片,接下来 7 位作为标签,低位作为槽位下标
+    Shard& GetShard(uint64_t hash) { return m_shards[(hash >> 56) & m_shardMask]; }
+    const Shard& GetShard(uint64_t hash) const { return m_shards[(hash >> 56) & m_shardMask]; }
+
+    static uint8_t Tag(uint64_t hash) { return kFull | ((hash >> 49) & 0x7f); }
+
+    template<typename Q>
+    size_t FindIndex(const Shard& shard, const Q& key, uint64_t hash) const {
+        uint8_t tag = Tag(hash);
+        for (size_t i = hash & shard.mask; ; i = (i + 1) & shard.mask) {
+            uint8_t ctrl = shard.ctrl[i];
+            if (ctrl == kEmpty) {
+                return kNpos;
+            }
+            if (ctrl == tag && m_equal(shard.entries[i].Get()->first, key)) {
+                return i;
+            }
+        }
+    }
+
+    /**
+     * @description: 写锁内调用,必要时先扩容,再查找 key
+     * @return: key 存在时返回它的下标和 true,否则返回可插入的下标(优先复用墓碑)和 false
+     */
+    template<typename Q>
+    std::pair<size_t, bool> Probe(Shard& shard, const Q& key, uint64_t hash) {
+        size_t size = shard.size.load(std::memory_order_relaxed);
+        size_t slots = shard.mask + 1;
+        // 有效元素不超过 3/4,加上墓碑不超过 7/8,保证探测序列总能遇到空槽
+        if ((size + 1) * 4 > slots * 3) {
+            Rehash(shard, slots * 2);
+        } else if ((size + shard.tombstones + 1) * 8 > slots * 7) {
+            Rehash(shard, slots);
+        }
+
+        uint8_t tag = Tag(hash);
+        size_t slot = kNpos;
+        for (size_t i = hash & shard.mask; ; i = (i + 1) & shard.mask) {
+            uint8_t ctrl = shard.ctrl[i];
+            if (ctrl == kEmpty) {
+                return {slot == kNpos ? i : slot, false};
+            }
+            if (ctrl == kDeleted) {
+                if (slot == kNpos) {
+                    slot = i;
+                }
+            } else if (ctrl == tag && m_equal(shard.entries[i].Get()->first, key)) {
+                return {i, true};
+            }
+        }
+    }
+
+    template<typename Key, typename Value>
+    size_t Construct(Shard& shard, size_t idx, uint64_t hash, Key&& key, Value&& value) {
+        new (shard.entries[idx].storage) value_type(std::forward<Key>(key), std::forward<Value>(value));
+        if (shard.ctrl[idx] == kDeleted) {
+            --shard.tombstones;
+        }
+        shard.ctrl[idx] = Tag(hash);
+        shard.size.store(shard.size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return idx;
+    }
+
+    /**
+     * @description: 把所有元素搬到 slots 个槽位的新表中,同时清除墓碑
+     */
+    void Rehash(Shard& shard, size_t slots) {
+        std::unique_ptr<uint8_t[]> ctrl(new uint8_t[slots]());
+        std::unique_ptr<Entry[]> entries(new Entry[slots]);
+        size_t mask = slots - 1;
+        for (size_t i = 0; i <= shard.mask; ++i) {
+            if (!(shard.ctrl[i] & kFull)) {
+                continue;
+            }
+            value_type* item = shard.entries[i].Get();
+            uint64_t hash = HashOf(item->first);
+            size_t idx = hash & mask;
+            while (ctrl[idx] != kEmpty) {
+                idx = (idx + 1) & mask;
+            }
+            new (entries[idx].storage) value_type(std::move(*item));
+            item->~value_type();
+            ctrl[idx] = Tag(hash);
+        }
+        shard.ctrl = std::move(ctrl);
+        shard.entries = std::move(entries);
+        shard.mask = mask;
+        shard.tombstones = 0;
+    }
+
+private:
+    std::unique_ptr<Shard[]> m_shards;
+    size_t m_shardMask{0};
+    Hash m_hash;
+    KeyEqual m_equal;
+};
+
+}
+
+#endif
@@ -0,0 +1,465 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 21:00:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 21:00:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/concurrent_queue.h
+ * @Description: 有界无锁队列 SPSC/MPSC/MPMC 以及阻塞包装
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_CONCURRENT_QUEUE_H__
+#define __WHY_CONCURRENT_QUEUE_H__
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+#include "macro.h"
+#include "mutex.h"
+#include "noncopyable.h"
+
+namespace why {
+
+namespace detail {
+
+constexpr size_t kCacheLineSize = 64;
+
+inline size_t RoundUpPowerOfTwo(size_t val) {
+    size_t cap = 2;
+    while (cap < val) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+/**
+ * @description: Vyukov 有界队列,每个槽位带一个序号,生产者和消费者只通过序号同步
+ * @details 槽位 i 的序号等于 i 时可以写入,等于 i + 1 时可以读取,读取后设置为 i + capacity 留给下一圈;
+ *          kMultiConsumer 为 false 时出队位置只有一个线程修改,不需要 CAS
+ */
+template<typename T, bool kMultiConsumer>
+class VyukovQueue : public Noncopyable {
+public:
+    explicit VyukovQueue(size_t capacity) {
+        size_t cap = RoundUpPowerOfTwo(capacity);
+        m_mask = cap - 1;
+        m_cells = static_cast<Cell*>(::operator new(cap * sizeof(Cell), std::align_val_t(alignof(Cell))));
+        for (size_t i = 0; i < cap; ++i) {
+            new (&m_cells[i]) Cell();
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~VyukovQueue() {
+        size_t tail = m_enqueuePos.load(std::memory_order_relaxed);
+        for (size_t pos = m_dequeuePos.load(std::memory_order_relaxed); pos != tail; ++pos) {
+            Cell& cell = m_cells[pos & m_mask];
+            if (cell.seq.load(std::memory_order_relaxed) == pos + 1) {
+                cell.Get()->~T();
+            }
+        }
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].~Cell();
+        }
+        ::operator delete(m_cells, std::align_val_t(alignof(Cell)));
+    }
+
+    template<typename ...Args>
+    bool TryEmplace(Args&& ...args) {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = m_cells[pos & m_mask];
+            intptr_t diff = static_cast<intptr_t>(cell.seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    new (cell.storage) T(std::forward<Args>(args)...);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // 这一圈的槽位还没有被消费,队列满
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPush(const T& item) { return TryEmplace(item); }
+
+    bool TryPush(T&& item) { return TryEmplace(std::move(item)); }
+
+    bool TryPop(T& item) {
+        return TryPopBatch(&item, 1) == 1;
+    }
+
+    /**
+     * @description: 一次 CAS 占用连续的空槽位,最多写入 n 个元素(移动)
+     * @return 实际写入的个数,队列满时为 0
+     */
+    size_t TryPushBatch(T* items, size_t n) {
+        if (n == 0) {
+            return 0;
+        }
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            size_t k = 0;
+            while (k < n && m_cells[(pos + k) & m_mask].seq.load(std::memory_order_acquire) == pos + k) {
+                ++k;
+            }
+            if (k == 0) {
+                Cell& cell = m_cells[pos & m_mask];
+                if (static_cast<intptr_t>(cell.seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos) < 0) {
+                    return 0;
+                }
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                for (size_t i = 0; i < k; ++i) {
+                    Cell& cell = m_cells[(pos + i) & m_mask];
+                    new (cell.storage) T(std::move(items[i]));
+                    cell.seq.store(pos + i + 1, std::memory_order_release);
+                }
+                return k;
+            }
+        }
+    }
+
+    /**
+     * @description: 最多取出 n 个连续的已写入元素,多消费者时一次 CAS 占用
+     * @return 实际取出的个数,队列为空时为 0
+     */
+    size_t TryPopBatch(T* items, size_t n) {
+        if (n == 0) {
+            return 0;
+        }
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        while (true) {
+            size_t k = 0;
+            while (k < n && m_cells[(pos + k) & m_mask].seq.load(std::memory_order_acquire) == pos + k + 1) {
+                ++k;
+            }
+            if (k == 0) {
+                Cell& cell = m_cells[pos & m_mask];
+                if (!kMultiConsumer ||
+                    static_cast<intptr_t>(cell.seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos + 1) < 0) {
+                    return 0;
+                }
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (kMultiConsumer) {
+                if (!m_dequeuePos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                    continue;
+                }
+            } else {
+                m_dequeuePos.store(pos + k, std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < k; ++i) {
+                Cell& cell = m_cells[(pos + i) & m_mask];
+                T* value = cell.Get();
+                items[i] = std::move(*value);
+                value->~T();
+                cell.seq.store(pos + i + m_mask + 1, std::memory_order_release);
+            }
+            return k;
+        }
+    }
+
+    /**
+     * @description: 元素个数的近似值
+     */
+    size_t Size() const {
+        size_t tail = m_enqueuePos.load(std::memory_order_acquire);
+        size_t head = m_dequeuePos.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    size_t Capacity() const { return m_mask + 1; }
+
+private:
+    struct Cell {
+        T* Get() { return std::launder(reinterpret_cast<T*>(storage)); }
+
+        std::atomic<size_t> seq{0};
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+private:
+    alignas(kCacheLineSize) std::atomic<size_t> m_enqueuePos{0};
+    alignas(kCacheLineSize) std::atomic<size_t> m_dequeuePos{0};
+    alignas(kCacheLineSize) Cell* m_cells{nullptr};
+    size_t m_mask{0};
+};
+
+}
+
+/**
+ * @description: 单生产者单消费者有界队列,容量为 2 的幂
+ * @details 生产者和消费者各自缓存对方的位置,只在缓存的位置显示队列满/空时才读取对方的缓存行
+ */
+template<typename T>
+class SpscQueue : public Noncopyable {
+public:
+    explicit SpscQueue(size_t capacity = 1024) {
+        size_t cap = detail::RoundUpPowerOfTwo(capacity);
+        m_mask = cap - 1;
+        m_buffer = static_cast<T*>(::operator new(cap * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    ~SpscQueue() {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        for (size_t pos = m_head.load(std::memory_order_relaxed); pos != tail; ++pos) {
+            m_buffer[pos & m_mask].~T();
+        }
+        ::operator delete(m_buffer, std::align_val_t(alignof(T)));
+    }
+
+    template<typename ...Args>
+    bool TryEmplace(Args&& ...args) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask) {
+                return false;
+            }
+        }
+        new (&m_buffer[tail & m_mask]) T(std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPush(const T& item) { return TryEmplace(item); }
+
+    bool TryPush(T&& item) { return TryEmplace(std::move(item)); }
+
+    bool TryPop(T& item) {
+        return TryPopBatch(&item, 1) == 1;
+    }
+
+    size_t TryPushBatch(T* items, size_t n) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t free = m_mask + 1 - (tail - m_cachedHead);
+        if (free < n) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            free = m_mask + 1 - (tail - m_cachedHead);
+        }
+        n = std::min(n, free);
+        for (size_t i = 0; i < n; ++i) {
+            new (&m_buffer[(tail + i) & m_mask]) T(std::move(items[i]));
+        }
+        m_tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t TryPopBatch(T* items, size_t n) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t avail = m_cachedTail - head;
+        if (avail < n) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            avail = m_cachedTail - head;
+        }
+        n = std::min(n, avail);
+        for (size_t i = 0; i < n; ++i) {
+            T& value = m_buffer[(head + i) & m_mask];
+            items[i] = std::move(value);
+            value.~T();
+        }
+        m_head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t Size() const {
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t head = m_head.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    size_t Capacity() const { return m_mask + 1; }
+
+private:
+    // 生产者写,消费者读
+    alignas(detail::kCacheLineSize) std::atomic<size_t> m_tail{0};
+    // 只有生产者访问
+    size_t m_cachedHead{0};
+    // 消费者写,生产者读
+    alignas(detail::kCacheLineSize) std::atomic<size_t> m_head{0};
+    // 只有消费者访问
+    size_t m_cachedTail{0};
+    alignas(detail::kCacheLineSize) T* m_buffer{nullptr};
+    size_t m_mask{0};
+};
+
+/**
+ * @description: 多生产者单消费者有界队列,只有一个线程可以出队
+ */
+template<typename T>
+class MpscQueue : public detail::VyukovQueue<T, false> {
+public:
+    explicit MpscQueue(size_t capacity = 1024) : detail::VyukovQueue<T, false>(capacity) {}
+};
+
+/**
+ * @description: 多生产者多消费者有界队列
+ */
+template<typename T>
+class MpmcQueue : public detail::VyukovQueue<T, true> {
+public:
+    explicit MpmcQueue(size_t capacity = 1024) : detail::VyukovQueue<T, true>(capacity) {}
+};
+
+/**
+ * @description: 在无锁队列上增加阻塞的 Push/Pop,队列满或空时先短暂自旋,再通过 futex 挂起
+ * @details 每个方向一个事件计数:等待者先登记再检查队列,通知方在修改队列之后检查等待者,
+ *          没有等待者时 Push/Pop 不会进入内核;
+ *          Queue 为 SpscQueue/MpscQueue 时仍然要遵守对应的生产者/消费者数量限制
+ */
+template<typename Queue>
+class BlockingQueue : public Noncopyable {
+public:
+    static constexpr int kSpinCount = 64;
+
+    explicit BlockingQueue(size_t capacity = 1024) : m_queue(capacity) {}
+
+    /**
+     * @description: 队列满时阻塞,关闭后返回 false
+     */
+    template<typename T>
+    bool Push(T&& item) {
+        // 失败的 TryPush 不会移动 item,可以重复调用
+        if (!Wait(m_notFull, [&] { return m_queue.TryPush(std::forward<T>(item)); })) {
+            return false;
+        }
+        Notify(m_notEmpty, 1);
+        return true;
+    }
+
+    /**
+     * @description: 队列为空时阻塞,关闭且取完所有元素后返回 false
+     */
+    template<typename T>
+    bool Pop(T& item) {
+        return PopBatch(&item, 1) == 1;
+    }
+
+    /**
+     * @description: 至少取出一个元素,最多 n 个;关闭且为空时返回 0
+     */
+    template<typename T>
+    size_t PopBatch(T* items, size_t n) {
+        size_t cnt = 0;
+        if (!Wait(m_notEmpty, [&] {
+            cnt = m_queue.TryPopBatch(items, n);
+            return cnt > 0;
+        })) {
+            return 0;
+        }
+        Notify(m_notFull, cnt);
+        return cnt;
+    }
+
+    template<typename T>
+    bool TryPush(T&& item) {
+        if (m_closed.load(std::memory_order_acquire) || !m_queue.TryPush(std::forward<T>(item))) {
+            return false;
+        }
+        Notify(m_notEmpty, 1);
+        return true;
+    }
+
+    template<typename T>
+    bool TryPop(T& item) {
+        if (!m_queue.TryPop(item)) {
+            return false;
+        }
+        Notify(m_notFull, 1);
+        return true;
+    }
+
+    /**
+     * @description: 关闭队列并唤醒所有等待者,之后 Push 失败,Pop 取完剩余元素后失败
+     */
+    void Close() {
+        m_closed.store(true, std::memory_order_seq_cst);
+        for (auto event : {&m_notEmpty, &m_notFull}) {
+            event->seq.fetch_add(1, std::memory_order_seq_cst);
+            Futex::WakeAll(&event->seq);
+        }
+    }
+
+    bool IsClosed() const { return m_closed.load(std::memory_order_acquire); }
+
+    size_t Size() const { return m_queue.Size(); }
+
+    Queue& GetQueue() { return m_queue; }
+
+private:
+    struct alignas(detail::kCacheLineSize) EventCount {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint32_t> waiters{0};
+    };
+
+    /**
+     * @description: 反复调用 func 直到成功或者队列关闭
+     */
+    template<typename Func>
+    bool Wait(EventCount& event, Func&& func) {
+        for (int i = 0; i < kSpinCount; ++i) {
+            if (m_closed.load(std::memory_order_acquire)) {
+                return &event == &m_notEmpty && func();
+            }
+            if (func()) {
+                return true;
+            }
+            CPU_RELAX();
+        }
+        while (true) {
+            uint32_t seq = event.seq.load(std::memory_order_acquire);
+            event.waiters.fetch_add(1, std::memory_order_seq_cst);
+            bool done = func();
+            bool closed = m_closed.load(std::memory_order_seq_cst);
+            if (!done && !closed) {
+                Futex::Wait(&event.seq, seq);
+            }
+            event.waiters.fetch_sub(1, std::memory_order_relaxed);
+            if (done) {
+                return true;
+            }
+            if (closed) {
+                // 关闭后 Pop 仍然可以取走剩余元素
+                return &event == &m_notEmpty && func();
+            }
+        }
+    }
+
+    /**
+     * @description: 队列发生了 count 个元素的变化,最多唤醒 count 个等待者
+     */
+    void Notify(EventCount& event, size_t count) {
+        // 与等待者的登记配对:要么等待者看到队列的修改,要么这里看到等待者
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (event.waiters.load(std::memory_order_relaxed) > 0) {
+            event.seq.fetch_add(1, std::memory_order_release);
+            Futex::Wake(&event.seq, static_cast<uint32_t>(std::min<size_t>(count, UINT32_MAX)));
+        }
+    }
+
+private:
+    Queue m_queue;
+    EventCount m_notEmpty;
+    EventCount m_notFull;
+    std::atomic<bool> m_closed{false};
+};
+
+}
+
+#endif
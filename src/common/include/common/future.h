@@ -0,0 +1,417 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 12:10:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 12:10:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/future.h
+ * @Description: 支持回调链的 Future/Promise
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_FUTURE_H__
+#define __WHY_FUTURE_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "macro.h"
+#include "unique_task.h"
+
+namespace why {
+
+template<typename T> class Future;
+template<typename T> class Promise;
+
+namespace detail {
+
+struct Unit {};
+
+template<typename T>
+using StoredType = std::conditional_t<std::is_void<T>::value, Unit, T>;
+
+/**
+ * @description: Future 与 Promise 之间的共享状态,每对 Future/Promise 只分配这一次内存
+ * @details 完成之后值与异常不再修改,因此完成后的读取不需要加锁
+ */
+template<typename T>
+class FutureState {
+public:
+    using Stored = StoredType<T>;
+
+    void SetValue(Stored&& val) {
+        Complete([&] { m_value.emplace(std::move(val)); });
+    }
+
+    void SetException(std::exception_ptr e) {
+        Complete([&] { m_exception = e; });
+    }
+
+    /**
+     * @description: 注册完成回调,已经完成时在当前线程直接执行,只支持注册一次
+     */
+    void Subscribe(UniqueTask&& cb) {
+        UNIQUE_LOCK lock(m_mtx);
+        if (!m_ready) {
+            CHECK_THROW(!m_callback, "future already has a continuation");
+            m_callback = std::move(cb);
+            return;
+        }
+        lock.unlock();
+        cb();
+    }
+
+    bool IsReady() {
+        LOCK_GUARD lock(m_mtx);
+        return m_ready;
+    }
+
+    void Wait() {
+        UNIQUE_LOCK lock(m_mtx);
+        m_cv.wait(lock, [this] { return m_ready; });
+    }
+
+    /**
+     * @description: 等待完成并移出结果,有异常时重新抛出
+     */
+    Stored Take() {
+        Wait();
+        if (m_exception) {
+            std::rethrow_exception(m_exception);
+        }
+        return std::move(*m_value);
+    }
+
+    /**
+     * @description: 只能在完成后调用
+     */
+    const std::exception_ptr& GetException() const { return m_exception; }
+
+private:
+    template<typename F>
+    void Complete(F&& setter) {
+        UniqueTask cb{};
+        {
+            LOCK_GUARD lock(m_mtx);
+            CHECK_THROW(!m_ready, "promise already satisfied");
+            setter();
+            m_ready = true;
+            cb = std::move(m_callback);
+        }
+        m_cv.notify_all();
+        if (cb) {
+            // 回调的异常不能从 SetValue/SetException 抛给完成 Promise 的一方
+            try {
+                cb();
+            } catch (const std::exception& e) {
+                std::cerr << "Future continuation exec error:" << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "Future continuation exec error: unknown exception" << std::endl;
+            }
+        }
+    }
+
+private:
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    bool m_ready{false};
+    std::optional<Stored> m_value;
+    std::exception_ptr m_exception;
+    UniqueTask m_callback;
+};
+
+template<typename T, typename F>
+struct ContinuationResult {
+    using type = std::invoke_result_t<F, T>;
+};
+
+template<typename F>
+struct ContinuationResult<void, F> {
+    using type = std::invoke_result_t<F>;
+};
+
+}
+
+/**
+ * @description: 在调用 post 的线程上直接执行任务的执行器
+ */
+struct InlineExecutor {
+    void post(UniqueTask&& task) { task(); }
+};
+
+/**
+ * @description: 调用 func(args...) 并用结果或异常完成 promise
+ */
+template<typename R, typename F, typename ...Args>
+void FulfillPromise(Promise<R>& promise, F& func, Args&& ...args) {
+    // 只捕获 func 的异常,SetValue 本身的异常(如重复设置)不能再转成 SetException
+    if constexpr (std::is_void<R>::value) {
+        try {
+            func(std::forward<Args>(args)...);
+        } catch (...) {
+            promise.SetException(std::current_exception());
+            return;
+        }
+        promise.SetValue();
+    } else {
+        std::optional<R> result{};
+        try {
+            result.emplace(func(std::forward<Args>(args)...));
+        } catch (...) {
+            promise.SetException(std::current_exception());
+            return;
+        }
+        promise.SetValue(std::move(*result));
+    }
+}
+
+template<typename T>
+class Promise {
+public:
+    Promise() : m_state(std::make_shared<detail::FutureState<T>>()) {}
+
+    Promise(Promise&&) = default;
+
+    Promise& operator=(Promise&& other) {
+        if (this != &other) {
+            Abandon();
+            m_state = std::move(other.m_state);
+            m_retrieved = other.m_retrieved;
+        }
+        return *this;
+    }
+
+    /**
+     * @description: 没有设置结果就析构时,Future 会得到 broken_promise 异常
+     */
+    ~Promise() { Abandon(); }
+
+    Future<T> GetFuture() {
+        CHECK_THROW(m_state && !m_retrieved, "future already retrieved");
+        m_retrieved = true;
+        return Future<T>(m_state);
+    }
+
+    /**
+     * @description: 设置结果,T 为 void 时不带参数
+     */
+    template<typename ...Args>
+    void SetValue(Args&& ...args) {
+        m_state->SetValue(detail::StoredType<T>(std::forward<Args>(args)...));
+    }
+
+    void SetException(std::exception_ptr e) { m_state->SetException(e); }
+
+private:
+    void Abandon() {
+        if (m_state && !m_state->IsReady()) {
+            m_state->SetException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+private:
+    std::shared_ptr<detail::FutureState<T>> m_state;
+    bool m_retrieved{false};
+};
+
+/**
+ * @description: 只能移动的 Future,Get/Then 都会消耗掉这个 Future
+ */
+template<typename T>
+class Future {
+template<typename U> friend class Promise;
+template<typename U> friend class Future;
+public:
+    using value_type = T;
+
+    Future() = default;
+
+    bool Valid() const { return m_state != nullptr; }
+
+    bool IsReady() const { return m_state->IsReady(); }
+
+    void Wait() const { m_state->Wait(); }
+
+    /**
+     * @description: 阻塞等待结果,有异常时重新抛出
+     */
+    T Get() {
+        CHECK_THROW(Valid(), "future is invalid");
+        auto state = std::move(m_state);
+        if constexpr (std::is_void<T>::value) {
+            state->Take();
+        } else {
+            return state->Take();
+        }
+    }
+
+    /**
+     * @description: 完成后将 fn(value) 投递到 executor 执行,返回 fn 结果的 Future
+     * @details executor 需要提供 post(UniqueTask&&),并且生命周期长于这个回调;
+     *          前面的 Future 有异常时不会调用 fn,异常直接传递给返回的 Future;
+     *          post 抛出的异常(如线程池已经关闭)同样传递给返回的 Future
+     */
+    template<typename Executor, typename F>
+    auto Then(Executor& executor, F&& fn) {
+        using R = typename detail::ContinuationResult<T, std::decay_t<F>>::type;
+        CHECK_THROW(Valid(), "future is invalid");
+        // promise 由回调和投递的任务共享,post 失败时任务可能已经析构,仍然可以通过回调设置异常
+        auto promise = std::make_shared<Promise<R>>();
+        Future<R> future = promise->GetFuture();
+        auto state = std::move(m_state);
+        state->Subscribe([state, &executor, fn = std::forward<F>(fn), promise = std::move(promise)]() mutable {
+            try {
+                executor.post([state = std::move(state), fn = std::move(fn), promise]() mutable {
+                    if (state->GetException()) {
+                        promise->SetException(state->GetException());
+                    } else if constexpr (std::is_void<T>::value) {
+                        FulfillPromise(*promise, fn);
+                    } else {
+                        FulfillPromise(*promise, fn, state->Take());
+                    }
+                });
+            } catch (...) {
+                promise->SetException(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    /**
+     * @description: 同上,fn 在完成 Promise 的线程上直接执行
+     */
+    template<typename F>
+    auto Then(F&& fn) {
+        static InlineExecutor s_executor;
+        return Then(s_executor, std::forward<F>(fn));
+    }
+
+    /**
+     * @description: 完成(无论成功或异常)时调用 cb(state),供 WhenAll/WhenAny 使用
+     */
+    template<typename F>
+    void OnComplete(F&& cb) {
+        auto state = std::move(m_state);
+        auto raw = state.get();
+        raw->Subscribe([state = std::move(state), cb = std::forward<F>(cb)]() mutable {
+            cb(*state);
+        });
+    }
+
+private:
+    explicit Future(std::shared_ptr<detail::FutureState<T>> state) : m_state(std::move(state)) {}
+
+private:
+    std::shared_ptr<detail::FutureState<T>> m_state;
+};
+
+/**
+ * @description: 返回一个已经完成的 Future
+ */
+template<typename T, typename ...Args>
+Future<T> MakeReadyFuture(Args&& ...args) {
+    Promise<T> promise{};
+    promise.SetValue(std::forward<Args>(args)...);
+    return promise.GetFuture();
+}
+
+/**
+ * @description: 所有 Future 都完成后完成,结果按输入顺序保存;任意一个有异常时传递第一个异常
+ * @return: T 为 void 时返回 Future<void>,否则返回 Future<std::vector<T>>
+ */
+template<typename T>
+auto WhenAll(std::vector<Future<T>>& futures) {
+    using R = std::conditional_t<std::is_void<T>::value, void, std::vector<detail::StoredType<T>>>;
+    struct Context {
+        std::mutex mtx;
+        std::vector<std::optional<detail::StoredType<T>>> values;
+        std::exception_ptr exception;
+        size_t remain{0};
+        Promise<R> promise;
+    };
+    auto ctx = std::make_shared<Context>();
+    Future<R> future = ctx->promise.GetFuture();
+    ctx->values.resize(futures.size());
+    ctx->remain = futures.size();
+    if (futures.empty()) {
+        if constexpr (std::is_void<T>::value) {
+            ctx->promise.SetValue();
+        } else {
+            ctx->promise.SetValue(R{});
+        }
+        return future;
+    }
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].OnComplete([ctx, i](detail::FutureState<T>& state) {
+            UNIQUE_LOCK lock(ctx->mtx);
+            if (state.GetException()) {
+                if (!ctx->exception) {
+                    ctx->exception = state.GetException();
+                }
+            } else {
+                ctx->values[i].emplace(state.Take());
+            }
+            if (--ctx->remain) {
+                return;
+            }
+            lock.unlock();
+            if (ctx->exception) {
+                ctx->promise.SetException(ctx->exception);
+            } else if constexpr (std::is_void<T>::value) {
+                ctx->promise.SetValue();
+            } else {
+                R res{};
+                res.reserve(ctx->values.size());
+                for (auto &val : ctx->values) {
+                    res.push_back(std::move(*val));
+                }
+                ctx->promise.SetValue(std::move(res));
+            }
+        });
+    }
+    futures.clear();
+    return future;
+}
+
+/**
+ * @description: 第一个 Future 完成时完成,第一个完成的有异常时传递该异常
+ * @return: T 为 void 时返回 Future<size_t>(下标),否则返回 Future<std::pair<size_t, T>>
+ */
+template<typename T>
+auto WhenAny(std::vector<Future<T>>& futures) {
+    using R = std::conditional_t<std::is_void<T>::value, size_t, std::pair<size_t, detail::StoredType<T>>>;
+    CHECK_THROW(!futures.empty(), "WhenAny with empty futures");
+    struct Context {
+        std::atomic<bool> done{false};
+        Promise<R> promise;
+    };
+    auto ctx = std::make_shared<Context>();
+    Future<R> future = ctx->promise.GetFuture();
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].OnComplete([ctx, i](detail::FutureState<T>& state) {
+            if (ctx->done.exchange(true)) {
+                return;
+            }
+            if (state.GetException()) {
+                ctx->promise.SetException(state.GetException());
+            } else if constexpr (std::is_void<T>::value) {
+                ctx->promise.SetValue(i);
+            } else {
+                ctx->promise.SetValue(i, state.Take());
+            }
+        });
+    }
+    futures.clear();
+    return future;
+}
+
+}
+
+#endif
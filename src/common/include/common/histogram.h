@@ -0,0 +1,114 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 15:40:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 15:40:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/histogram.h
+ * @Description: 可以并发记录的对数分桶直方图
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_HISTOGRAM_H__
+#define __WHY_HISTOGRAM_H__
+
+#include <atomic>
+#include <stdint.h>
+#include "noncopyable.h"
+
+namespace why {
+
+/**
+ * @description: 对数-线性分桶的直方图,每个 2 的幂区间再均分 kSubBuckets 份,相对误差不超过 1 / kSubBuckets
+ * @details 记录只有几次 relaxed 原子操作,可以在多个线程中并发调用;读取得到的是近似快照
+ */
+class LatencyHistogram : public Noncopyable {
+public:
+    static constexpr int kSubBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    void Record(int64_t value) {
+        if (value < 0) {
+            value = 0;
+        }
+        m_buckets[Index(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        int64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+
+    int64_t Max() const { return m_max.load(std::memory_order_relaxed); }
+
+    double Mean() const {
+        uint64_t count = Count();
+        return count ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / count : 0;
+    }
+
+    /**
+     * @description: 返回第 p(0~1) 分位数所在桶的上界,不超过记录到的最大值
+     */
+    int64_t Percentile(double p) const {
+        uint64_t count = Count();
+        if (!count) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(p * count);
+        target = target < 1 ? 1 : (target > count ? count : target);
+        uint64_t acc = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            acc += m_buckets[i].load(std::memory_order_relaxed);
+            if (acc >= target) {
+                int64_t upper = UpperBound(i);
+                return upper < Max() ? upper : Max();
+            }
+        }
+        return Max();
+    }
+
+    void Reset() {
+        for (auto &bucket : m_buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static int Index(int64_t value) {
+        uint64_t v = static_cast<uint64_t>(value);
+        if (v < kSubBuckets) {
+            return static_cast<int>(v);
+        }
+        int msb = 63 - __builtin_clzll(v);
+        int exp = msb - kSubBits + 1;
+        int mantissa = static_cast<int>((v >> (msb - kSubBits)) & (kSubBuckets - 1));
+        return exp * kSubBuckets + mantissa;
+    }
+
+    /**
+     * @description: 第 idx 个桶包含的最大值
+     */
+    static int64_t UpperBound(int idx) {
+        int exp = idx / kSubBuckets;
+        int mantissa = idx % kSubBuckets;
+        if (!exp) {
+            return mantissa;
+        }
+        uint64_t upper = (static_cast<uint64_t>(kSubBuckets + mantissa + 1) << (exp - 1)) - 1;
+        return upper > static_cast<uint64_t>(INT64_MAX) ? INT64_MAX : static_cast<int64_t>(upper);
+    }
+
+private:
+    std::atomic<uint64_t> m_buckets[kBuckets]{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<int64_t> m_sum{0};
+    std::atomic<int64_t> m_max{0};
+};
+
+}
+
+#endif
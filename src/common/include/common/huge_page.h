@@ -0,0 +1,144 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 23:00:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 23:00:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/huge_page.h
+ * @Description: 大页内存区域,以及从大页区域分配常驻内存的分配器
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_HUGE_PAGE_H__
+#define __WHY_HUGE_PAGE_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include "noncopyable.h"
+
+namespace why {
+
+/**
+ * @description: 申请大页区域的选项
+ */
+struct HugePageOptions {
+    // 尝试 mmap(MAP_HUGETLB),需要预先通过 vm.nr_hugepages 预留大页
+    bool hugetlb{true};
+    // MAP_HUGETLB 失败时尝试按大页对齐映射并 madvise(MADV_HUGEPAGE)
+    bool transparent{true};
+    // mlock 锁定在物理内存中,失败(如超过 RLIMIT_MEMLOCK)不报错,见 HugePageRegion::IsLocked
+    bool lock{false};
+    // 映射后立即访问每一页,避免第一次使用时缺页
+    bool prefault{false};
+
+    bool operator==(const HugePageOptions& rhs) const {
+        return hugetlb == rhs.hugetlb && transparent == rhs.transparent && lock == rhs.lock && prefault == rhs.prefault;
+    }
+};
+
+/**
+ * @description: 一段匿名映射的内存,依次尝试 MAP_HUGETLB、透明大页和普通页,GetBacking 返回最终使用的方式
+ * @details 析构时 munmap;长度向上取整到所用页大小的整数倍
+ *          用作 Arena 的初始缓冲区: HugePageRegion region(64 << 20); Arena arena(region.GetData(), region.GetSize());
+ */
+class HugePageRegion : public Noncopyable {
+public:
+    enum class Backing {
+        NONE,
+        // hugetlbfs 大页
+        HUGETLB,
+        // 透明大页,内核在后台或缺页时合并,不保证每个 2MB 区间都是大页
+        TRANSPARENT,
+        NORMAL,
+    };
+
+    HugePageRegion() = default;
+
+    /**
+     * @description: 映射失败时抛异常,大页不可用时回退到普通页不算失败
+     */
+    explicit HugePageRegion(size_t size, const HugePageOptions& options = HugePageOptions());
+
+    HugePageRegion(HugePageRegion&& rhs) noexcept;
+
+    HugePageRegion& operator=(HugePageRegion&& rhs) noexcept;
+
+    ~HugePageRegion();
+
+    void* GetData() const { return m_data; }
+
+    size_t GetSize() const { return m_size; }
+
+    Backing GetBacking() const { return m_backing; }
+
+    bool IsLocked() const { return m_locked; }
+
+    static const char* BackingToString(Backing backing);
+
+    /**
+     * @description: 系统默认大页大小,读取 /proc/meminfo 的 Hugepagesize,读不到时为 2MB
+     */
+    static size_t GetHugePageSize();
+
+    /**
+     * @description: 透明大页是否可用,/sys/kernel/mm/transparent_hugepage/enabled 不存在或为 never 时不可用
+     */
+    static bool IsTransparentAvailable();
+
+private:
+    void Unmap();
+
+private:
+    void* m_data{nullptr};
+    size_t m_size{0};
+    Backing m_backing{Backing::NONE};
+    bool m_locked{false};
+};
+
+/**
+ * @description: HugePageAllocator 的统计信息,按实际使用的方式统计区域个数
+ */
+struct HugePageStats {
+    size_t hugetlb_regions{0};
+    size_t transparent_regions{0};
+    size_t normal_regions{0};
+    size_t mapped_bytes{0};
+    size_t used_bytes{0};
+};
+
+/**
+ * @description: 进程级的大页分配器,从 region_size 大小的 HugePageRegion 中顺序切分,分配出的内存不会释放
+ * @details 只适合 ObjectPool 的 slab、协程栈(fiber.stack_allocator)这类一旦申请就常驻或自行复用的内存;默认关闭,关闭时 Allocate 返回 nullptr,调用者回退到 operator new
+ *          可以通过配置 memory.huge_pages 开启,见 config/memory_config.h;修改配置只影响之后新建的区域
+ */
+class HugePageAllocator {
+public:
+    struct Config {
+        bool enabled{false};
+        size_t region_size{32 << 20};
+        HugePageOptions options;
+
+        bool operator==(const Config& rhs) const {
+            return enabled == rhs.enabled && region_size == rhs.region_size && options == rhs.options;
+        }
+    };
+
+    HugePageAllocator() = delete;
+
+    static void Configure(const Config& config);
+
+    static Config GetConfig();
+
+    static bool IsEnabled();
+
+    /**
+     * @description: 超过 region_size 的请求单独映射一个区域
+     * @return: 未开启时返回 nullptr
+     */
+    static void* Allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    static HugePageStats GetStats();
+};
+
+}
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 20:30:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 20:30:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/lock_profiler.h
+ * @Description: 按加锁位置统计锁竞争
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_LOCK_PROFILER_H__
+#define __WHY_LOCK_PROFILER_H__
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "histogram.h"
+#include "noncopyable.h"
+
+namespace why {
+
+/**
+ * @description: 一个加锁位置(__FILE__:__LINE__)的统计,作为函数内的 static 变量常量初始化,第一次加锁时注册
+ * @details 不竞争时只多一次 relaxed 计数,每 kHoldSampleRate 次加锁采样一次持有时间;
+ *          竞争时(try_lock 失败)记录等待时间
+ */
+class LockSite : public Noncopyable {
+public:
+    static constexpr uint64_t kHoldSampleRate = 16;
+
+    constexpr LockSite(const char* file, int line) : m_file(file), m_line(line) {}
+
+    /**
+     * @description: 加锁并记录统计
+     * @return 这次加锁是否需要采样持有时间
+     */
+    template<typename Mutex>
+    bool Lock(Mutex& mutex) {
+        if (!m_registered.load(std::memory_order_relaxed)) {
+            Register();
+        }
+        if (!mutex.try_lock()) {
+            int64_t begin = NowNs();
+            mutex.lock();
+            m_contended.fetch_add(1, std::memory_order_relaxed);
+            m_wait.Record(NowNs() - begin);
+        }
+        return m_acquisitions.fetch_add(1, std::memory_order_relaxed) % kHoldSampleRate == 0;
+    }
+
+    void RecordHold(int64_t ns) { m_hold.Record(ns); }
+
+    static int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    friend class LockProfiler;
+
+    void Register();
+
+private:
+    const char* m_file;
+    int m_line;
+    std::atomic<bool> m_registered{false};
+    // 注册表中的下一个位置,只在注册时写一次
+    LockSite* m_next{nullptr};
+    std::atomic<uint64_t> m_acquisitions{0};
+    std::atomic<uint64_t> m_contended{0};
+    LatencyHistogram m_wait;
+    LatencyHistogram m_hold;
+};
+
+/**
+ * @description: 一个加锁位置的统计快照,同一位置的多个实例(模板、不同编译单元中的内联函数)会合并
+ */
+struct LockSiteStats {
+    std::string site;
+    uint64_t acquisitions{0};
+    uint64_t contended{0};
+    uint64_t wait_total_ns{0};
+    int64_t wait_p50_ns{0};
+    int64_t wait_p99_ns{0};
+    int64_t wait_max_ns{0};
+    // 持有时间是采样得到的
+    int64_t hold_p50_ns{0};
+    int64_t hold_p99_ns{0};
+    int64_t hold_max_ns{0};
+
+    double GetContentionRatio() const { return acquisitions ? static_cast<double>(contended) / acquisitions : 0; }
+};
+
+/**
+ * @description: 锁竞争统计的查询接口,编译时定义 WHY_LOCK_PROFILING 后 LOCK_GUARD/UNIQUE_LOCK(及 _T 版本)才会记录
+ */
+class LockProfiler {
+public:
+    /**
+     * @description: 按总等待时间从大到小返回前 n 个加锁位置,n 为 0 时返回全部
+     */
+    static std::vector<LockSiteStats> GetTopContended(size_t n = 10);
+
+    static std::string ToYamlString(size_t n = 10);
+
+    /**
+     * @description: 清空所有位置的统计,用于只观察一段时间内的竞争
+     */
+    static void Reset();
+};
+
+/**
+ * @description: 带统计的 std::lock_guard,通过 LOCK_GUARD/LOCK_GUARD_T 宏使用
+ */
+template<LockSite* Site, typename MutexType = std::mutex>
+class ProfiledLockGuard : public Noncopyable {
+public:
+    explicit ProfiledLockGuard(MutexType& mutex) : m_mutex(mutex) {
+        if (Site->Lock(mutex)) {
+            m_begin = LockSite::NowNs();
+        }
+    }
+
+    ~ProfiledLockGuard() {
+        if (m_begin) {
+            Site->RecordHold(LockSite::NowNs() - m_begin);
+        }
+        m_mutex.unlock();
+    }
+
+private:
+    MutexType& m_mutex;
+    int64_t m_begin{0};
+};
+
+/**
+ * @description: 带统计的 std::unique_lock,通过 UNIQUE_LOCK/UNIQUE_LOCK_T 宏使用,可以传给条件变量
+ * @details 锁可能在条件变量等待期间释放,持有时间没有意义,只记录加锁次数和等待时间
+ */
+template<LockSite* Site, typename MutexType = std::mutex>
+class ProfiledUniqueLock : public std::unique_lock<MutexType> {
+public:
+    explicit ProfiledUniqueLock(MutexType& mutex) : std::unique_lock<MutexType>(Acquire(mutex), std::adopt_lock) {}
+
+private:
+    static MutexType& Acquire(MutexType& mutex) {
+        Site->Lock(mutex);
+        return mutex;
+    }
+};
+
+}
+
+#endif
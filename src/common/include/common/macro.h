@@ -20,6 +20,15 @@
 #define UNLIKELY(x) (x)
 #endif
 
+// 自旋等待时提示 CPU,降低功耗并让出超线程的执行资源
+#if defined __x86_64__ || defined __i386__
+#define CPU_RELAX() __builtin_ia32_pause()
+#elif defined __aarch64__
+#define CPU_RELAX() asm volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while(0)
+#endif
+
 #define CHECK_THROW(cond, ...)                          \
     do {                                                \
         if (LIKELY(cond) == 0) {                        \
@@ -27,8 +36,25 @@
         }                                               \
     } while(0)                       
 
-#define LOCK_GUARD std::lock_guard<std::mutex>
-#define UNIQUE_LOCK std::unique_lock<std::mutex>
+#define WHY_CONCAT_IMPL(a, b) a##b
+#define WHY_CONCAT(a, b) WHY_CONCAT_IMPL(a, b)
+
+#ifdef WHY_LOCK_PROFILING
+#include "lock_profiler.h"
+// 每个加锁位置定义一个常量初始化的 static 统计对象,结果通过 why::LockProfiler 查询;
+// 宏展开为两条语句,不能用作 if/for 不带花括号的循环体,同一行只能使用一次
+// LOCK_GUARD_T/UNIQUE_LOCK_T 用于 std::mutex 以外的锁类型,如 why::Mutex
+#define WHY_LOCK_SITE WHY_CONCAT(s_whyLockSite, __LINE__)
+#define LOCK_GUARD_T(MutexType) \
+    static why::LockSite WHY_LOCK_SITE{__FILE__, __LINE__}; why::ProfiledLockGuard<&WHY_LOCK_SITE, MutexType>
+#define UNIQUE_LOCK_T(MutexType) \
+    static why::LockSite WHY_LOCK_SITE{__FILE__, __LINE__}; why::ProfiledUniqueLock<&WHY_LOCK_SITE, MutexType>
+#else
+#define LOCK_GUARD_T(MutexType) std::lock_guard<MutexType>
+#define UNIQUE_LOCK_T(MutexType) std::unique_lock<MutexType>
+#endif
+#define LOCK_GUARD LOCK_GUARD_T(std::mutex)
+#define UNIQUE_LOCK UNIQUE_LOCK_T(std::mutex)
 
 
 // 断言宏封装
@@ -2,33 +2,204 @@
  * @Author: wuhanyi1 874864297@qq.com
  * @Date: 2023-02-09 13:39:15
  * @LastEditors: wuhanyi1 874864297@qq.com
- * @LastEditTime: 2023-02-09 13:43:07
+ * @LastEditTime: 2026-10-19 19:50:00
  * @FilePath: /cpp_basic_library/src/common/include/common/mutex.h
- * @Description: 
- * 
- * Copyright (c) 2023 by ${git_name_email}, All Rights Reserved. 
+ * @Description: 基于 futex 的同步原语
+ *
+ * Copyright (c) 2023 by ${git_name_email}, All Rights Reserved.
  */
 #ifndef __WHY_MUTEX_H__
 #define __WHY_MUTEX_H__
 
-#include <semaphore.h>
+#include <atomic>
 #include <stdint.h>
+#include "noncopyable.h"
 
 namespace why {
 
-class Semaphore {
+/**
+ * @description: futex 系统调用的封装,只用于进程内(FUTEX_PRIVATE_FLAG)
+ */
+class Futex {
 public:
-    Semaphore(uint32_t val = 0);
-    ~Semaphore();
+    /**
+     * @description: addr 的值等于 expected 时阻塞,直到被唤醒(可能虚假唤醒)
+     */
+    static void Wait(std::atomic<uint32_t>* addr, uint32_t expected);
+
+    /**
+     * @description: 唤醒最多 count 个等待 addr 的线程
+     */
+    static void Wake(std::atomic<uint32_t>* addr, uint32_t count);
+
+    static void WakeAll(std::atomic<uint32_t>* addr);
+};
+
+/**
+ * @description: 计数信号量,计数为 0 时 Wait 阻塞,没有等待者时 Post 不进入内核
+ * @details 低 32 位是计数,高 32 位是等待者数量,futex 等待在低 32 位上;
+ *          Post 通过一次原子加法同时得到等待者数量,之后不再读取对象,Wait 返回后可以立即析构
+ */
+class Semaphore : public Noncopyable {
+public:
+    Semaphore(uint32_t val = 0) : m_state(val) {}
 
     void Wait();
 
-    void Post();
+    bool TryWait();
+
+    void Post(uint32_t count = 1);
+
+private:
+    std::atomic<uint32_t>* CountWord();
+
+private:
+    static constexpr uint64_t kWaiterOne = 1ULL << 32;
+
+    std::atomic<uint64_t> m_state;
+};
+
+/**
+ * @description: 自适应互斥锁,先自旋再通过 futex 阻塞,适合很短的临界区
+ * @details 0 表示未加锁,1 表示加锁且没有等待者,2 表示加锁且可能有等待者;
+ *          自旋次数按最近几次加锁实际需要的自旋次数动态调整(与 glibc 的 PTHREAD_MUTEX_ADAPTIVE_NP 相同),
+ *          单核机器上不自旋;
+ *          接口与 std::mutex 相同,可以用于 std::lock_guard/std::unique_lock
+ */
+class Mutex : public Noncopyable {
+public:
+    static constexpr int kMaxSpin = 100;
+
+    void lock() {
+        uint32_t expected = 0;
+        if (!m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            LockSlow();
+        }
+    }
+
+    bool try_lock() {
+        uint32_t expected = 0;
+        return m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (m_state.exchange(0, std::memory_order_release) == 2) {
+            Futex::Wake(&m_state, 1);
+        }
+    }
+
+private:
+    void LockSlow();
+
+private:
+    std::atomic<uint32_t> m_state{0};
+    // 最近加锁需要的自旋次数的平均值
+    std::atomic<int> m_spins{0};
+};
+
+/**
+ * @description: 读多写少场景的读写锁,读者计数分散在多个缓存行上,读者之间不争抢同一个缓存行
+ * @details 每个线程固定使用一个读者槽位;写者先设置写标志,再等待所有槽位归零;
+ *          读者发现写标志时撤销计数并在写标志上等待;写者优先,持续的读者不会饿死写者,
+ *          代价是加写锁需要扫描所有槽位,并且只能自旋或让出 CPU 等待读者离开;
+ *          接口与 std::shared_mutex 相同,可以用于 std::shared_lock/std::unique_lock
+ */
+class RWMutex : public Noncopyable {
+public:
+    static constexpr size_t kSlots = 16;
+
+    void lock();
+
+    bool try_lock();
+
+    void unlock();
+
+    void lock_shared();
+
+    bool try_lock_shared();
+
+    void unlock_shared();
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> readers{0};
+    };
+
+    static size_t GetSlot();
+
+    bool ReadersEmpty() const;
+
+private:
+    Slot m_slots[kSlots];
+    // 写标志,写者之间也通过它互斥,读者和写者都在它上面等待
+    alignas(64) std::atomic<uint32_t> m_writer{0};
+};
+
+/**
+ * @description: 一次性的倒数计数器,计数减到 0 时唤醒所有等待者,之后 Wait 立即返回
+ * @details 最高位表示有等待者,没有等待者时计数归零不进入内核;
+ *          等待标志和计数在同一个字里,CountDown 归零后不再读取对象,Wait 返回后可以立即析构
+ */
+class Latch : public Noncopyable {
+public:
+    static constexpr uint32_t kWaitBit = 1U << 31;
+
+    explicit Latch(uint32_t count);
+
+    void CountDown(uint32_t n = 1);
+
+    bool TryWait() const { return (m_count.load(std::memory_order_acquire) & ~kWaitBit) == 0; }
+
+    void Wait();
+
+    void ArriveAndWait(uint32_t n = 1) {
+        CountDown(n);
+        Wait();
+    }
+
+private:
+    std::atomic<uint32_t> m_count;
+};
+
+/**
+ * @description: 可重复使用的屏障,count 个线程都到达后一起继续
+ * @details m_generation 的最低位表示这一轮有等待者,其余位是轮次,没有等待者时最后到达的线程不进入内核
+ */
+class Barrier : public Noncopyable {
+public:
+    explicit Barrier(uint32_t count);
+
+    /**
+     * @description: 到达并等待其他线程
+     * @return 最后一个到达的线程返回 true,与 PTHREAD_BARRIER_SERIAL_THREAD 相同
+     */
+    bool ArriveAndWait();
+
+private:
+    const uint32_t m_count;
+    std::atomic<uint32_t> m_arrived{0};
+    // 每一轮结束时加二并清除等待标志,等待者在它上面等待
+    std::atomic<uint32_t> m_generation{0};
+};
+
+/**
+ * @description: 手动复位的事件,Set 之后所有 Wait 立即返回,直到 Reset
+ * @details 0 表示未触发,1 表示已触发,2 表示未触发且有等待者,没有等待者时 Set 不进入内核
+ */
+class Event : public Noncopyable {
+public:
+    void Set();
+
+    void Reset();
+
+    bool IsSet() const { return m_state.load(std::memory_order_acquire) == 1; }
+
+    void Wait();
 
 private:
-    sem_t m_semaphore;
+    std::atomic<uint32_t> m_state{0};
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
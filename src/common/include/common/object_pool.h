@@ -0,0 +1,378 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 22:30:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 22:30:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/object_pool.h
+ * @Description: 带线程本地缓存的定长对象池
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_OBJECT_POOL_H__
+#define __WHY_OBJECT_POOL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "huge_page.h"
+#include "macro.h"
+#include "mutex.h"
+
+namespace why {
+
+/**
+ * @description: ObjectPool 的统计信息
+ */
+struct ObjectPoolStats {
+    // 向系统申请的 slab 个数
+    size_t slabs{0};
+    // 所有 slab 中的块数,即池子的总容量
+    size_t blocks{0};
+    // 全局空闲链表中的块数,不含各线程缓存和跨线程归还队列中的块
+    size_t global_free{0};
+};
+
+/**
+ * @description: 按类型区分的对象池,每个线程从自己的空闲链表分配和释放,稳定状态下不加锁也不调用 malloc
+ * @details 每个块带一个所属缓存的指针,由分配它的线程释放时直接放回本地链表,
+ *          由其他线程释放时压入所属缓存的无锁归还栈,所属线程本地链表为空时一次性取走;
+ *          本地链表超过 2 * kBatchSize 时把 kBatchSize 个块交给全局链表,供其他线程取用,避免只释放不分配的线程囤积内存;
+ *          线程退出时本地块和归还栈都交给全局链表,缓存本身留给之后新建的线程复用
+ *          块所在的 slab 不会还给系统,适合数量有上限、反复创建销毁的对象;开启 HugePageAllocator 后 slab 从大页区域中分配
+ */
+template<typename T>
+class ObjectPool {
+public:
+    static constexpr size_t kSlabBytes = 16 * 1024;
+    // 一个 slab 的块数,也是本地链表与全局链表之间一次转移的块数
+    static constexpr size_t kBatchSize = std::min<size_t>(256, std::max<size_t>(8, kSlabBytes / (sizeof(T) + sizeof(void*))));
+
+    ObjectPool() = delete;
+
+    /**
+     * @description: 分配一个可以放下 T 的未初始化内存块
+     */
+    static void* Allocate() {
+        Cache* cache = LocalCache();
+        Node* node = nullptr;
+        if (cache && (cache->local || Refill(cache))) {
+            node = cache->local;
+            cache->local = node->next;
+            --cache->count;
+        } else {
+            // 线程本地缓存已经析构(线程退出阶段),直接从全局链表取,块不属于任何缓存
+            node = GetGlobal().Take();
+        }
+        node->owner = cache;
+        return node->storage;
+    }
+
+    static void Deallocate(void* ptr) {
+        Node* node = reinterpret_cast<Node*>(static_cast<char*>(ptr) - offsetof(Node, storage));
+        Cache* cache = t_cache;
+        if (node->owner == cache && cache) {
+            node->next = cache->local;
+            cache->local = node;
+            if (++cache->count > 2 * kBatchSize) {
+                Spill(cache);
+            }
+            return;
+        }
+        PushRemote(node);
+    }
+
+    template<typename ...Args>
+    static T* New(Args&& ...args) {
+        void* ptr = Allocate();
+        try {
+            return new (ptr) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Deallocate(ptr);
+            throw;
+        }
+    }
+
+    static void Delete(T* ptr) {
+        if (ptr) {
+            ptr->~T();
+            Deallocate(ptr);
+        }
+    }
+
+    struct Deleter {
+        void operator()(T* ptr) const { Delete(ptr); }
+    };
+
+    using UniquePtr = std::unique_ptr<T, Deleter>;
+
+    template<typename ...Args>
+    static UniquePtr MakeUnique(Args&& ...args) {
+        return UniquePtr(New(std::forward<Args>(args)...));
+    }
+
+    /**
+     * @description: 对象与 shared_ptr 控制块在一次分配中从池中取出,见 PoolAllocator
+     */
+    template<typename ...Args>
+    static std::shared_ptr<T> MakeShared(Args&& ...args);
+
+    static ObjectPoolStats GetStats() {
+        Global& global = GetGlobal();
+        ObjectPoolStats stats{};
+        stats.slabs = global.slabs.load(std::memory_order_relaxed);
+        stats.blocks = stats.slabs * kBatchSize;
+        LOCK_GUARD_T(Mutex) lock(global.mutex);
+        stats.global_free = global.batches.size() * kBatchSize;
+        return stats;
+    }
+
+private:
+    struct Cache;
+
+    struct Node {
+        Cache* owner;
+        union {
+            Node* next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+    };
+
+    struct alignas(64) Cache {
+        Node* local{nullptr};
+        size_t count{0};
+        // 其他线程归还的块,值为 Closed() 表示所属线程已经退出
+        alignas(64) std::atomic<Node*> remote{nullptr};
+    };
+
+    /**
+     * @description: 全局状态,按类型泄漏一个实例,线程退出和静态析构阶段释放对象时仍然可用
+     */
+    struct Global {
+        Mutex mutex;
+        // 每一项是恰好 kBatchSize 个块组成的链表
+        std::vector<Node*> batches;
+        // 所属线程退出后的缓存,新线程优先复用
+        std::vector<Cache*> idle_caches;
+        // 归还给已退出线程、或不属于任何缓存的块,数量不足一批,单独收集
+        std::atomic<Node*> orphans{nullptr};
+        std::atomic<size_t> slabs{0};
+
+        /**
+         * @description: 取一批块,依次尝试全局链表、孤立块和新建 slab
+         * @return: 链表头,至少包含一个块
+         */
+        Node* TakeBatch() {
+            {
+                LOCK_GUARD_T(Mutex) lock(mutex);
+                if (!batches.empty()) {
+                    Node* head = batches.back();
+                    batches.pop_back();
+                    return head;
+                }
+            }
+            Node* head = orphans.exchange(nullptr, std::memory_order_acquire);
+            if (head) {
+                return head;
+            }
+            // slab 不会释放,开启 HugePageAllocator 时从大页区域中分配
+            void* mem = HugePageAllocator::Allocate(kBatchSize * sizeof(Node), alignof(Node));
+            if (!mem) {
+                mem = ::operator new(kBatchSize * sizeof(Node), std::align_val_t(alignof(Node)));
+            }
+            auto slab = static_cast<Node*>(mem);
+            for (size_t i = 0; i < kBatchSize; ++i) {
+                slab[i].next = i + 1 < kBatchSize ? &slab[i + 1] : nullptr;
+            }
+            slabs.fetch_add(1, std::memory_order_relaxed);
+            return slab;
+        }
+
+        Node* Take() {
+            Node* head = TakeBatch();
+            if (head->next) {
+                PushOrphans(head->next);
+            }
+            return head;
+        }
+
+        /**
+         * @description: 把一条链表整体压入孤立块栈,只有整体取走,不存在 ABA 问题
+         */
+        void PushOrphans(Node* head) {
+            Node* tail = head;
+            while (tail->next) {
+                tail = tail->next;
+            }
+            Node* top = orphans.load(std::memory_order_relaxed);
+            do {
+                tail->next = top;
+            } while (!orphans.compare_exchange_weak(top, head, std::memory_order_release, std::memory_order_relaxed));
+        }
+    };
+
+    /**
+     * @description: 线程退出时把缓存交还给全局
+     */
+    struct CacheHolder {
+        ~CacheHolder() {
+            Release(t_cache);
+            t_cache = nullptr;
+            t_exited = true;
+        }
+    };
+
+    static inline thread_local Cache* t_cache = nullptr;
+    static inline thread_local bool t_exited = false;
+
+    static Node* Closed() { return reinterpret_cast<Node*>(1); }
+
+    static Global& GetGlobal() {
+        static Global* s_global = new Global();
+        return *s_global;
+    }
+
+    static Cache* LocalCache() {
+        if (t_cache || t_exited) {
+            return t_cache;
+        }
+        Global& global = GetGlobal();
+        Cache* cache = nullptr;
+        {
+            LOCK_GUARD_T(Mutex) lock(global.mutex);
+            if (!global.idle_caches.empty()) {
+                cache = global.idle_caches.back();
+                global.idle_caches.pop_back();
+            }
+        }
+        if (cache) {
+            // 关闭期间仍在归还的线程会看到 Closed() 并放入孤立块栈,重新打开后归还到这里
+            cache->remote.store(nullptr, std::memory_order_release);
+        } else {
+            cache = new Cache();
+        }
+        t_cache = cache;
+        static thread_local CacheHolder s_holder;
+        (void)s_holder;
+        return cache;
+    }
+
+    /**
+     * @description: 本地链表为空时先取回其他线程归还的块,再从全局取一批
+     */
+    static bool Refill(Cache* cache) {
+        Node* head = cache->remote.exchange(nullptr, std::memory_order_acquire);
+        if (!head) {
+            head = GetGlobal().TakeBatch();
+        }
+        size_t count = 0;
+        for (Node* node = head; node; node = node->next) {
+            ++count;
+        }
+        cache->local = head;
+        cache->count = count;
+        return true;
+    }
+
+    static void Spill(Cache* cache) {
+        Node* head = cache->local;
+        Node* tail = head;
+        for (size_t i = 1; i < kBatchSize; ++i) {
+            tail = tail->next;
+        }
+        cache->local = tail->next;
+        cache->count -= kBatchSize;
+        tail->next = nullptr;
+        Global& global = GetGlobal();
+        LOCK_GUARD_T(Mutex) lock(global.mutex);
+        global.batches.push_back(head);
+    }
+
+    static void PushRemote(Node* node) {
+        Cache* owner = node->owner;
+        if (owner) {
+            Node* top = owner->remote.load(std::memory_order_relaxed);
+            while (top != Closed()) {
+                node->next = top;
+                if (owner->remote.compare_exchange_weak(top, node, std::memory_order_release,
+                                                        std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+        node->next = nullptr;
+        GetGlobal().PushOrphans(node);
+    }
+
+    static void Release(Cache* cache) {
+        if (!cache) {
+            return;
+        }
+        Global& global = GetGlobal();
+        while (cache->count >= kBatchSize) {
+            Spill(cache);
+        }
+        if (cache->local) {
+            global.PushOrphans(cache->local);
+        }
+        cache->local = nullptr;
+        cache->count = 0;
+        // 关闭之后的归还都进入孤立块栈
+        Node* remote = cache->remote.exchange(Closed(), std::memory_order_acquire);
+        if (remote) {
+            global.PushOrphans(remote);
+        }
+        LOCK_GUARD_T(Mutex) lock(global.mutex);
+        global.idle_caches.push_back(cache);
+    }
+};
+
+/**
+ * @description: 从 ObjectPool 分配单个对象的标准分配器,用于 std::allocate_shared 等需要 rebind 的场景
+ * @details 一次分配多个对象时退回 operator new
+ */
+template<typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(ObjectPool<T>::Allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (n == 1) {
+            ObjectPool<T>::Deallocate(ptr);
+        } else {
+            ::operator delete(ptr, std::align_val_t(alignof(T)));
+        }
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+template<typename T>
+template<typename ...Args>
+std::shared_ptr<T> ObjectPool<T>::MakeShared(Args&& ...args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+}
+
+#endif
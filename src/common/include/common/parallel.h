@@ -0,0 +1,273 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 13:20:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 13:20:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/parallel.h
+ * @Description: 基于线程池的数据并行算法
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_PARALLEL_H__
+#define __WHY_PARALLEL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <vector>
+#include "macro.h"
+#include "threadpool.h"
+
+namespace why {
+
+namespace detail {
+
+/**
+ * @description: 一次并行执行的共享状态,调用线程和投递到线程池的辅助任务从同一个原子计数器领取块
+ * @details 调用线程只等待已经被领取的块执行完,还没开始的辅助任务醒来后领不到块会直接退出,
+ *          因此在线程池的工作线程内嵌套调用不会因为线程池被占满而死锁
+ */
+class ChunkState {
+public:
+    explicit ChunkState(size_t chunks) : m_chunks(chunks) {}
+
+    template<typename F>
+    void Work(F& body) {
+        size_t chunk = 0;
+        while ((chunk = m_next.fetch_add(1, std::memory_order_relaxed)) < m_chunks) {
+            // 已经有块抛出异常时跳过剩余的块,只计数
+            if (!m_failed.load(std::memory_order_relaxed)) {
+                try {
+                    body(chunk);
+                } catch (...) {
+                    SetException(std::current_exception());
+                }
+            }
+            if (m_done.fetch_add(1, std::memory_order_acq_rel) + 1 == m_chunks) {
+                LOCK_GUARD lock(m_mtx);
+                m_finished = true;
+                m_cv.notify_all();
+            }
+        }
+    }
+
+    /**
+     * @description: 等待所有块执行完,有块抛出异常时重新抛出第一个异常
+     */
+    void Wait() {
+        if (m_done.load(std::memory_order_acquire) != m_chunks) {
+            UNIQUE_LOCK lock(m_mtx);
+            m_cv.wait(lock, [this] { return m_finished; });
+        }
+        if (m_exception) {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+private:
+    void SetException(std::exception_ptr e) {
+        LOCK_GUARD lock(m_mtx);
+        if (!m_exception) {
+            m_exception = e;
+        }
+        m_failed.store(true, std::memory_order_relaxed);
+    }
+
+private:
+    const size_t m_chunks;
+    alignas(64) std::atomic<size_t> m_next{0};
+    alignas(64) std::atomic<size_t> m_done{0};
+    std::atomic<bool> m_failed{false};
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    bool m_finished{false};
+    std::exception_ptr m_exception;
+};
+
+/**
+ * @description: 将 [0, n) 按 grain 切分成连续的块,grain 为 0 时按线程数自动切分
+ */
+class Partition {
+public:
+    // 自动切分时每个参与线程平均分到的块数,块多一些可以在负载不均时动态平衡
+    static constexpr size_t kChunksPerThread = 4;
+
+    Partition(const ThreadPool& pool, size_t n, size_t grain) : m_size(n) {
+        if (!grain) {
+            size_t target = (pool.GetThreadNum() + 1) * kChunksPerThread;
+            grain = (n + target - 1) / target;
+        }
+        m_grain = std::max<size_t>(grain, 1);
+        m_chunks = (n + m_grain - 1) / m_grain;
+    }
+
+    size_t Chunks() const { return m_chunks; }
+    size_t Begin(size_t chunk) const { return chunk * m_grain; }
+    size_t End(size_t chunk) const { return std::min(m_size, (chunk + 1) * m_grain); }
+
+private:
+    size_t m_size;
+    size_t m_grain;
+    size_t m_chunks;
+};
+
+/**
+ * @description: 并行执行 body(chunk), chunk 取遍 [0, chunks),调用线程参与执行并等待全部完成
+ */
+template<typename F>
+void RunChunks(ThreadPool& pool, size_t chunks, F&& body) {
+    if (chunks == 0) {
+        return;
+    }
+    if (chunks == 1 || pool.GetThreadNum() == 0) {
+        for (size_t i = 0; i < chunks; ++i) {
+            body(i);
+        }
+        return;
+    }
+    auto state = std::make_shared<ChunkState>(chunks);
+    size_t helpers = std::min(pool.GetThreadNum(), chunks - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        // 辅助任务只有领取到块时才会访问 body,此时调用线程一定还在等待,引用有效
+        pool.post([state, &body] {
+            state->Work(body);
+        });
+    }
+    state->Work(body);
+    state->Wait();
+}
+
+}
+
+/**
+ * @description: 对 [first, last) 中的每个下标 i 并行调用 func(i)
+ * @param {size_t} grain 每块的元素个数,为 0 时自动切分
+ */
+template<typename Index, typename F>
+void parallel_for(ThreadPool& pool, Index first, Index last, F&& func, size_t grain = 0) {
+    if (!(first < last)) {
+        return;
+    }
+    detail::Partition part(pool, static_cast<size_t>(last - first), grain);
+    detail::RunChunks(pool, part.Chunks(), [&](size_t chunk) {
+        Index end = first + static_cast<Index>(part.End(chunk));
+        for (Index i = first + static_cast<Index>(part.Begin(chunk)); i < end; ++i) {
+            func(i);
+        }
+    });
+}
+
+/**
+ * @description: 并行归约 [first, last),op 需要满足结合律,块内与块间都按原顺序合并
+ * @return: op(init, op(x0, op(x1, ...)))
+ */
+template<typename RandomIt, typename T, typename BinaryOp = std::plus<>>
+T parallel_reduce(ThreadPool& pool, RandomIt first, RandomIt last, T init, BinaryOp op = BinaryOp{}, size_t grain = 0) {
+    size_t n = std::distance(first, last);
+    if (!n) {
+        return init;
+    }
+    detail::Partition part(pool, n, grain);
+    std::vector<std::optional<T>> partials(part.Chunks());
+    detail::RunChunks(pool, part.Chunks(), [&](size_t chunk) {
+        RandomIt it = first + part.Begin(chunk);
+        RandomIt end = first + part.End(chunk);
+        T acc = *it;
+        for (++it; it != end; ++it) {
+            acc = op(std::move(acc), *it);
+        }
+        partials[chunk].emplace(std::move(acc));
+    });
+    for (auto &partial : partials) {
+        init = op(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
+/**
+ * @description: 并行执行 d_first[i] = op(first[i])
+ * @return: 输出区间的末尾
+ */
+template<typename RandomIt, typename OutputIt, typename UnaryOp>
+OutputIt parallel_transform(ThreadPool& pool, RandomIt first, RandomIt last, OutputIt d_first, UnaryOp op, size_t grain = 0) {
+    size_t n = std::distance(first, last);
+    detail::Partition part(pool, n, grain);
+    detail::RunChunks(pool, part.Chunks(), [&](size_t chunk) {
+        std::transform(first + part.Begin(chunk), first + part.End(chunk), d_first + part.Begin(chunk), op);
+    });
+    return d_first + n;
+}
+
+/**
+ * @description: 并行排序(不稳定),先对每一块并行 std::sort,再逐轮两两并行归并
+ */
+template<typename RandomIt, typename Compare = std::less<>>
+void parallel_sort(ThreadPool& pool, RandomIt first, RandomIt last, Compare comp = Compare{}, size_t grain = 0) {
+    size_t n = std::distance(first, last);
+    detail::Partition part(pool, n, grain);
+    size_t chunks = part.Chunks();
+    detail::RunChunks(pool, chunks, [&](size_t chunk) {
+        std::sort(first + part.Begin(chunk), first + part.End(chunk), comp);
+    });
+    // 每轮把相邻的两组有序块合并成一组,组宽翻倍
+    for (size_t width = 1; width < chunks; width *= 2) {
+        size_t merges = (chunks + 2 * width - 1) / (2 * width);
+        detail::RunChunks(pool, merges, [&](size_t idx) {
+            size_t left = idx * 2 * width;
+            size_t mid = left + width;
+            if (mid >= chunks) {
+                return;
+            }
+            size_t right = std::min(chunks, mid + width);
+            std::inplace_merge(first + part.Begin(left), first + part.Begin(mid),
+                               first + part.End(right - 1), comp);
+        });
+    }
+}
+
+/**
+ * @description: 并行包含前缀和,d_first[i] = op(x0, ..., xi),op 需要满足结合律
+ * @details 第一遍并行对每一块做块内扫描,串行计算每块的偏移,第二遍并行把偏移合并进每一块
+ * @return: 输出区间的末尾
+ */
+template<typename RandomIt, typename OutputIt, typename BinaryOp = std::plus<>>
+OutputIt parallel_scan(ThreadPool& pool, RandomIt first, RandomIt last, OutputIt d_first, BinaryOp op = BinaryOp{}, size_t grain = 0) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    size_t n = std::distance(first, last);
+    if (!n) {
+        return d_first;
+    }
+    detail::Partition part(pool, n, grain);
+    size_t chunks = part.Chunks();
+    detail::RunChunks(pool, chunks, [&](size_t chunk) {
+        std::partial_sum(first + part.Begin(chunk), first + part.End(chunk), d_first + part.Begin(chunk), op);
+    });
+    if (chunks > 1) {
+        // offsets[i] 是第 i + 1 块之前所有元素的归约结果
+        std::vector<std::optional<T>> offsets(chunks - 1);
+        offsets[0].emplace(d_first[part.End(0) - 1]);
+        for (size_t i = 1; i + 1 < chunks; ++i) {
+            offsets[i].emplace(op(*offsets[i - 1], d_first[part.End(i) - 1]));
+        }
+        detail::RunChunks(pool, chunks - 1, [&](size_t idx) {
+            const T& offset = *offsets[idx];
+            OutputIt it = d_first + part.Begin(idx + 1);
+            OutputIt end = d_first + part.End(idx + 1);
+            for (; it != end; ++it) {
+                *it = op(offset, *it);
+            }
+        });
+    }
+    return d_first + n;
+}
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 11:40:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 11:40:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/ring_buffer.h
+ * @Description: 可扩容的环形队列
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_RING_BUFFER_H__
+#define __WHY_RING_BUFFER_H__
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <stdint.h>
+#include "noncopyable.h"
+
+namespace why {
+
+/**
+ * @description: 非线程安全的 FIFO 环形队列,容量为 2 的幂,满时翻倍且不会缩容
+ * @details 容量稳定之后 PushBack/PopFront 都不会分配内存,用来替代 std::list 作为任务队列
+ */
+template<typename T>
+class RingBuffer : public Noncopyable {
+public:
+    explicit RingBuffer(size_t capacity = 64) {
+        size_t cap = 2;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        m_buffer = static_cast<T*>(::operator new(cap * sizeof(T), std::align_val_t(alignof(T))));
+        m_mask = cap - 1;
+    }
+
+    ~RingBuffer() {
+        Clear();
+        ::operator delete(m_buffer, std::align_val_t(alignof(T)));
+    }
+
+    template<typename ...Args>
+    void PushBack(Args&& ...args) {
+        if (m_tail - m_head > m_mask) {
+            Grow();
+        }
+        new (&m_buffer[m_tail & m_mask]) T(std::forward<Args>(args)...);
+        ++m_tail;
+    }
+
+    T& Front() { return m_buffer[m_head & m_mask]; }
+
+    void PopFront() {
+        m_buffer[m_head & m_mask].~T();
+        ++m_head;
+    }
+
+    /**
+     * @description: 移出并返回队首元素,调用前需保证队列非空
+     */
+    T TakeFront() {
+        T val(std::move(Front()));
+        PopFront();
+        return val;
+    }
+
+    bool Empty() const { return m_head == m_tail; }
+
+    size_t Size() const { return m_tail - m_head; }
+
+    size_t Capacity() const { return m_mask + 1; }
+
+    void Clear() {
+        while (!Empty()) {
+            PopFront();
+        }
+    }
+
+private:
+    void Grow() {
+        size_t cap = (m_mask + 1) * 2;
+        T* buffer = static_cast<T*>(::operator new(cap * sizeof(T), std::align_val_t(alignof(T))));
+        size_t size = Size();
+        for (size_t i = 0; i < size; ++i) {
+            T& val = m_buffer[(m_head + i) & m_mask];
+            new (&buffer[i]) T(std::move(val));
+            val.~T();
+        }
+        ::operator delete(m_buffer, std::align_val_t(alignof(T)));
+        m_buffer = buffer;
+        m_mask = cap - 1;
+        m_head = 0;
+        m_tail = size;
+    }
+
+private:
+    T* m_buffer{nullptr};
+    size_t m_mask{0};
+    // 单调递增的读写位置,与 m_mask 相与得到下标
+    size_t m_head{0};
+    size_t m_tail{0};
+};
+
+}
+
+#endif
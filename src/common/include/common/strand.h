@@ -0,0 +1,141 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 18:10:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 18:10:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/strand.h
+ * @Description: 在共享线程池上串行执行任务的执行器
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_STRAND_H__
+#define __WHY_STRAND_H__
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "macro.h"
+#include "noncopyable.h"
+#include "ring_buffer.h"
+#include "threadpool.h"
+#include "unique_task.h"
+
+namespace why {
+
+/**
+ * @description: 串行执行器,投递到同一个 Strand 的任务按 FIFO 顺序执行且不会并发,不同 Strand 之间并行
+ * @details 任务先放入 Strand 自己的队列,队列从空变为非空时向线程池投递一个排空任务,
+ *          排空任务每次只在取任务时短暂加锁,执行任务时不持有锁,也不会阻塞线程池的其他线程;
+ *          连续执行 kMaxBatch 个任务后重新投递,让其他任务有机会执行;
+ *          Strand 是共享状态的句柄,可以拷贝,线程池需要比所有任务活得更久;
+ *          线程池停止后 post 抛出异常,队列中还没有执行的任务被析构;
+ *          提供 post(UniqueTask&&),可以作为 Future::Then 的执行器
+ */
+class Strand {
+public:
+    static constexpr size_t kMaxBatch = 64;
+
+    explicit Strand(ThreadPool& pool);
+
+    template<typename Func, typename ...Args>
+    void post(Func&& func, Args&& ...args) {
+        if constexpr (sizeof...(Args) == 0) {
+            Push(UniqueTask(std::forward<Func>(func)));
+        } else {
+            Push(UniqueTask(std::bind(std::forward<Func>(func), std::forward<Args>(args)...)));
+        }
+    }
+
+    /**
+     * @description: 提交任务并返回 why::Future,任务的异常会传递给返回的 Future
+     */
+    template<typename Func, typename ...Args>
+    auto submit(Func&& func, Args&& ...args) {
+        using RetType = decltype(func(std::forward<Args>(args)...));
+
+        Promise<RetType> promise{};
+        auto future = promise.GetFuture();
+        post([promise = std::move(promise),
+              f = std::bind(std::forward<Func>(func), std::forward<Args>(args)...)]() mutable {
+            FulfillPromise(promise, f);
+        });
+        return future;
+    }
+
+    /**
+     * @description: 当前线程是否正在执行这个 Strand 的任务
+     */
+    bool RunningInThisThread() const;
+
+    /**
+     * @description: 还没有开始执行的任务数
+     */
+    size_t GetPendingCount() const;
+
+private:
+    struct State {
+        explicit State(ThreadPool& p) : pool(p) {}
+
+        std::mutex mtx;
+        RingBuffer<UniqueTask> tasks;
+        // 已经向线程池投递了排空任务
+        bool running{false};
+        ThreadPool& pool;
+    };
+
+    void Push(UniqueTask&& task);
+
+    /**
+     * @description: 在线程池中依次执行队列中的任务,队列为空时结束
+     */
+    static void Drain(const std::shared_ptr<State>& state);
+
+    static void Schedule(const std::shared_ptr<State>& state);
+
+private:
+    std::shared_ptr<State> m_state;
+};
+
+/**
+ * @description: 按 key 串行执行的执行器,key 哈希到固定数量的 Strand 上,
+ *               相同 key 的任务按 FIFO 顺序且不会并发执行,不同 key 可能共享同一个 Strand
+ * @details Strand 数量决定最大并行度,通常取线程池大小的若干倍
+ */
+template<typename Key, typename Hash = std::hash<Key>>
+class KeyedStrand : public Noncopyable {
+public:
+    KeyedStrand(ThreadPool& pool, size_t strands, const Hash& hash = Hash()) : m_hash(hash) {
+        CHECK_THROW(strands > 0, "KeyedStrand needs at least one strand");
+        m_strands.reserve(strands);
+        for (size_t i = 0; i < strands; ++i) {
+            m_strands.emplace_back(pool);
+        }
+    }
+
+    Strand& GetStrand(const Key& key) {
+        // 混合高位,避免 std::hash 对整数是恒等映射时低位分布不均
+        uint64_t h = static_cast<uint64_t>(m_hash(key)) * 0x9e3779b97f4a7c15ULL;
+        return m_strands[(h >> 32) % m_strands.size()];
+    }
+
+    template<typename Func, typename ...Args>
+    void post(const Key& key, Func&& func, Args&& ...args) {
+        GetStrand(key).post(std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template<typename Func, typename ...Args>
+    auto submit(const Key& key, Func&& func, Args&& ...args) {
+        return GetStrand(key).submit(std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    size_t GetStrandNum() const { return m_strands.size(); }
+
+private:
+    Hash m_hash;
+    std::vector<Strand> m_strands;
+};
+
+}
+
+#endif
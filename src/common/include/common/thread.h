@@ -14,6 +14,7 @@
 #include <functional>
 #include <pthread.h>
 #include <string>
+#include <vector>
 #include <unistd.h>
 #include <sys/types.h>
 #include "noncopyable.h"
@@ -24,17 +25,89 @@
 
 namespace why {
 
+/**
+ * @description: 线程的调度策略,FIFO/RR 是实时策略,通常需要 CAP_SYS_NICE 权限
+ */
+enum class SchedPolicy {
+    OTHER,
+    BATCH,
+    IDLE,
+    FIFO,
+    RR
+};
+
+/**
+ * @description: 创建线程时的参数
+ */
+struct ThreadOptions {
+    std::string name;
+    // 允许运行的 CPU,空表示不限制
+    std::vector<int> cpus;
+    // 绑定的 NUMA 节点,-1 表示不绑定;线程只在该节点的 CPU 上运行(与 cpus 取交集),
+    // 之后线程首次访问的内存优先分配在该节点
+    int numa_node{-1};
+    SchedPolicy policy{SchedPolicy::OTHER};
+    // FIFO/RR 的实时优先级,1~99
+    int priority{0};
+    // OTHER/BATCH/IDLE 的 nice 值,-20~19
+    int nice{0};
+    // 栈大小,0 表示使用默认值
+    size_t stack_size{0};
+
+    bool operator==(const ThreadOptions& rhs) const {
+        return name == rhs.name && cpus == rhs.cpus && numa_node == rhs.numa_node && policy == rhs.policy &&
+               priority == rhs.priority && nice == rhs.nice && stack_size == rhs.stack_size;
+    }
+};
+
+/**
+ * @description: 在线 CPU 的拓扑信息
+ */
+struct CpuInfo {
+    int cpu{0};
+    int package{0};
+    int core{0};
+    int numa_node{0};
+};
+
+/**
+ * @description: 从 /sys/devices/system 读取的 CPU 拓扑,第一次调用时读取并缓存
+ */
+class CpuTopology {
+public:
+    /**
+     * @description: 所有在线 CPU,按 cpu 编号排序
+     */
+    static const std::vector<CpuInfo>& GetCpus();
+
+    static int GetNumaNodeCount();
+
+    static std::vector<int> GetNumaNodeCpus(int node);
+
+    /**
+     * @description: 解析 "0-3,8,10-11" 格式的 CPU 列表
+     */
+    static std::vector<int> ParseCpuList(const std::string& list);
+};
+
 class Thread : public Noncopyable {
 friend class ThisThread;    
 public:
     using Func = std::function<void()>;
 
     template<typename F, typename... Args>
-    Thread(F&& func, Args... args, const std::string& name) : m_name(name) {
+    Thread(F&& func, Args... args, const std::string& name) {
+        m_options.name = name;
         m_cb = std::bind(std::forward<F>(func), std::forward<Args>(args)...);
-        int ret = pthread_create(&m_thread, nullptr, Thread::run, this);
-        CHECK_THROW(ret == 0, "pthread_create failed, ret = %d", ret);
-        m_semaphore.Wait();
+        Create();
+    }
+
+    /**
+     * @description: 按 options 创建线程,栈大小在创建时设置,其余参数在线程开始执行 func 之前应用,
+     *               应用失败时线程不会执行 func,构造函数抛出异常
+     */
+    Thread(Func func, const ThreadOptions& options) : m_cb(std::move(func)), m_options(options) {
+        Create();
     }
     
     pid_t GetPid() const { return m_id; }
@@ -52,14 +125,21 @@ public:
         }
     }
 
+    const ThreadOptions& GetOptions() const { return m_options; }
+
 private:
+    void Create();
+
     static void* run(void* arg);
 
 private:
     pid_t m_id{0};// thread id
     pthread_t m_thread{0};
     Func m_cb;
+    ThreadOptions m_options;
     std::string m_name;
+    // 线程中应用 m_options 失败的原因
+    std::string m_error;
     Semaphore m_semaphore;
 };
 
@@ -69,6 +149,26 @@ public:
     static const std::string& GetName();
     static void SetName(const std::string& name);
     static pid_t GetID();
+
+    /**
+     * @description: 把当前线程绑定到 cpus,cpus 为空时不做修改
+     */
+    static void SetAffinity(const std::vector<int>& cpus);
+
+    /**
+     * @description: 当前线程只在 node 的 CPU 上运行,之后首次访问的内存优先分配在 node
+     */
+    static void BindNumaNode(int node);
+
+    /**
+     * @description: 设置调度策略,实时策略使用 priority,其他策略使用 nice
+     */
+    static void SetSchedPolicy(SchedPolicy policy, int priority, int nice);
+
+    /**
+     * @description: 对当前线程应用除栈大小以外的所有参数,失败时抛出异常
+     */
+    static void ApplyOptions(const ThreadOptions& options);
 };
 
 }
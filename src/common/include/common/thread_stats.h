@@ -0,0 +1,80 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 19:20:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 19:20:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/thread_stats.h
+ * @Description: 存活线程的注册表与运行时统计
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_THREAD_STATS_H__
+#define __WHY_THREAD_STATS_H__
+
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace why {
+
+/**
+ * @description: 一个线程在采样时刻的统计,时间都从线程注册时开始计算
+ */
+struct ThreadStats {
+    pid_t tid{0};
+    std::string name;
+    // 注册以来经过的时间
+    uint64_t wall_ns{0};
+    // 线程消耗的 CPU 时间
+    uint64_t cpu_ns{0};
+    // 主动让出 CPU(等待锁、IO、sleep)的次数
+    uint64_t voluntary_switches{0};
+    // 时间片用完或被抢占的次数
+    uint64_t involuntary_switches{0};
+    // 是否是线程池的工作线程,下面两项只对工作线程有意义
+    bool worker{false};
+    uint64_t tasks{0};
+    // 执行任务的总时间
+    uint64_t busy_ns{0};
+
+    double GetCpuUsage() const { return wall_ns ? static_cast<double>(cpu_ns) / wall_ns : 0; }
+    double GetBusyRatio() const { return wall_ns ? static_cast<double>(busy_ns) / wall_ns : 0; }
+};
+
+/**
+ * @description: 全局的线程注册表,why::Thread 和调用过 ThisThread::SetName 的线程会自动注册,线程退出时自动注销
+ * @details 线程运行期间只更新自己的原子计数,不加锁;只有 Sample 时才读取 CPU 时间和上下文切换次数,
+ *          CPU 时间通过 pthread_getcpuclockid 得到目标线程的 CLOCK_THREAD_CPUTIME_ID,
+ *          上下文切换次数读取 /proc/self/task/<tid>/status
+ */
+class ThreadRegistry {
+public:
+    /**
+     * @description: 注册当前线程,已经注册时只更新名字
+     */
+    static void Register();
+
+    /**
+     * @description: 把当前线程标记为线程池的工作线程
+     */
+    static void MarkWorker();
+
+    /**
+     * @description: 当前线程执行完一个任务,由线程池调用,当前线程没有注册时忽略
+     */
+    static void RecordTask(uint64_t busy_ns);
+
+    /**
+     * @description: 采样所有存活的注册线程,按 tid 排序
+     */
+    static std::vector<ThreadStats> Sample();
+
+    static std::string ToYamlString();
+
+    static std::string ToJsonString();
+};
+
+}
+
+#endif
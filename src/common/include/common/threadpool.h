@@ -11,26 +11,142 @@
 #define __WHY_THREADPOOL_H__
 
 #include <thread>
-#include <list>
 #include <memory>
 #include <mutex>
 #include <vector>
 #include <functional>
 #include <future>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include "work_stealing_deque.h"
+#include "unique_task.h"
+#include "ring_buffer.h"
+#include "future.h"
+#include "histogram.h"
+#include "thread.h"
 
 namespace why {
 
 class ThreadPool {
 public:
-    using ThreadPtr = std::shared_ptr<std::thread>;
-    struct Task {
-        Task(std::function<void()> func_) : func(func_) {}
-        std::function<void()> func;
+    using ThreadPtr = std::shared_ptr<Thread>;
+    using Task = UniqueTask;
+    using ExceptionHandler = std::function<void(std::exception_ptr)>;
+
+    /**
+     * @description: 线程池的调度模式
+     * @details SHARED: 所有线程共享一个加锁的任务队列
+     *          WORK_STEALING: 每个工作线程一个 Chase-Lev 队列,工作线程内提交的任务放入自己的队列,
+     *                         外部线程提交的任务放入全局注入队列,空闲线程随机窃取其他线程的任务,
+     *                         先自旋再阻塞,适合大量细粒度任务
+     *          PRIORITY: 每个优先级一个队列,同一优先级内按截止时间(EDF)排序,没有截止时间的任务按提交顺序排在后面;
+     *                    低优先级的任务排队时间越长有效优先级越高(aging),避免被饿死;
+     *                    取出任务时已经超过截止时间的任务直接丢弃
+     */
+    enum class Mode {
+        SHARED,
+        WORK_STEALING,
+        PRIORITY
+    };
+
+    /**
+     * @description: 工作线程在 CPU 上的分布方式
+     * @details NONE: 不单独绑定,所有工作线程共享 ThreadOptions 中的 CPU 集合
+     *          SPREAD: 每个工作线程绑定一个 CPU,依次轮流使用不同的 socket 与物理核,超线程的兄弟核最后使用,
+     *                  适合互相独立、需要独占缓存的任务
+     *          PACK: 每个工作线程绑定一个 CPU,先占满一个 socket 的物理核及其兄弟核,适合共享数据多的任务
+     */
+    enum class CpuPlacement {
+        NONE,
+        SPREAD,
+        PACK
+    };
+
+    /**
+     * @description: 工作线程的参数
+     * @details thread.name 作为名字前缀(默认 "pool"),工作线程名为 前缀_下标;
+     *          SPREAD/PACK 在 thread.cpus 与 thread.numa_node 限定的 CPU 中分配,都为空时使用所有在线 CPU
+     */
+    struct WorkerOptions {
+        ThreadOptions thread{};
+        CpuPlacement placement{CpuPlacement::NONE};
+
+        bool operator==(const WorkerOptions& rhs) const {
+            return thread == rhs.thread && placement == rhs.placement;
+        }
+    };
+
+    /**
+     * @description: PRIORITY 模式下任务的优先级
+     */
+    enum class Priority : uint8_t {
+        HIGH,
+        NORMAL,
+        LOW
+    };
+    static constexpr size_t kPriorityLevels = 3;
+
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    /**
+     * @description: PRIORITY 模式下任务的调度属性
+     */
+    struct TaskAttr {
+        Priority priority{Priority::NORMAL};
+        // 截止时间,取出任务时已经超过就丢弃不执行,future 得到 broken_promise 异常
+        TimePoint deadline{TimePoint::max()};
+        // 任务因为超过截止时间被丢弃时在工作线程中调用
+        std::function<void()> on_expired;
+    };
+
+    /**
+     * @description: Shutdown 对还没有开始执行的任务的处理方式
+     * @details FINISH_PENDING: 等待队列中的任务(包括执行过程中新提交的任务)全部执行完
+     *          CANCEL_PENDING: 丢弃队列中的任务,只等待正在执行的任务,
+     *                          被丢弃任务的 future 得到 broken_promise 异常
+     */
+    enum class ShutdownMode {
+        FINISH_PENDING,
+        CANCEL_PENDING
+    };
+
+    /**
+     * @description: 弹性线程池的参数,只支持 SHARED 模式
+     * @details 提交或取出任务时,如果队首任务的排队时间超过 target_queue_wait 且没有空闲线程,
+     *          就增加一个线程,两次扩容至少间隔 grow_interval;
+     *          线程空闲超过 idle_timeout 后退出,距离上一次扩容也需要超过 idle_timeout,避免反复扩缩
+     */
+    struct ElasticOptions {
+        size_t min_threads{1};
+        // 为 0 时取 hardware_concurrency
+        size_t max_threads{0};
+        std::chrono::nanoseconds target_queue_wait{std::chrono::milliseconds(5)};
+        std::chrono::nanoseconds grow_interval{std::chrono::milliseconds(1)};
+        std::chrono::nanoseconds idle_timeout{std::chrono::seconds(10)};
+    };
+
+    /**
+     * @description: 线程池运行指标,空闲线程数只在弹性模式下统计,排队时间在弹性与 PRIORITY 模式下统计
+     */
+    struct Stats {
+        size_t threads{0};
+        size_t idle_threads{0};
+        size_t peak_threads{0};
+        size_t pending{0};
+        uint64_t grows{0};
+        uint64_t shrinks{0};
+        // 超过截止时间被丢弃的任务数
+        uint64_t expired{0};
+        int64_t queue_wait_p50_ns{0};
+        int64_t queue_wait_p99_ns{0};
+        int64_t queue_wait_max_ns{0};
     };
-    using TaskPtr = std::shared_ptr<Task>;
     
-    ThreadPool(int size = 0);
+    ThreadPool(int size = 0, Mode mode = Mode::SHARED);
+
+    explicit ThreadPool(const ElasticOptions& options);
 
     ~ThreadPool();
 
@@ -38,43 +154,334 @@ public:
 
     template<typename Func, typename ...Args>
     auto execute(Func&& func, Args&& ...args) {
-        using RetType = decltype(func(std::forward<Args>(args)...));
+        return ExecuteWith(nullptr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
 
-        auto pt = std::make_shared<std::packaged_task<RetType()>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
-        TaskPtr task = std::make_shared<Task>([pt] {
-            (*pt)();
-        });
+    /**
+     * @description: 提交一个不关心返回值的任务,不会创建 future
+     * @details 可调用对象(含绑定的参数)不超过 UniqueTask::kInlineSize 字节时,稳定状态下提交不分配内存
+     */
+    template<typename Func, typename ...Args>
+    void post(Func&& func, Args&& ...args) {
+        PostWith(nullptr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
 
-        // 放入任务
-        std::unique_lock<std::mutex> lock(m_taskMtx);
-        m_taskLists.push_back(task);
-        lock.unlock();
+    /**
+     * @description: 提交任务并返回 why::Future,可以通过 Then 继续挂接后续任务
+     * @details 只分配 Future 共享状态一次,任务的异常会传递给返回的 Future
+     */
+    template<typename Func, typename ...Args>
+    auto submit(Func&& func, Args&& ...args) {
+        return SubmitWith(nullptr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
 
-        // 唤醒一个线程
-        m_cv.notify_one();
+    /**
+     * @description: 指定优先级、截止时间或者完整调度属性提交任务,只支持 PRIORITY 模式
+     */
+    template<typename Func, typename ...Args>
+    auto execute(Priority priority, Func&& func, Args&& ...args) {
+        TaskAttr attr{};
+        attr.priority = priority;
+        return ExecuteWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template<typename Func, typename ...Args>
+    auto execute(TimePoint deadline, Func&& func, Args&& ...args) {
+        TaskAttr attr{};
+        attr.deadline = deadline;
+        return ExecuteWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template<typename Func, typename ...Args>
+    auto execute(TaskAttr attr, Func&& func, Args&& ...args) {
+        return ExecuteWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template<typename Func, typename ...Args>
+    void post(Priority priority, Func&& func, Args&& ...args) {
+        TaskAttr attr{};
+        attr.priority = priority;
+        PostWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template<typename Func, typename ...Args>
+    void post(TimePoint deadline, Func&& func, Args&& ...args) {
+        TaskAttr attr{};
+        attr.deadline = deadline;
+        PostWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template<typename Func, typename ...Args>
+    void post(TaskAttr attr, Func&& func, Args&& ...args) {
+        PostWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template<typename Func, typename ...Args>
+    auto submit(Priority priority, Func&& func, Args&& ...args) {
+        TaskAttr attr{};
+        attr.priority = priority;
+        return SubmitWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template<typename Func, typename ...Args>
+    auto submit(TimePoint deadline, Func&& func, Args&& ...args) {
+        TaskAttr attr{};
+        attr.deadline = deadline;
+        return SubmitWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
 
-        return pt->get_future();
+    template<typename Func, typename ...Args>
+    auto submit(TaskAttr attr, Func&& func, Args&& ...args) {
+        return SubmitWith(&attr, std::forward<Func>(func), std::forward<Args>(args)...);
     }
 
-    void Shutdown();
+    /**
+     * @description: 停止线程池,在条件变量上等待任务结束,不能在工作线程中调用
+     */
+    void Shutdown(ShutdownMode mode = ShutdownMode::FINISH_PENDING);
+
+    /**
+     * @description: 在 deadline 之前尽量执行完队列中的任务,超时后丢弃剩余任务,等待正在执行的任务结束后停止
+     * @return: 所有任务都在 deadline 之前执行完时返回 true
+     */
+    bool Shutdown(const std::chrono::steady_clock::time_point& deadline);
+
+    /**
+     * @description: 阻塞直到已经提交的任务(包括执行过程中新提交的任务)全部结束,不能在工作线程中调用
+     */
+    void WaitIdle();
+
+    /**
+     * @description: 设置 post 提交的任务抛出异常时的处理函数,在工作线程中调用,默认输出到标准错误
+     * @details execute 与 submit 提交的任务的异常保存在返回的 future 中,不会走到这里;
+     *          需要在 Start 之前设置
+     */
+    void SetExceptionHandler(ExceptionHandler handler) { m_exceptionHandler = std::move(handler); }
+
+    /**
+     * @description: PRIORITY 模式下每排队 aging 时间提升一个优先级,为 0 时严格按优先级调度,需要在 Start 之前设置
+     */
+    void SetPriorityAging(std::chrono::nanoseconds aging) { m_agingNs = aging.count(); }
+
+    /**
+     * @description: 设置工作线程的亲和性、NUMA、调度策略与栈大小,需要在 Start 之前设置,
+     *               参数无法应用(例如没有权限使用实时策略)时 Start 抛出异常
+     */
+    void SetWorkerOptions(const WorkerOptions& options) { m_workerOptions = options; }
+
+    /**
+     * @description: 已经提交但还没有结束的任务数
+     */
+    size_t GetPendingCount() const { return m_pending.load(std::memory_order_acquire); }
+
+    Mode GetMode() const { return m_mode; }
+
+    /**
+     * @description: 当前的线程数,弹性模式下会随负载变化
+     */
+    size_t GetThreadNum() const { return m_threadNum.load(std::memory_order_relaxed); }
+
+    bool IsElastic() const { return m_elastic; }
+
+    Stats GetStats();
 
 private:
+    /**
+     * @description: WORK_STEALING 模式下每个工作线程独有的数据
+     */
+    struct alignas(64) Worker {
+        WorkStealingDeque<Task*> deque;
+        uint64_t seed{0};
+    };
+
+    template<typename Func, typename ...Args>
+    auto ExecuteWith(TaskAttr* attr, Func&& func, Args&& ...args) {
+        using RetType = decltype(func(std::forward<Args>(args)...));
+
+        // packaged_task 直接保存在 Task 内部,只有 future 的共享状态需要分配内存
+        std::packaged_task<RetType()> pt(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        auto future = pt.get_future();
+        PushTask(Task([pt = std::move(pt)]() mutable {
+            pt();
+        }), attr);
+        return future;
+    }
+
+    template<typename Func, typename ...Args>
+    void PostWith(TaskAttr* attr, Func&& func, Args&& ...args) {
+        if constexpr (sizeof...(Args) == 0) {
+            PushTask(Task(std::forward<Func>(func)), attr);
+        } else {
+            PushTask(Task(std::bind(std::forward<Func>(func), std::forward<Args>(args)...)), attr);
+        }
+    }
+
+    template<typename Func, typename ...Args>
+    auto SubmitWith(TaskAttr* attr, Func&& func, Args&& ...args) {
+        using RetType = decltype(func(std::forward<Args>(args)...));
+
+        Promise<RetType> promise{};
+        auto future = promise.GetFuture();
+        PostWith(attr, [promise = std::move(promise),
+                        f = std::bind(std::forward<Func>(func), std::forward<Args>(args)...)]() mutable {
+            FulfillPromise(promise, f);
+        });
+        return future;
+    }
+
+    /**
+     * @description: attr 为空时按普通任务提交,PRIORITY 模式下作为没有截止时间的 NORMAL 任务
+     */
+    void PushTask(Task&& task, TaskAttr* attr = nullptr);
 
     // 工作线程的执行函数
     void Run();
     
-    TaskPtr GetTask();
+    bool GetTask(Task& task);
+
+    // WORK_STEALING 模式下工作线程的执行函数
+    void RunStealing(size_t idx);
+
+    /**
+     * @description: 依次从自己的队列、注入队列、其他线程的队列获取任务
+     */
+    bool FindTask(size_t idx, Task& task);
+
+    bool HasStealingWork();
+
+    /**
+     * @description: 执行(或者在取消时丢弃)一个任务,捕获异常,最后一个任务结束时唤醒等待的线程
+     */
+    void Execute(Task& task);
+
+    /**
+     * @description: 丢弃还没有执行的任务并等待正在执行的任务结束,然后停止工作线程
+     */
+    void Stop(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @description: 队列中没有等待执行的任务,调用者需要持有 m_taskMtx
+     */
+    bool QueueEmpty() const;
+
+    /**
+     * @description: PRIORITY 模式下按 aging 后的有效优先级选出队列,取出其中截止时间最早的任务,
+     *               已经过期的任务换成调用 on_expired 的任务,调用者需要持有 m_taskMtx
+     */
+    void TakePriorityTask(Task& task);
+
+    /**
+     * @description: 有线程阻塞时唤醒一个
+     */
+    void WakeOne();
+
+    /**
+     * @description: 弹性模式下队首任务排队太久且没有空闲线程时增加一个线程,调用者需要持有 m_taskMtx
+     */
+    void MaybeGrow(int64_t now_ns);
+
+    /**
+     * @description: 空闲超时的线程是否可以退出,调用者需要持有 m_taskMtx
+     */
+    bool CanRetire(int64_t now_ns) const;
+
+    /**
+     * @description: 回收已经退出的线程,调用者需要持有 m_taskMtx
+     */
+    void ReapRetired();
+
+    static int64_t NowNs();
+
+    /**
+     * @description: 第 idx 个创建的工作线程的参数
+     */
+    ThreadOptions MakeThreadOptions(size_t idx) const;
+
+    ThreadPtr SpawnWorker(std::function<void()> func);
 
 private:
     std::mutex m_threadMtx;
     std::mutex m_taskMtx;
-    size_t m_threadNum;
+    std::atomic<size_t> m_threadNum;
+    Mode m_mode;
     std::vector<ThreadPtr> m_threads;
-    std::list<TaskPtr> m_taskLists;
+    // SHARED 模式下的任务队列, WORK_STEALING 模式下的注入队列
+    RingBuffer<Task> m_taskLists;
+    std::vector<std::unique_ptr<Worker>> m_workers;
 
     std::condition_variable m_cv;
+    // 任务全部结束时通知 WaitIdle 与 Shutdown
+    std::condition_variable m_idleCv;
+    // 已经提交但还没有结束的任务数
+    std::atomic<size_t> m_pending{0};
+    // 为 true 时工作线程取出的任务直接丢弃
+    std::atomic<bool> m_cancelPending{false};
+    ExceptionHandler m_exceptionHandler;
+
+    WorkerOptions m_workerOptions;
+    // SPREAD/PACK 模式下工作线程依次绑定的 CPU
+    std::vector<int> m_placement;
+    // 已经创建的工作线程数,用作线程的下标
+    size_t m_spawned{0};
+
+    /**
+     * @description: PRIORITY 模式的队列元素,deadline 为 INT64_MAX 表示没有截止时间
+     */
+    struct PriorityTask {
+        Task task;
+        std::function<void()> on_expired;
+        int64_t deadline_ns;
+        int64_t enqueue_ns;
+        uint64_t seq;
+    };
+
+    /**
+     * @description: 堆的比较函数,截止时间早的在堆顶,相同时先提交的在堆顶
+     */
+    static bool PriorityLess(const PriorityTask& lhs, const PriorityTask& rhs);
+
+    /**
+     * @description: 一个优先级中任务的提交顺序,队首是等待最久的任务,aging 按它计算;
+     *               堆顶按截止时间排序,不一定是等待最久的任务
+     * @details 从堆中取走但还没到队首的任务的 seq 记在小根堆 taken 中,到达队首时再一起移除
+     */
+    struct PriorityArrivals {
+        RingBuffer<std::pair<uint64_t, int64_t>> fifo;
+        std::vector<uint64_t> taken;
+    };
+
+    /**
+     * @description: 返回 level 中等待最久的任务的入队时间,队列不能为空
+     */
+    int64_t OldestEnqueueNs(size_t level);
+
+    // PRIORITY 模式下每个优先级一个按 (deadline, seq) 排序的堆,由 m_taskMtx 保护
+    std::vector<PriorityTask> m_priorityQueues[kPriorityLevels];
+    PriorityArrivals m_priorityArrivals[kPriorityLevels];
+    size_t m_prioritySize{0};
+    uint64_t m_prioritySeq{0};
+    int64_t m_agingNs{std::chrono::nanoseconds(std::chrono::milliseconds(100)).count()};
+    uint64_t m_expiredTasks{0};
+
+    // 弹性模式的状态,除统计外都由 m_taskMtx 保护
+    bool m_elastic{false};
+    ElasticOptions m_elasticOptions;
+    bool m_started{false};
+    // 与 m_taskLists 一一对应的入队时间
+    RingBuffer<int64_t> m_enqueueNs;
+    size_t m_idleThreads{0};
+    size_t m_peakThreads{0};
+    int64_t m_lastGrowNs{0};
+    uint64_t m_grows{0};
+    uint64_t m_shrinks{0};
+    // 已经退出等待 join 的线程
+    std::vector<pid_t> m_retired;
+    LatencyHistogram m_queueWait;
+    // 阻塞在 m_cv 上的工作线程数与唤醒代数,仅 WORK_STEALING 模式使用
+    std::atomic<size_t> m_sleepers{0};
+    uint64_t m_wakeGen{0};
 
-    bool m_isTerminate{false};
+    std::atomic<bool> m_isTerminate{false};
 
 };
 
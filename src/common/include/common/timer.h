@@ -1,30 +1,213 @@
 /*
  * @Author: wuhanyi
  * @Date: 2022-04-29 16:19:45
- * @LastEditTime: 2022-05-05 20:32:14
+ * @LastEditTime: 2026-10-19 14:30:00
  * @FilePath: /basic_library/src/common/include/common/timer.h
- * @Description: 
- * 
- * Copyright (c) 2022 by wuhanyi, All Rights Reserved. 
+ * @Description:
+ *
+ * Copyright (c) 2022 by wuhanyi, All Rights Reserved.
  */
 #ifndef __WHY_TIMER_H__
 #define __WHY_TIMER_H__
 
 #include <functional>
 #include <memory>
-#include <set>
 #include <stdint.h>
 #include <mutex>
+#include <optional>
 #include <chrono>
-#include <unordered_map>
+#include <vector>
 #include <condition_variable>
 #include "threadpool.h"
+#include "histogram.h"
 
 namespace why {
 
 namespace Timer {
-    
+
+/**
+ * @description: 分层时间轮,时间以 tick 为单位,不加锁,由 TimerQueue 保护
+ * @details kLevels 层,每层 kSlots 个槽,第 L 层每个槽覆盖 kSlots^L 个 tick,共覆盖 2^32 个 tick,
+ *          超出范围的节点先放在最高层,级联时重新计算位置;
+ *          每个槽是一个侵入式双向链表,插入与删除都是 O(1),每层用位图记录非空的槽,
+ *          用于快速找到下一个需要处理的 tick
+ */
+class TimingWheel : public Noncopyable {
+public:
+    static constexpr int kSlotBits = 8;
+    static constexpr size_t kSlots = 1 << kSlotBits;
+    static constexpr int kLevels = 4;
+
+    /**
+     * @description: 侵入式节点,使用者继承它并设置 expire
+     */
+    struct Node {
+        Node* prev{nullptr};
+        Node* next{nullptr};
+        // 到期的 tick
+        uint64_t expire{0};
+        uint16_t slot{0};
+        uint8_t level{0};
+        bool linked{false};
+    };
+
+    explicit TimingWheel(uint64_t current_tick = 0) : m_current(current_tick) {}
+
+    /**
+     * @description: 插入节点,expire 早于当前 tick 的节点在下一次推进时到期
+     */
+    void Insert(Node* node);
+
+    void Remove(Node* node);
+
+    /**
+     * @description: 下一个需要处理的 tick(到期或需要级联),没有节点时返回 UINT64_MAX
+     */
+    uint64_t NextTick() const;
+
+    /**
+     * @description: 推进到 now(包含),到期的节点按到期顺序追加到 expired,跳过中间没有节点的 tick
+     */
+    void Advance(uint64_t now, std::vector<Node*>& expired);
+
+    /**
+     * @description: 取出所有节点
+     */
+    void TakeAll(std::vector<Node*>& out);
+
+    // 下一个还没有处理的 tick
+    uint64_t CurrentTick() const { return m_current; }
+
+    size_t Size() const { return m_size; }
+
+    bool Empty() const { return m_size == 0; }
+
+private:
+    void Link(Node* node, int level, size_t slot);
+
+    void Cascade(int level, size_t slot);
+
+    /**
+     * @description: 从 start 开始循环查找第 level 层第一个非空的槽,返回相对 start 的偏移,没有时返回 kSlots
+     */
+    size_t FindNextSlot(int level, size_t start) const;
+
+private:
+    uint64_t m_current;
+    size_t m_size{0};
+    Node* m_slots[kLevels][kSlots]{};
+    uint64_t m_bitmap[kLevels][kSlots / 64]{};
+};
+
+class TimerQueue;
+
+/**
+ * @description: 定时器的重复方式
+ * @details FIXED_RATE: 按计划时间间隔执行,下一次时间 = 上一次计划时间 + interval,不会因为回调耗时而漂移,
+ *                      错过的周期直接跳过,不会补执行
+ *          FIXED_DELAY: 上一次回调结束后再等待 interval
+ *          两种方式下同一个定时器的回调都不会并发执行
+ */
+enum class RepeatMode {
+    FIXED_RATE,
+    FIXED_DELAY
+};
+
+/**
+ * @description: 驱动线程的时钟源
+ * @details CONDVAR: 在条件变量上 wait_until
+ *          TIMERFD: 阻塞在 timerfd(CLOCK_MONOTONIC,绝对时间)上,新任务更早到期时直接重设 timerfd,
+ *                   不需要唤醒驱动线程;也可以不创建驱动线程,把 GetFd() 加入使用者自己的 epoll
+ *          PRECISE: 高精度模式,驱动线程先在条件变量上睡到到期前 spin_guard,再忙等 steady_clock 到到期时间,
+ *                   回调直接在驱动线程中执行,不经过线程池;触发精度由 tick 决定,通常配合微秒级的 tick 使用,
+ *                   回调需要足够短,否则会推迟后面的定时器
+ */
+enum class ClockSource {
+    CONDVAR,
+    TIMERFD,
+    PRECISE
+};
+
+/**
+ * @description: 定时器运行指标
+ */
+struct TimerStats {
+    // 驱动线程(或 HandleEvents)醒来的次数与频率
+    uint64_t wakeups{0};
+    double wakeups_per_sec{0};
+    // 已经开始执行的回调数
+    uint64_t fired{0};
+    // 抛出异常的回调数
+    uint64_t failed{0};
+    double elapsed_sec{0};
+    // 回调开始执行的时间相对计划时间的延迟,包含 slack 允许的部分
+    int64_t lateness_p50_ns{0};
+    int64_t lateness_p90_ns{0};
+    int64_t lateness_p99_ns{0};
+    int64_t lateness_p999_ns{0};
+    int64_t lateness_max_ns{0};
+    // PRECISE 模式下忙等消耗的时间,以及睡醒时已经超过到期时间的次数(说明 spin_guard 太小)
+    double spin_sec{0};
+    uint64_t late_wakeups{0};
+};
+
+/**
+ * @description: 定时器句柄,可以取消定时器或者修改间隔,定时器结束后操作返回 false
+ */
+class TimerId {
+friend class TimerQueue;
+public:
+    TimerId() = default;
+
+    /**
+     * @description: 取消定时器,回调正在执行时不会打断,但周期定时器不会再次触发
+     * @return: 定时器已经结束或已经取消时返回 false
+     */
+    bool Cancel();
+
+    /**
+     * @description: 一次性定时器改为从现在开始 interval 后触发,周期定时器修改间隔并从现在开始重新计时
+     * @details 回调正在执行时(包括在回调中调用),回调结束后按新的时间再放入时间轮,一次性定时器也会再触发一次
+     * @return: 定时器已经结束或已经取消时返回 false
+     */
+    template<typename T, typename R>
+    bool Reset(const std::chrono::duration<T, R>& interval) {
+        return ResetNs(std::chrono::duration_cast<std::chrono::nanoseconds>(interval));
+    }
+
+    /**
+     * @description: 定时器还没有结束也没有被取消
+     */
+    bool IsActive() const;
+
+    /**
+     * @description: 设置允许推迟执行的时间,窗口重叠的定时器会对齐到同一个 tick,在同一次唤醒中执行
+     * @details 对正在等待的定时器立即生效,周期定时器之后每次重新放入时间轮都使用新的 slack
+     */
+    template<typename T, typename R>
+    bool SetSlack(const std::chrono::duration<T, R>& slack) {
+        return SetSlackNs(std::chrono::duration_cast<std::chrono::nanoseconds>(slack));
+    }
+
+    bool Valid() const { return m_task != nullptr; }
+
+private:
+    struct Task;
+
+    TimerId(std::weak_ptr<TimerQueue> queue, std::shared_ptr<Task> task)
+        : m_queue(std::move(queue)), m_task(std::move(task)) {}
+
+    bool ResetNs(std::chrono::nanoseconds interval);
+
+    bool SetSlackNs(std::chrono::nanoseconds slack);
+
+private:
+    std::weak_ptr<TimerQueue> m_queue;
+    std::shared_ptr<Task> m_task;
+};
+
 class TimerQueue : public std::enable_shared_from_this<TimerQueue>, public Noncopyable {
+friend class TimerId;
 public:
     using ptr = std::shared_ptr<TimerQueue>;
 
@@ -33,70 +216,247 @@ public:
 
     using TimePoint = std::chrono::steady_clock::time_point;
     using Func = std::function<void()>;
-    // 定时器需要执行的任务
-    struct Task {
-        Task(Func&& func_, const TimePoint &time_) : func(func_), timepoint(time_) {}
-        Func func;
-        TimePoint timepoint;
-        bool operator<(const Task &t) const { return timepoint < t.timepoint; }
-    };
+    using Task = TimerId::Task;
     using TaskPtr = std::shared_ptr<Task>;
 
-    TimerQueue(int pool_size = 4);
+    // 无限次重复
+    static constexpr size_t kInfinite = SIZE_MAX;
+
+    struct Options {
+        // 执行到期任务的线程池大小
+        int pool_size{4};
+        // 时间轮的精度,任务最多推迟一个 tick 执行,不会提前执行
+        std::chrono::nanoseconds tick{std::chrono::milliseconds(1)};
+        ClockSource clock{ClockSource::CONDVAR};
+        // 为 false 时 Start 不创建驱动线程,使用者在 GetFd() 可读时调用 HandleEvents(),只支持 TIMERFD
+        bool driver_thread{true};
+        // 定时器默认的 slack,可以通过 TimerId::SetSlack 单独设置
+        std::chrono::nanoseconds default_slack{0};
+        // PRECISE 模式下提前醒来忙等的时间,需要大于线程唤醒的延迟抖动
+        std::chrono::nanoseconds spin_guard{std::chrono::microseconds(200)};
+        // 驱动线程绑定的 CPU,-1 表示不绑定
+        int cpu{-1};
+    };
+
+    TimerQueue(int pool_size = 4, std::chrono::nanoseconds tick = std::chrono::milliseconds(1));
+
+    explicit TimerQueue(const Options& options);
 
-    ~TimerQueue() = default;
+    ~TimerQueue();
 
     void Start();
 
+    /**
+     * @description: 取消无限次的周期定时器,等待其余任务都执行完毕后停止
+     */
     void Shutdown();
 
     template<typename F, typename ...Args>
-    void AddTaskAtTimePoint(const TimePoint& timepoint, F&& func, Args&& ...agrs) {
+    TimerId AddTaskAtTimePoint(const TimePoint& timepoint, F&& func, Args&& ...agrs) {
         Func f = std::bind(std::forward<F>(func), std::forward<Args>(agrs)...);
-        TaskPtr task = std::make_shared<Task>(std::move(f), timepoint);
-        std::unique_lock<std::mutex> lock(m_taskMtx);
-        m_tasks.insert(task);
-        lock.unlock();
-        // 这里实际上只会有一个线程阻塞在这个条件变量上面
-        m_cv.notify_all();
+        return Schedule(std::move(f), timepoint, std::chrono::nanoseconds(0), 1, RepeatMode::FIXED_RATE);
+    }
+
+    template<typename T, typename R, typename F, typename ...Args>
+    TimerId AddTaskAfterDuration(const Duration<T, R> &duration, F&& func, Args&& ...args) {
+        TimePoint timepoint = std::chrono::steady_clock::now() +
+                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration);
+        return AddTaskAtTimePoint(timepoint, std::forward<F>(func), std::forward<Args>(args)...);
     }
 
+    /**
+     * @description: 每隔 interval 执行一次,共执行 repeat_num 次(kInfinite 表示无限次),只占用一个定时器节点
+     */
     template<typename T, typename R, typename F, typename ...Args>
-    void AddTaskAfterDuration(Duration<T, R> &duration, F&& func, Args&& ...args) {
-        TimePoint timepoint = duration + std::chrono::steady_clock::now();
-        AddTaskAtTimePoint(timepoint, std::forward<F>(func), std::forward<Args>(args)...);
+    TimerId AddRepeatTask(const Duration<T, R> &interval, size_t repeat_num, F&& func, Args&& ...args) {
+        return AddRepeatTask(interval, repeat_num, RepeatMode::FIXED_RATE, std::forward<F>(func), std::forward<Args>(args)...);
     }
 
     template<typename T, typename R, typename F, typename ...Args>
-    void AddRepeatTask(Duration<T, R> &interval, size_t repeat_num, F&& func, Args&& ...args) {
-        TimePoint timepoint = std::chrono::steady_clock::now();
-        for (size_t i = 0; i < repeat_num; i++) {
-            timepoint += interval;
-            AddTaskAtTimePoint(timepoint, std::forward<F>(func), std::forward<Args>(args)...);
+    TimerId AddRepeatTask(const Duration<T, R> &interval, size_t repeat_num, RepeatMode mode, F&& func, Args&& ...args) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(interval);
+        CHECK_THROW(ns.count() > 0, "repeat interval must be positive");
+        Func f = std::bind(std::forward<F>(func), std::forward<Args>(args)...);
+        if (!repeat_num) {
+            return TimerId{};
         }
+        TimePoint timepoint = std::chrono::steady_clock::now() +
+                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(ns);
+        return Schedule(std::move(f), timepoint, ns, repeat_num, mode);
     }
 
+    /**
+     * @description: 无限次的周期定时器,通过返回的 TimerId 取消
+     */
+    template<typename T, typename R, typename F, typename ...Args>
+    TimerId AddPeriodicTask(const Duration<T, R> &interval, RepeatMode mode, F&& func, Args&& ...args) {
+        return AddRepeatTask(interval, kInfinite, mode, std::forward<F>(func), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @description: 在 timepoint 执行任务,返回任务结果的 Future
+     */
+    template<typename F, typename ...Args>
+    auto AsyncAtTimePoint(const TimePoint& timepoint, F&& func, Args&& ...args) {
+        using RetType = decltype(func(std::forward<Args>(args)...));
+        // Func 是 std::function,要求可拷贝,所以 Promise 用 shared_ptr 包装
+        auto promise = std::make_shared<Promise<RetType>>();
+        auto future = promise->GetFuture();
+        AddTaskAtTimePoint(timepoint, [promise, f = std::bind(std::forward<F>(func), std::forward<Args>(args)...)]() mutable {
+            FulfillPromise(*promise, f);
+        });
+        return future;
+    }
+
+    template<typename T, typename R, typename F, typename ...Args>
+    auto AsyncAfterDuration(const Duration<T, R> &duration, F&& func, Args&& ...args) {
+        TimePoint timepoint = std::chrono::steady_clock::now() +
+                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration);
+        return AsyncAtTimePoint(timepoint, std::forward<F>(func), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @description: 还没有到期的任务数
+     */
+    size_t GetPendingCount();
+
+    /**
+     * @description: TIMERFD 时钟源的 timerfd,有定时器到期时可读,其他时钟源返回 -1
+     */
+    int GetFd() const { return m_timerFd; }
+
+    /**
+     * @description: 不使用驱动线程时,在 GetFd() 可读后调用,执行到期的任务并重新设置 timerfd
+     * @details 不能在多个线程中并发调用
+     */
+    void HandleEvents();
+
+    TimerStats GetStats() const;
+
+    const LatencyHistogram& GetLatenessHistogram() const { return m_lateness; }
+
 private:
-    // demon 线程会执行这个函数
+    TimerId Schedule(Func&& func, const TimePoint& timepoint, std::chrono::nanoseconds interval,
+                     size_t repeat, RepeatMode mode);
+
+    /**
+     * @description: 把任务放入时间轮,必要时唤醒驱动线程,调用者需要持有 m_taskMtx
+     */
+    void Arm(Task* task);
+
+    bool Cancel(const TaskPtr& task);
+
+    bool Reset(const TaskPtr& task, std::chrono::nanoseconds interval);
+
+    bool SetSlack(const TaskPtr& task, std::chrono::nanoseconds slack);
+
+    /**
+     * @description: 回调执行完后由线程池线程调用,周期定时器在这里重新放入时间轮,复用同一个节点
+     */
+    void OnFired(const TaskPtr& task);
+
+    // 驱动时间轮的线程执行这个函数,睡眠到下一个非空的槽再推进
     // 传给 demon 线程时，这里要用 enable_for_this,因为这是 demon 线程执行的函数,不受控制
     void LocalRun();
 
-    struct cmp {
-        bool operator()(const TaskPtr t1, const TaskPtr t2) {
-            return t1->timepoint < t2->timepoint;
-        }
-    };
+    /**
+     * @description: 推进时间轮并把到期任务交给线程池,交给线程池时会释放锁
+     * @return: 是否有任务到期
+     */
+    bool DispatchExpired(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @description: 执行回调并记录延迟,结束后调用 OnFired
+     */
+    void RunTask(const TaskPtr& task);
+
+    /**
+     * @description: PRECISE 模式的等待,先睡到 next 之前 spin_guard,再释放锁忙等到 next,
+     *               期间有更早的任务加入时提前返回
+     */
+    void WaitPrecise(std::unique_lock<std::mutex>& lock, uint64_t next);
+
+    /**
+     * @description: 让时钟源在 tick 唤醒驱动线程,UINT64_MAX 表示不需要唤醒,调用者需要持有 m_taskMtx
+     */
+    void ArmClock(uint64_t tick);
+
+    // 向上取整,保证任务不会提前执行
+    uint64_t ToTick(const TimePoint& timepoint) const;
+
+    /**
+     * @description: 在 [timepoint, timepoint + slack] 中选一个低位尽量多为 0 的 tick,
+     *               使窗口重叠的定时器落到同一个 tick
+     */
+    uint64_t ExpireTick(const Task* task) const;
+
+    uint64_t NowTick() const;
+
+    TimePoint TickToTime(uint64_t tick) const;
 
 private:
     std::mutex m_taskMtx;
-    std::set<TaskPtr, cmp> m_tasks; 
+    TimingWheel m_wheel;
+    const int64_t m_tickNs;
+    const TimePoint m_start;
+    const ClockSource m_clock;
+    const bool m_driverThread;
+    const std::chrono::nanoseconds m_defaultSlack;
+    const std::chrono::nanoseconds m_spinGuard;
+    const int m_cpu;
+    int m_timerFd{-1};
     ThreadPool m_threadPool;
+    // 唤醒驱动线程
     std::condition_variable m_cv;
+    // 通知 Shutdown 任务已经全部执行完毕
+    std::condition_variable m_drainCv;
+    // 驱动线程计划醒来的 tick,新任务早于它时才需要唤醒驱动线程;
+    // 在锁内修改,PRECISE 模式忙等时不持有锁读取它判断是否有更早的任务
+    std::atomic<uint64_t> m_nextWake{0};
+    // 已经交给线程池但回调还没有结束的任务数
+    size_t m_inflight{0};
+    // 驱动线程复用的临时数组,避免每次唤醒都分配内存
+    std::vector<TimingWheel::Node*> m_expired;
+    std::vector<TaskPtr> m_running;
 
+    bool m_isStopping{false};
     bool m_isTerminate{false};
+
+    std::atomic<uint64_t> m_wakeups{0};
+    std::atomic<uint64_t> m_lateWakeups{0};
+    std::atomic<int64_t> m_spinNs{0};
+    std::atomic<uint64_t> m_failed{0};
+    LatencyHistogram m_lateness;
+};
+
+/**
+ * @description: 定时器节点,由时间轮和 TimerId 共享,周期定时器每次触发都复用同一个节点
+ */
+struct TimerId::Task : public TimingWheel::Node {
+    enum class State : uint8_t {
+        PENDING,    // 在时间轮中等待
+        RUNNING,    // 回调已经交给线程池
+        DONE        // 已经结束或取消
+    };
+
+    TimerQueue::Func func;
+    TimerQueue::TimePoint timepoint;
+    // 为 0 表示一次性定时器
+    std::chrono::nanoseconds interval{0};
+    // 剩余执行次数
+    size_t remain{1};
+    // 允许推迟执行的时间
+    std::chrono::nanoseconds slack{0};
+    RepeatMode mode{RepeatMode::FIXED_RATE};
+    State state{State::PENDING};
+    bool cancelled{false};
+    // 回调执行期间调用 Reset 时记录新的触发时间,回调结束后按它重新放入时间轮
+    std::optional<TimerQueue::TimePoint> reset_timepoint;
+    // 在时间轮中或正在执行时持有自己,结束后释放
+    std::shared_ptr<Task> self;
 };
 }
 
 }
 
-#endif
\ No newline at end of file
+#endif
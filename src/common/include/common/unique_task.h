@@ -0,0 +1,122 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 11:40:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 11:40:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/unique_task.h
+ * @Description: 只能移动、带小缓冲区优化的任务类型
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_UNIQUE_TASK_H__
+#define __WHY_UNIQUE_TASK_H__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace why {
+
+/**
+ * @description: 类似 std::function<void()>,但是只能移动,可以保存 packaged_task 等只能移动的可调用对象
+ * @details 不超过 kInlineSize 字节且移动构造不抛异常的可调用对象直接保存在对象内部,不会分配堆内存
+ */
+class UniqueTask {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    UniqueTask() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, UniqueTask>::value>>
+    UniqueTask(F&& func) {
+        using Func = std::decay_t<F>;
+        if constexpr (IsInline<Func>()) {
+            new (m_storage) Func(std::forward<F>(func));
+            m_ops = &InlineOps<Func>::kOps;
+        } else {
+            *reinterpret_cast<Func**>(m_storage) = new Func(std::forward<F>(func));
+            m_ops = &HeapOps<Func>::kOps;
+        }
+    }
+
+    UniqueTask(UniqueTask&& other) noexcept : m_ops(other.m_ops) {
+        if (m_ops) {
+            m_ops->move(m_storage, other.m_storage);
+            other.m_ops = nullptr;
+        }
+    }
+
+    UniqueTask& operator=(UniqueTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            m_ops = other.m_ops;
+            if (m_ops) {
+                m_ops->move(m_storage, other.m_storage);
+                other.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    UniqueTask(const UniqueTask&) = delete;
+    UniqueTask& operator=(const UniqueTask&) = delete;
+
+    ~UniqueTask() { Reset(); }
+
+    void operator()() { m_ops->invoke(m_storage); }
+
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    void Reset() {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    /**
+     * @description: Func 是否会保存在对象内部
+     */
+    template<typename Func>
+    static constexpr bool IsInline() {
+        return sizeof(Func) <= kInlineSize && alignof(Func) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<Func>::value;
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        // 从 src 移动构造到 dst,并析构 src
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename Func>
+    struct InlineOps {
+        static void Invoke(void* storage) { (*static_cast<Func*>(storage))(); }
+        static void Move(void* dst, void* src) noexcept {
+            new (dst) Func(std::move(*static_cast<Func*>(src)));
+            static_cast<Func*>(src)->~Func();
+        }
+        static void Destroy(void* storage) noexcept { static_cast<Func*>(storage)->~Func(); }
+        static constexpr Ops kOps{&Invoke, &Move, &Destroy};
+    };
+
+    template<typename Func>
+    struct HeapOps {
+        static Func*& Get(void* storage) { return *static_cast<Func**>(storage); }
+        static void Invoke(void* storage) { (*Get(storage))(); }
+        static void Move(void* dst, void* src) noexcept { *static_cast<Func**>(dst) = Get(src); }
+        static void Destroy(void* storage) noexcept { delete Get(storage); }
+        static constexpr Ops kOps{&Invoke, &Move, &Destroy};
+    };
+
+private:
+    alignas(std::max_align_t) unsigned char m_storage[kInlineSize];
+    const Ops* m_ops{nullptr};
+};
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 11:05:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 11:05:00
+ * @FilePath: /cpp_basic_library/src/common/include/common/work_stealing_deque.h
+ * @Description: Chase-Lev 无锁工作窃取双端队列
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_WORK_STEALING_DEQUE_H__
+#define __WHY_WORK_STEALING_DEQUE_H__
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include "noncopyable.h"
+
+namespace why {
+
+/**
+ * @description: Chase-Lev 工作窃取队列(Lê et al. 2013 的 C11 内存序版本)
+ * @details 只有所属线程可以调用 Push/Pop(从底部操作),其他线程通过 Steal 从顶部窃取
+ *          T 需要是可以放进 std::atomic 的平凡类型,通常是指针
+ *          扩容后旧数组延迟到析构时释放,因为窃取者可能仍在读取旧数组
+ */
+template<typename T>
+class WorkStealingDeque : public Noncopyable {
+public:
+    explicit WorkStealingDeque(int64_t capacity = 256)
+        : m_array(new Array(RoundUpPowerOfTwo(capacity))) {}
+
+    ~WorkStealingDeque() {
+        delete m_array.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @description: 所属线程在底部压入一个元素
+     */
+    void Push(T item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        Array* a = m_array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = Grow(a, b, t);
+        }
+        a->Put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @description: 所属线程从底部弹出一个元素(LIFO)
+     * @return: 队列为空或者最后一个元素被窃取时返回 false
+     */
+    bool Pop(T& item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        if (t > b) {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = a->Get(b);
+        if (t == b) {
+            // 只剩最后一个元素,与窃取者竞争
+            bool ok = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return ok;
+        }
+        return true;
+    }
+
+    /**
+     * @description: 其他线程从顶部窃取一个元素(FIFO)
+     * @return: 队列为空或者竞争失败时返回 false
+     */
+    bool Steal(T& item) {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        Array* a = m_array.load(std::memory_order_acquire);
+        item = a->Get(t);
+        return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed);
+    }
+
+    /**
+     * @description: 元素个数的近似值
+     */
+    int64_t Size() const {
+        int64_t b = m_bottom.load(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_seq_cst);
+        return b > t ? b - t : 0;
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+private:
+    struct Array {
+        explicit Array(int64_t cap) : capacity(cap), mask(cap - 1), buffer(new std::atomic<T>[cap]) {}
+
+        T Get(int64_t idx) const { return buffer[idx & mask].load(std::memory_order_relaxed); }
+        void Put(int64_t idx, T item) { buffer[idx & mask].store(item, std::memory_order_relaxed); }
+
+        int64_t capacity;
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> buffer;
+    };
+
+    static int64_t RoundUpPowerOfTwo(int64_t val) {
+        int64_t cap = 2;
+        while (cap < val) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    Array* Grow(Array* old, int64_t b, int64_t t) {
+        Array* a = new Array(old->capacity * 2);
+        for (int64_t i = t; i < b; ++i) {
+            a->Put(i, old->Get(i));
+        }
+        m_garbage.emplace_back(old);
+        m_array.store(a, std::memory_order_release);
+        return a;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> m_top{0};
+    alignas(64) std::atomic<int64_t> m_bottom{0};
+    std::atomic<Array*> m_array;
+    // 扩容前的旧数组,只有所属线程访问
+    std::vector<std::unique_ptr<Array>> m_garbage;
+};
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "common.h"
+#include <algorithm>
+
+namespace why {
+
+static uintptr_t AlignUp(uintptr_t ptr, size_t align) {
+    return (ptr + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+}
+
+Arena::Arena(size_t chunk_size) : m_chunkSize(std::max<size_t>(chunk_size, 64)), m_nextChunkSize(m_chunkSize) {}
+
+Arena::Arena(void* buffer, size_t size, size_t chunk_size)
+    : m_ptr(reinterpret_cast<uintptr_t>(buffer)),
+      m_end(reinterpret_cast<uintptr_t>(buffer) + size),
+      m_buffer(buffer),
+      m_bufferSize(size),
+      m_chunkSize(std::max<size_t>(chunk_size, 64)),
+      m_nextChunkSize(m_chunkSize) {}
+
+Arena::~Arena() {
+    Release();
+}
+
+void* Arena::AllocateSlow(size_t size, size_t align) {
+    uintptr_t ptr = AlignUp(m_ptr, align);
+    if (m_end && ptr >= m_ptr && ptr <= m_end && size <= m_end - ptr) {
+        m_ptr = ptr + size;
+        m_used += size;
+        return reinterpret_cast<void*>(ptr);
+    }
+
+    // 块的起始地址只按 max_align_t 对齐,多申请 align 字节保证对齐后放得下
+    size_t need = size + align;
+    if (m_chunks && need > m_nextChunkSize / 4) {
+        Chunk* chunk = NewChunk(need);
+        chunk->prev = m_chunks->prev;
+        m_chunks->prev = chunk;
+        m_used += size;
+        return reinterpret_cast<void*>(AlignUp(ChunkBegin(chunk), align));
+    }
+
+    Chunk* chunk = NewChunk(std::max(m_nextChunkSize, need));
+    m_nextChunkSize = std::min(m_nextChunkSize * 2, kMaxChunkSize);
+    chunk->prev = m_chunks;
+    m_chunks = chunk;
+    ptr = AlignUp(ChunkBegin(chunk), align);
+    m_ptr = ptr + size;
+    m_end = ChunkBegin(chunk) + chunk->size;
+    m_used += size;
+    return reinterpret_cast<void*>(ptr);
+}
+
+Arena::Chunk* Arena::NewChunk(size_t size) {
+    auto chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+    chunk->prev = nullptr;
+    chunk->size = size;
+    m_capacity += size;
+    return chunk;
+}
+
+void Arena::RunCleanups() {
+    for (Cleanup* cleanup = m_cleanups; cleanup; cleanup = cleanup->next) {
+        if (cleanup->obj) {
+            cleanup->destroy(cleanup->obj);
+        }
+    }
+    m_cleanups = nullptr;
+}
+
+void Arena::FreeChunks(Chunk* keep) {
+    Chunk* chunk = m_chunks;
+    while (chunk) {
+        Chunk* prev = chunk->prev;
+        if (chunk != keep) {
+            m_capacity -= chunk->size;
+            ::operator delete(chunk);
+        }
+        chunk = prev;
+    }
+    if (keep) {
+        keep->prev = nullptr;
+    }
+    m_chunks = keep;
+}
+
+void Arena::Reset() {
+    RunCleanups();
+    FreeChunks(m_chunks);
+    if (m_chunks) {
+        m_ptr = ChunkBegin(m_chunks);
+        m_end = m_ptr + m_chunks->size;
+    } else {
+        m_ptr = reinterpret_cast<uintptr_t>(m_buffer);
+        m_end = m_ptr + m_bufferSize;
+    }
+    m_used = 0;
+}
+
+void Arena::Release() {
+    RunCleanups();
+    FreeChunks(nullptr);
+    m_ptr = reinterpret_cast<uintptr_t>(m_buffer);
+    m_end = m_ptr + m_bufferSize;
+    m_nextChunkSize = m_chunkSize;
+    m_used = 0;
+}
+
+}
@@ -0,0 +1,223 @@
+#include "common.h"
+#include <fstream>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace why {
+
+static size_t RoundUp(size_t val, size_t align) {
+    return (val + align - 1) / align * align;
+}
+
+HugePageRegion::HugePageRegion(size_t size, const HugePageOptions& options) {
+    CHECK_THROW(size > 0, "HugePageRegion size must be positive");
+    size_t huge = GetHugePageSize();
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (options.hugetlb) {
+        size_t len = RoundUp(size, huge);
+        // 大页池不足时 mmap 直接失败,不会在缺页时 SIGBUS
+        void* ptr = mmap(nullptr, len, prot, flags | MAP_HUGETLB | (options.prefault ? MAP_POPULATE : 0), -1, 0);
+        if (ptr != MAP_FAILED) {
+            m_data = ptr;
+            m_size = len;
+            m_backing = Backing::HUGETLB;
+        }
+    }
+    if (!m_data && options.transparent && IsTransparentAvailable()) {
+        size_t len = RoundUp(size, huge);
+        // 透明大页只能映射按大页对齐的区间,多映射一个大页再裁掉首尾
+        void* raw = mmap(nullptr, len + huge, prot, flags, -1, 0);
+        CHECK_THROW(raw != MAP_FAILED, "mmap %zu bytes failed:%s", len + huge, strerror(errno));
+        uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = RoundUp(begin, huge);
+        if (aligned > begin) {
+            munmap(raw, aligned - begin);
+        }
+        if (begin + huge > aligned) {
+            munmap(reinterpret_cast<void*>(aligned + len), begin + huge - aligned);
+        }
+        m_data = reinterpret_cast<void*>(aligned);
+        m_size = len;
+        m_backing = madvise(m_data, m_size, MADV_HUGEPAGE) == 0 ? Backing::TRANSPARENT : Backing::NORMAL;
+    }
+    if (!m_data) {
+        size_t len = RoundUp(size, page);
+        void* ptr = mmap(nullptr, len, prot, flags | (options.prefault ? MAP_POPULATE : 0), -1, 0);
+        CHECK_THROW(ptr != MAP_FAILED, "mmap %zu bytes failed:%s", len, strerror(errno));
+        m_data = ptr;
+        m_size = len;
+        m_backing = Backing::NORMAL;
+    }
+
+    if (options.prefault && m_backing == Backing::TRANSPARENT) {
+        // madvise 之后再访问,缺页时直接分配大页;MAP_POPULATE 在 madvise 之前就会按普通页填充
+        for (size_t off = 0; off < m_size; off += page) {
+            static_cast<volatile char*>(m_data)[off] = 0;
+        }
+    }
+    if (options.lock) {
+        m_locked = mlock(m_data, m_size) == 0;
+    }
+}
+
+HugePageRegion::HugePageRegion(HugePageRegion&& rhs) noexcept
+    : m_data(rhs.m_data), m_size(rhs.m_size), m_backing(rhs.m_backing), m_locked(rhs.m_locked) {
+    rhs.m_data = nullptr;
+    rhs.m_size = 0;
+    rhs.m_backing = Backing::NONE;
+    rhs.m_locked = false;
+}
+
+HugePageRegion& HugePageRegion::operator=(HugePageRegion&& rhs) noexcept {
+    if (this != &rhs) {
+        Unmap();
+        std::swap(m_data, rhs.m_data);
+        std::swap(m_size, rhs.m_size);
+        std::swap(m_backing, rhs.m_backing);
+        std::swap(m_locked, rhs.m_locked);
+    }
+    return *this;
+}
+
+HugePageRegion::~HugePageRegion() {
+    Unmap();
+}
+
+void HugePageRegion::Unmap() {
+    if (m_data) {
+        // munmap 会同时解除 mlock
+        munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+        m_backing = Backing::NONE;
+        m_locked = false;
+    }
+}
+
+const char* HugePageRegion::BackingToString(Backing backing) {
+    switch (backing) {
+        case Backing::HUGETLB:
+            return "hugetlb";
+        case Backing::TRANSPARENT:
+            return "transparent";
+        case Backing::NORMAL:
+            return "normal";
+        default:
+            return "none";
+    }
+}
+
+size_t HugePageRegion::GetHugePageSize() {
+    static const size_t s_size = [] {
+        std::ifstream ifs("/proc/meminfo");
+        std::string line{};
+        while (std::getline(ifs, line)) {
+            size_t kb = 0;
+            if (sscanf(line.c_str(), "Hugepagesize: %zu kB", &kb) == 1 && kb) {
+                return kb * 1024;
+            }
+        }
+        return static_cast<size_t>(2 << 20);
+    }();
+    return s_size;
+}
+
+bool HugePageRegion::IsTransparentAvailable() {
+    static const bool s_available = [] {
+        std::ifstream ifs("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string line{};
+        return std::getline(ifs, line) && line.find("[never]") == std::string::npos;
+    }();
+    return s_available;
+}
+
+/**
+ * @description: HugePageAllocator 的全局状态,泄漏一个实例,已分配的内存在进程退出前一直有效
+ */
+struct HugePageState {
+    Mutex mutex;
+    HugePageAllocator::Config config;
+    std::atomic<bool> enabled{false};
+    std::vector<HugePageRegion> regions;
+    uintptr_t ptr{0};
+    uintptr_t end{0};
+    size_t used{0};
+};
+
+static HugePageState& GetHugePageState() {
+    static HugePageState* s_state = new HugePageState();
+    return *s_state;
+}
+
+void HugePageAllocator::Configure(const Config& config) {
+    auto& state = GetHugePageState();
+    LOCK_GUARD_T(Mutex) lock(state.mutex);
+    state.config = config;
+    state.enabled.store(config.enabled, std::memory_order_release);
+}
+
+HugePageAllocator::Config HugePageAllocator::GetConfig() {
+    auto& state = GetHugePageState();
+    LOCK_GUARD_T(Mutex) lock(state.mutex);
+    return state.config;
+}
+
+bool HugePageAllocator::IsEnabled() {
+    return GetHugePageState().enabled.load(std::memory_order_acquire);
+}
+
+void* HugePageAllocator::Allocate(size_t size, size_t align) {
+    auto& state = GetHugePageState();
+    if (!state.enabled.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    LOCK_GUARD_T(Mutex) lock(state.mutex);
+    uintptr_t ptr = RoundUp(state.ptr, align);
+    if (state.ptr && ptr + size <= state.end) {
+        state.ptr = ptr + size;
+        state.used += size;
+        return reinterpret_cast<void*>(ptr);
+    }
+    // 区域起始地址按页对齐,足以满足常见的对齐要求
+    if (size + align > state.config.region_size) {
+        state.regions.emplace_back(size + align, state.config.options);
+        state.used += size;
+        return reinterpret_cast<void*>(RoundUp(reinterpret_cast<uintptr_t>(state.regions.back().GetData()), align));
+    }
+    state.regions.emplace_back(state.config.region_size, state.config.options);
+    auto& region = state.regions.back();
+    ptr = RoundUp(reinterpret_cast<uintptr_t>(region.GetData()), align);
+    state.ptr = ptr + size;
+    state.end = reinterpret_cast<uintptr_t>(region.GetData()) + region.GetSize();
+    state.used += size;
+    return reinterpret_cast<void*>(ptr);
+}
+
+HugePageStats HugePageAllocator::GetStats() {
+    auto& state = GetHugePageState();
+    LOCK_GUARD_T(Mutex) lock(state.mutex);
+    HugePageStats stats{};
+    for (auto& region : state.regions) {
+        switch (region.GetBacking()) {
+            case HugePageRegion::Backing::HUGETLB:
+                ++stats.hugetlb_regions;
+                break;
+            case HugePageRegion::Backing::TRANSPARENT:
+                ++stats.transparent_regions;
+                break;
+            default:
+                ++stats.normal_regions;
+                break;
+        }
+        stats.mapped_bytes += region.GetSize();
+    }
+    stats.used_bytes = state.used;
+    return stats;
+}
+
+}
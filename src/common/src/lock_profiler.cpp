@@ -0,0 +1,99 @@
+#include "common.h"
+#include <algorithm>
+#include <map>
+
+namespace why {
+
+// 所有注册过的加锁位置组成的单链表,只在头部插入,不会删除
+static std::atomic<LockSite*> s_sites{nullptr};
+
+void LockSite::Register() {
+    bool expected = false;
+    if (!m_registered.compare_exchange_strong(expected, true, std::memory_order_relaxed)) {
+        return;
+    }
+    LockSite* head = s_sites.load(std::memory_order_relaxed);
+    do {
+        m_next = head;
+    } while (!s_sites.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::vector<LockSiteStats> LockProfiler::GetTopContended(size_t n) {
+    // 同一个位置可能有多个 LockSite,合并后再计算分位数
+    struct Merged {
+        std::vector<const LockSite*> sites;
+        uint64_t acquisitions{0};
+        uint64_t contended{0};
+        uint64_t wait_total_ns{0};
+    };
+    std::map<std::string, Merged> merged{};
+    for (auto site = s_sites.load(std::memory_order_acquire); site; site = site->m_next) {
+        auto& item = merged[std::string(site->m_file) + ":" + std::to_string(site->m_line)];
+        item.sites.push_back(site);
+        item.acquisitions += site->m_acquisitions.load(std::memory_order_relaxed);
+        item.contended += site->m_contended.load(std::memory_order_relaxed);
+        item.wait_total_ns += static_cast<uint64_t>(site->m_wait.Mean() * site->m_wait.Count());
+    }
+
+    std::vector<LockSiteStats> result{};
+    for (auto& [name, item] : merged) {
+        LockSiteStats stats{};
+        stats.site = name;
+        stats.acquisitions = item.acquisitions;
+        stats.contended = item.contended;
+        stats.wait_total_ns = item.wait_total_ns;
+        // 多个实例时取各自分位数的最大值,是合并分位数的上界
+        for (auto site : item.sites) {
+            stats.wait_p50_ns = std::max(stats.wait_p50_ns, site->m_wait.Percentile(0.5));
+            stats.wait_p99_ns = std::max(stats.wait_p99_ns, site->m_wait.Percentile(0.99));
+            stats.wait_max_ns = std::max(stats.wait_max_ns, site->m_wait.Max());
+            stats.hold_p50_ns = std::max(stats.hold_p50_ns, site->m_hold.Percentile(0.5));
+            stats.hold_p99_ns = std::max(stats.hold_p99_ns, site->m_hold.Percentile(0.99));
+            stats.hold_max_ns = std::max(stats.hold_max_ns, site->m_hold.Max());
+        }
+        result.push_back(std::move(stats));
+    }
+    std::sort(result.begin(), result.end(), [](const LockSiteStats& lhs, const LockSiteStats& rhs) {
+        if (lhs.wait_total_ns != rhs.wait_total_ns) {
+            return lhs.wait_total_ns > rhs.wait_total_ns;
+        }
+        return lhs.contended > rhs.contended;
+    });
+    if (n && result.size() > n) {
+        result.resize(n);
+    }
+    return result;
+}
+
+std::string LockProfiler::ToYamlString(size_t n) {
+    YAML::Node node;
+    for (auto& stats : GetTopContended(n)) {
+        YAML::Node site;
+        site["site"] = stats.site;
+        site["acquisitions"] = stats.acquisitions;
+        site["contended"] = stats.contended;
+        site["contention_ratio"] = stats.GetContentionRatio();
+        site["wait_total_ns"] = stats.wait_total_ns;
+        site["wait_p50_ns"] = stats.wait_p50_ns;
+        site["wait_p99_ns"] = stats.wait_p99_ns;
+        site["wait_max_ns"] = stats.wait_max_ns;
+        site["hold_p50_ns"] = stats.hold_p50_ns;
+        site["hold_p99_ns"] = stats.hold_p99_ns;
+        site["hold_max_ns"] = stats.hold_max_ns;
+        node.push_back(site);
+    }
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+}
+
+void LockProfiler::Reset() {
+    for (auto site = s_sites.load(std::memory_order_acquire); site; site = site->m_next) {
+        site->m_acquisitions.store(0, std::memory_order_relaxed);
+        site->m_contended.store(0, std::memory_order_relaxed);
+        site->m_wait.Reset();
+        site->m_hold.Reset();
+    }
+}
+
+}
@@ -1,25 +1,248 @@
 #include "common.h"
+#include <algorithm>
+#include <climits>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <thread>
 
 namespace why {
 
-Semaphore::Semaphore(uint32_t val) {
-    if (sem_init(&m_semaphore, 0, val)) {
-        CHECK_THROW(false, "sem_init failed");
-    }
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32 bit word");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Semaphore waits on half of a 64 bit word");
+
+// 单核机器上持锁的线程不可能同时运行,自旋没有意义
+static const bool s_multiCore = std::thread::hardware_concurrency() > 1;
+
+void Futex::Wait(std::atomic<uint32_t>* addr, uint32_t expected) {
+    // 值已经改变(EAGAIN)或者被信号打断(EINTR)时直接返回,由调用者重新检查条件
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+void Futex::Wake(std::atomic<uint32_t>* addr, uint32_t count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE,
+            std::min<uint32_t>(count, INT_MAX), nullptr, nullptr, 0);
+}
+
+void Futex::WakeAll(std::atomic<uint32_t>* addr) {
+    Wake(addr, INT_MAX);
+}
+
+std::atomic<uint32_t>* Semaphore::CountWord() {
+    // 与 glibc 的 sem_t 相同,直接在 64 位状态的低 32 位上等待
+    auto word = reinterpret_cast<std::atomic<uint32_t>*>(&m_state);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    ++word;
+#endif
+    return word;
 }
 
-Semaphore::~Semaphore() {
-    sem_destroy(&m_semaphore);
+bool Semaphore::TryWait() {
+    uint64_t state = m_state.load(std::memory_order_relaxed);
+    while (static_cast<uint32_t>(state) > 0) {
+        if (m_state.compare_exchange_weak(state, state - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void Semaphore::Wait() {
-    int ret = sem_wait(&m_semaphore);
-    CHECK_THROW(ret == 0, "sem_wait failed, ret is:%d", ret);
+    if (TryWait()) {
+        return;
+    }
+    // 登记等待者与 Post 增加计数是对同一个字的原子操作,不会丢失唤醒
+    m_state.fetch_add(kWaiterOne, std::memory_order_relaxed);
+    uint64_t state = m_state.load(std::memory_order_relaxed);
+    while (true) {
+        if (static_cast<uint32_t>(state) == 0) {
+            Futex::Wait(CountWord(), 0);
+            state = m_state.load(std::memory_order_relaxed);
+        } else if (m_state.compare_exchange_weak(state, state - 1 - kWaiterOne,
+                                                 std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+void Semaphore::Post(uint32_t count) {
+    uint64_t prev = m_state.fetch_add(count, std::memory_order_release);
+    if (prev >> 32) {
+        Futex::Wake(CountWord(), count);
+    }
+}
+
+void Mutex::LockSlow() {
+    if (s_multiCore) {
+        int spins = m_spins.load(std::memory_order_relaxed);
+        int max_spins = std::min(kMaxSpin, spins * 2 + 10);
+        int cnt = 0;
+        bool locked = false;
+        for (; cnt < max_spins; ++cnt) {
+            CPU_RELAX();
+            uint32_t expected = 0;
+            if (m_state.load(std::memory_order_relaxed) == 0 &&
+                m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                locked = true;
+                break;
+            }
+        }
+        // 指数平均,只有持锁的线程或刚放弃自旋的线程更新,不需要精确
+        m_spins.store(spins + (cnt - spins) / 8, std::memory_order_relaxed);
+        if (locked) {
+            return;
+        }
+    }
+    // 设置为 2 表示有等待者,解锁时需要唤醒
+    while (m_state.exchange(2, std::memory_order_acquire) != 0) {
+        Futex::Wait(&m_state, 2);
+    }
+}
+
+size_t RWMutex::GetSlot() {
+    static std::atomic<size_t> s_next{0};
+    static thread_local size_t t_slot = s_next.fetch_add(1, std::memory_order_relaxed) % kSlots;
+    return t_slot;
+}
+
+bool RWMutex::ReadersEmpty() const {
+    for (auto& slot : m_slots) {
+        if (slot.readers.load(std::memory_order_seq_cst) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RWMutex::lock() {
+    uint32_t expected = 0;
+    if (!m_writer.compare_exchange_strong(expected, 1, std::memory_order_seq_cst)) {
+        while (m_writer.exchange(2, std::memory_order_seq_cst) != 0) {
+            Futex::Wait(&m_writer, 2);
+        }
+    }
+    // 新的读者会看到写标志并退出,只需要等待已经进入的读者离开
+    for (int i = 0; !ReadersEmpty(); ++i) {
+        if (i < Mutex::kMaxSpin && s_multiCore) {
+            CPU_RELAX();
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+bool RWMutex::try_lock() {
+    uint32_t expected = 0;
+    if (!m_writer.compare_exchange_strong(expected, 1, std::memory_order_seq_cst)) {
+        return false;
+    }
+    if (!ReadersEmpty()) {
+        unlock();
+        return false;
+    }
+    return true;
 }
 
-void Semaphore::Post() {
-    int ret = sem_post(&m_semaphore);
-    CHECK_THROW(ret == 0, "sem_post failed, ret is:%d", ret);
+void RWMutex::unlock() {
+    if (m_writer.exchange(0, std::memory_order_release) == 2) {
+        Futex::WakeAll(&m_writer);
+    }
+}
+
+bool RWMutex::try_lock_shared() {
+    auto& readers = m_slots[GetSlot()].readers;
+    readers.fetch_add(1, std::memory_order_seq_cst);
+    if (m_writer.load(std::memory_order_seq_cst) == 0) {
+        return true;
+    }
+    readers.fetch_sub(1, std::memory_order_release);
+    return false;
+}
+
+void RWMutex::lock_shared() {
+    while (!try_lock_shared()) {
+        uint32_t writer = m_writer.load(std::memory_order_relaxed);
+        while (writer != 0) {
+            // 标记有等待者,写者解锁时才会唤醒
+            if (writer == 2 || m_writer.compare_exchange_weak(writer, 2, std::memory_order_relaxed)) {
+                Futex::Wait(&m_writer, 2);
+                writer = m_writer.load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void RWMutex::unlock_shared() {
+    m_slots[GetSlot()].readers.fetch_sub(1, std::memory_order_release);
+}
+
+Latch::Latch(uint32_t count) : m_count(count) {
+    CHECK_THROW(count < kWaitBit, "Latch count %u is too large", count);
+}
+
+void Latch::CountDown(uint32_t n) {
+    uint32_t prev = m_count.fetch_sub(n, std::memory_order_acq_rel);
+    CHECK_THROW((prev & ~kWaitBit) >= n, "Latch count down %u below zero, count is:%u", n, prev & ~kWaitBit);
+    // 归零之后等待者可能已经返回并析构了对象,只使用 fetch_sub 的返回值
+    if (prev == (n | kWaitBit)) {
+        Futex::WakeAll(&m_count);
+    }
+}
+
+void Latch::Wait() {
+    uint32_t count = m_count.load(std::memory_order_acquire);
+    while ((count & ~kWaitBit) != 0) {
+        if ((count & kWaitBit) || m_count.compare_exchange_weak(count, count | kWaitBit, std::memory_order_acquire)) {
+            Futex::Wait(&m_count, count | kWaitBit);
+            count = m_count.load(std::memory_order_acquire);
+        }
+    }
+}
+
+Barrier::Barrier(uint32_t count) : m_count(count) {
+    CHECK_THROW(count > 0, "Barrier count must be positive");
+}
+
+bool Barrier::ArriveAndWait() {
+    // 必须在到达之前读取,否则最后一个线程可能已经开始了下一轮
+    uint32_t generation = m_generation.load(std::memory_order_acquire) & ~1U;
+    if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count) {
+        // 其他线程都在等待 m_generation 改变,不会在这之前再次到达
+        m_arrived.store(0, std::memory_order_relaxed);
+        if (m_generation.exchange(generation + 2, std::memory_order_acq_rel) & 1) {
+            Futex::WakeAll(&m_generation);
+        }
+        return true;
+    }
+    uint32_t current = m_generation.load(std::memory_order_acquire);
+    while ((current & ~1U) == generation) {
+        if ((current & 1) || m_generation.compare_exchange_weak(current, current | 1, std::memory_order_acquire)) {
+            Futex::Wait(&m_generation, current | 1);
+            current = m_generation.load(std::memory_order_acquire);
+        }
+    }
+    return false;
+}
+
+void Event::Set() {
+    if (m_state.exchange(1, std::memory_order_release) == 2) {
+        Futex::WakeAll(&m_state);
+    }
+}
+
+void Event::Reset() {
+    uint32_t expected = 1;
+    m_state.compare_exchange_strong(expected, 0, std::memory_order_relaxed);
 }
 
-}
\ No newline at end of file
+void Event::Wait() {
+    uint32_t state = m_state.load(std::memory_order_acquire);
+    while (state != 1) {
+        if (state == 2 || m_state.compare_exchange_weak(state, 2, std::memory_order_acquire)) {
+            Futex::Wait(&m_state, 2);
+            state = m_state.load(std::memory_order_acquire);
+        }
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 18:10:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 18:10:00
+ * @FilePath: /cpp_basic_library/src/common/src/strand.cpp
+ * @Description: 在共享线程池上串行执行任务的执行器
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#include "common.h"
+
+namespace why {
+
+// 当前线程正在排空的 Strand
+static thread_local const void* t_currentStrand = nullptr;
+
+Strand::Strand(ThreadPool& pool) : m_state(std::make_shared<State>(pool)) {
+
+}
+
+bool Strand::RunningInThisThread() const {
+    return t_currentStrand == m_state.get();
+}
+
+size_t Strand::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(m_state->mtx);
+    return m_state->tasks.Size();
+}
+
+void Strand::Push(UniqueTask&& task) {
+    {
+        std::lock_guard<std::mutex> lock(m_state->mtx);
+        m_state->tasks.PushBack(std::move(task));
+        if (m_state->running) {
+            return;
+        }
+        m_state->running = true;
+    }
+    try {
+        Schedule(m_state);
+    } catch (...) {
+        // 线程池已经停止,队列中的任务(刚放入的,以及期间其他线程放入的)都不会再执行,取出后在锁外析构,
+        // 不能留到之后投递成功时再执行
+        std::vector<UniqueTask> dropped{};
+        {
+            std::lock_guard<std::mutex> lock(m_state->mtx);
+            while (!m_state->tasks.Empty()) {
+                dropped.push_back(m_state->tasks.TakeFront());
+            }
+            m_state->running = false;
+        }
+        dropped.clear();
+        throw;
+    }
+}
+
+void Strand::Schedule(const std::shared_ptr<State>& state) {
+    state->pool.post([state] {
+        Drain(state);
+    });
+}
+
+void Strand::Drain(const std::shared_ptr<State>& state) {
+    const void* prev = t_currentStrand;
+    t_currentStrand = state.get();
+    for (size_t i = 0; i < kMaxBatch; ++i) {
+        UniqueTask task{};
+        {
+            std::lock_guard<std::mutex> lock(state->mtx);
+            if (state->tasks.Empty()) {
+                state->running = false;
+                t_currentStrand = prev;
+                return;
+            }
+            task = state->tasks.TakeFront();
+        }
+        try {
+            task();
+        } catch (...) {
+            // 剩下的任务继续排空,异常交给线程池处理
+            t_currentStrand = prev;
+            Schedule(state);
+            throw;
+        }
+    }
+    t_currentStrand = prev;
+    // running 保持为 true,由新的排空任务继续执行
+    Schedule(state);
+}
+
+}
@@ -1,4 +1,11 @@
 #include "common.h"
+#include <algorithm>
+#include <fstream>
+#include <sched.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 
 namespace why {
 
@@ -9,6 +16,8 @@ void Thread::Join() {
     if (m_thread) {
         int ret = pthread_join(m_thread, nullptr);
         CHECK_THROW(ret == 0, "pthread_join failed, ret is:%d", ret);
+        // 已经 join 的线程不能再 detach
+        m_thread = 0;
     }
 }
 
@@ -16,6 +25,29 @@ void Thread::Detach() {
     if (m_thread) {
         int ret = pthread_detach(m_thread);
         CHECK_THROW(ret == 0, "pthread_detach failed, ret is:%d", ret);
+        m_thread = 0;
+    }
+}
+
+void Thread::Create() {
+    m_name = m_options.name;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (m_options.stack_size) {
+        int ret = pthread_attr_setstacksize(&attr, m_options.stack_size);
+        if (ret != 0) {
+            pthread_attr_destroy(&attr);
+            CHECK_THROW(false, "pthread_attr_setstacksize %zu failed, ret is:%d", m_options.stack_size, ret);
+        }
+    }
+    int ret = pthread_create(&m_thread, &attr, Thread::run, this);
+    pthread_attr_destroy(&attr);
+    CHECK_THROW(ret == 0, "pthread_create failed, ret = %d", ret);
+    m_semaphore.Wait();
+    if (!m_error.empty()) {
+        pthread_join(m_thread, nullptr);
+        m_thread = 0;
+        CHECK_THROW(false, "apply thread options of %s failed:%s", m_name.c_str(), m_error.c_str());
     }
 }
 
@@ -25,15 +57,112 @@ void* Thread::run(void* arg) {
     t->m_id = gettid();
     if (!t->m_name.empty()) {
         t_thread_name = t->m_name;
-        int ret = pthread_setname_np(t->m_thread, t->m_name.c_str());
+        // 名字最长 15 个字符
+        int ret = pthread_setname_np(t->m_thread, t->m_name.substr(0, 15).c_str());
         CHECK_THROW(ret == 0, "pthread_setname_np failed, ret is:%d", ret);
     }
+    try {
+        ThisThread::ApplyOptions(t->m_options);
+    } catch (const std::exception& e) {
+        // 构造函数在 Wait 返回后抛出异常,这里不再访问 t
+        t->m_error = e.what();
+        t_thread = nullptr;
+        t->m_semaphore.Post();
+        return nullptr;
+    }
+    ThreadRegistry::Register();
     auto cb = std::move(t->m_cb);
     t->m_semaphore.Post();
     cb();
     return nullptr;
 }
 
+static bool ReadFirstLine(const std::string& path, std::string& line) {
+    std::ifstream ifs(path);
+    return ifs && std::getline(ifs, line);
+}
+
+static int ReadInt(const std::string& path, int default_value) {
+    std::string line{};
+    if (!ReadFirstLine(path, line) || line.empty()) {
+        return default_value;
+    }
+    return std::stoi(line);
+}
+
+std::vector<int> CpuTopology::ParseCpuList(const std::string& list) {
+    std::vector<int> cpus{};
+    std::stringstream ss(list);
+    std::string item{};
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        auto pos = item.find('-');
+        int first = std::stoi(item.substr(0, pos));
+        int last = pos == std::string::npos ? first : std::stoi(item.substr(pos + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+const std::vector<CpuInfo>& CpuTopology::GetCpus() {
+    static const std::vector<CpuInfo> s_cpus = [] {
+        std::vector<CpuInfo> cpus{};
+        std::string online{};
+        std::vector<int> ids{};
+        if (ReadFirstLine("/sys/devices/system/cpu/online", online)) {
+            ids = ParseCpuList(online);
+        } else {
+            for (long i = 0; i < sysconf(_SC_NPROCESSORS_ONLN); ++i) {
+                ids.push_back(i);
+            }
+        }
+        for (int id : ids) {
+            std::string prefix = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+            CpuInfo info{};
+            info.cpu = id;
+            info.package = ReadInt(prefix + "physical_package_id", 0);
+            info.core = ReadInt(prefix + "core_id", id);
+            cpus.push_back(info);
+        }
+        for (int node = 0; node < GetNumaNodeCount(); ++node) {
+            for (int cpu : GetNumaNodeCpus(node)) {
+                auto iter = std::find_if(cpus.begin(), cpus.end(), [cpu](const CpuInfo& info) {
+                    return info.cpu == cpu;
+                });
+                if (iter != cpus.end()) {
+                    iter->numa_node = node;
+                }
+            }
+        }
+        return cpus;
+    }();
+    return s_cpus;
+}
+
+int CpuTopology::GetNumaNodeCount() {
+    static const int s_nodes = [] {
+        std::string online{};
+        if (!ReadFirstLine("/sys/devices/system/node/online", online)) {
+            return 1;
+        }
+        auto nodes = ParseCpuList(online);
+        return nodes.empty() ? 1 : nodes.back() + 1;
+    }();
+    return s_nodes;
+}
+
+std::vector<int> CpuTopology::GetNumaNodeCpus(int node) {
+    std::string list{};
+    if (!ReadFirstLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", list)) {
+        return {};
+    }
+    return ParseCpuList(list);
+}
+
 const std::string& ThisThread::GetName() {
     return t_thread_name;
 }
@@ -47,6 +176,75 @@ void ThisThread::SetName(const std::string& name) {
     }
     ret = pthread_setname_np(pthread_self(), t_thread_name.c_str());
     CHECK_THROW(ret == 0, "pthread_setname_np failed, ret is:%d", ret);
+    ThreadRegistry::Register();
+}
+
+void ThisThread::SetAffinity(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CHECK_THROW(cpu >= 0 && cpu < CPU_SETSIZE, "invalid cpu:%d", cpu);
+        CPU_SET(cpu, &set);
+    }
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    CHECK_THROW(ret == 0, "pthread_setaffinity_np failed, ret is:%d", ret);
+}
+
+void ThisThread::BindNumaNode(int node) {
+    CHECK_THROW(node >= 0 && node < CpuTopology::GetNumaNodeCount() && node < 64, "invalid numa node:%d", node);
+    SetAffinity(CpuTopology::GetNumaNodeCpus(node));
+    // 只影响当前线程之后的首次访问,不迁移已经分配的内存
+    unsigned long mask = 1UL << node;
+    long ret = syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8);
+    CHECK_THROW(ret == 0, "set_mempolicy node:%d failed:%s", node, strerror(errno));
+}
+
+void ThisThread::SetSchedPolicy(SchedPolicy policy, int priority, int nice) {
+    int native = SCHED_OTHER;
+    switch (policy) {
+        case SchedPolicy::BATCH: native = SCHED_BATCH; break;
+        case SchedPolicy::IDLE: native = SCHED_IDLE; break;
+        case SchedPolicy::FIFO: native = SCHED_FIFO; break;
+        case SchedPolicy::RR: native = SCHED_RR; break;
+        default: break;
+    }
+    bool realtime = policy == SchedPolicy::FIFO || policy == SchedPolicy::RR;
+    struct sched_param param{};
+    param.sched_priority = realtime ? priority : 0;
+    int ret = pthread_setschedparam(pthread_self(), native, &param);
+    CHECK_THROW(ret == 0, "pthread_setschedparam policy:%d priority:%d failed:%s",
+                native, param.sched_priority, strerror(ret));
+    if (!realtime && nice) {
+        // Linux 上 nice 值是线程级别的
+        ret = setpriority(PRIO_PROCESS, gettid(), nice);
+        CHECK_THROW(ret == 0, "setpriority nice:%d failed:%s", nice, strerror(errno));
+    }
+}
+
+void ThisThread::ApplyOptions(const ThreadOptions& options) {
+    if (options.numa_node >= 0) {
+        BindNumaNode(options.numa_node);
+        if (!options.cpus.empty()) {
+            // 与节点的 CPU 取交集
+            auto node_cpus = CpuTopology::GetNumaNodeCpus(options.numa_node);
+            std::vector<int> cpus{};
+            for (int cpu : options.cpus) {
+                if (std::find(node_cpus.begin(), node_cpus.end(), cpu) != node_cpus.end()) {
+                    cpus.push_back(cpu);
+                }
+            }
+            CHECK_THROW(!cpus.empty(), "none of the cpus belongs to numa node:%d", options.numa_node);
+            SetAffinity(cpus);
+        }
+    } else {
+        SetAffinity(options.cpus);
+    }
+    if (options.policy != SchedPolicy::OTHER || options.nice) {
+        SetSchedPolicy(options.policy, options.priority, options.nice);
+    }
 }
 
 pid_t ThisThread::GetID() {
@@ -0,0 +1,191 @@
+#include "common.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <time.h>
+
+namespace why {
+
+namespace {
+
+uint64_t ClockNs(clockid_t clock) {
+    struct timespec ts{};
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+struct Entry {
+    pid_t tid{0};
+    // 只在持有注册表锁时读写
+    std::string name;
+    clockid_t clock{CLOCK_THREAD_CPUTIME_ID};
+    uint64_t start_ns{0};
+    std::atomic<bool> worker{false};
+    std::atomic<uint64_t> tasks{0};
+    std::atomic<uint64_t> busy_ns{0};
+};
+
+struct Registry {
+    std::mutex mtx;
+    std::map<pid_t, Entry*> threads;
+};
+
+// 不析构,进程退出时仍在运行的线程注销时不会访问已经析构的对象
+Registry& GetRegistry() {
+    static Registry* s_registry = new Registry();
+    return *s_registry;
+}
+
+/**
+ * @description: 线程局部的注册信息,线程退出时析构并从注册表中删除
+ * @details 注销需要注册表的锁,所以 Sample 持锁期间看到的线程都没有退出,读取它的 CPU 时钟是安全的
+ */
+struct Registration {
+    ~Registration() {
+        if (registered) {
+            auto& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mtx);
+            registry.threads.erase(entry.tid);
+        }
+    }
+
+    bool registered{false};
+    Entry entry;
+};
+
+thread_local Registration t_registration;
+
+void ReadSwitches(pid_t tid, ThreadStats& stats) {
+    std::ifstream ifs("/proc/self/task/" + std::to_string(tid) + "/status");
+    std::string line{};
+    while (std::getline(ifs, line)) {
+        if (line.compare(0, 24, "voluntary_ctxt_switches:") == 0) {
+            stats.voluntary_switches = std::stoull(line.substr(24));
+        } else if (line.compare(0, 27, "nonvoluntary_ctxt_switches:") == 0) {
+            stats.involuntary_switches = std::stoull(line.substr(27));
+        }
+    }
+}
+
+std::string JsonEscape(const std::string& str) {
+    std::stringstream ss;
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            ss << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            ss << c;
+        }
+    }
+    return ss.str();
+}
+
+}
+
+void ThreadRegistry::Register() {
+    auto& registration = t_registration;
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    registration.entry.name = ThisThread::GetName();
+    if (registration.registered) {
+        return;
+    }
+    auto& entry = registration.entry;
+    entry.tid = gettid();
+    if (pthread_getcpuclockid(pthread_self(), &entry.clock) != 0) {
+        entry.clock = CLOCK_THREAD_CPUTIME_ID;
+    }
+    entry.start_ns = GetCurrentNS();
+    registry.threads[entry.tid] = &entry;
+    registration.registered = true;
+}
+
+void ThreadRegistry::MarkWorker() {
+    Register();
+    t_registration.entry.worker.store(true, std::memory_order_relaxed);
+}
+
+void ThreadRegistry::RecordTask(uint64_t busy_ns) {
+    auto& registration = t_registration;
+    if (registration.registered) {
+        // 只有本线程写,不需要原子的读改写
+        auto& entry = registration.entry;
+        entry.tasks.store(entry.tasks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        entry.busy_ns.store(entry.busy_ns.load(std::memory_order_relaxed) + busy_ns, std::memory_order_relaxed);
+    }
+}
+
+std::vector<ThreadStats> ThreadRegistry::Sample() {
+    std::vector<ThreadStats> result{};
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    uint64_t now = GetCurrentNS();
+    result.reserve(registry.threads.size());
+    for (auto& item : registry.threads) {
+        const Entry& entry = *item.second;
+        ThreadStats stats{};
+        stats.tid = entry.tid;
+        stats.name = entry.name;
+        stats.wall_ns = now > entry.start_ns ? now - entry.start_ns : 0;
+        stats.cpu_ns = ClockNs(entry.clock);
+        ReadSwitches(entry.tid, stats);
+        stats.worker = entry.worker.load(std::memory_order_relaxed);
+        stats.tasks = entry.tasks.load(std::memory_order_relaxed);
+        stats.busy_ns = entry.busy_ns.load(std::memory_order_relaxed);
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+std::string ThreadRegistry::ToYamlString() {
+    YAML::Node node;
+    for (auto& stats : Sample()) {
+        YAML::Node thread;
+        thread["tid"] = stats.tid;
+        thread["name"] = stats.name;
+        thread["wall_ns"] = stats.wall_ns;
+        thread["cpu_ns"] = stats.cpu_ns;
+        thread["cpu_usage"] = stats.GetCpuUsage();
+        thread["voluntary_switches"] = stats.voluntary_switches;
+        thread["involuntary_switches"] = stats.involuntary_switches;
+        if (stats.worker) {
+            thread["tasks"] = stats.tasks;
+            thread["busy_ns"] = stats.busy_ns;
+            thread["busy_ratio"] = stats.GetBusyRatio();
+        }
+        node.push_back(thread);
+    }
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+}
+
+std::string ThreadRegistry::ToJsonString() {
+    std::stringstream ss;
+    ss << "[";
+    size_t idx = 0;
+    for (auto& stats : Sample()) {
+        ss << (idx++ ? ", " : "") << "{\"tid\": " << stats.tid
+           << ", \"name\": \"" << JsonEscape(stats.name)
+           << "\", \"wall_ns\": " << stats.wall_ns
+           << ", \"cpu_ns\": " << stats.cpu_ns
+           << ", \"cpu_usage\": " << stats.GetCpuUsage()
+           << ", \"voluntary_switches\": " << stats.voluntary_switches
+           << ", \"involuntary_switches\": " << stats.involuntary_switches;
+        if (stats.worker) {
+            ss << ", \"tasks\": " << stats.tasks
+               << ", \"busy_ns\": " << stats.busy_ns
+               << ", \"busy_ratio\": " << stats.GetBusyRatio();
+        }
+        ss << "}";
+    }
+    ss << "]";
+    return ss.str();
+}
+
+}
@@ -1,72 +1,552 @@
 #include "common.h"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <tuple>
 
 namespace why {
 
-ThreadPool::ThreadPool(int size) : m_threadNum(size) {
+// 当前线程所属的线程池以及在线程池中的下标,用于 WORK_STEALING 模式判断任务是否由工作线程提交
+static thread_local ThreadPool* t_pool = nullptr;
+static thread_local size_t t_workerIdx = 0;
+
+// 阻塞前自旋尝试获取任务的次数
+static constexpr int kSpinCount = 64;
+
+ThreadPool::ThreadPool(int size, Mode mode) : m_threadNum(size), m_mode(mode) {
     if (!size) {
         m_threadNum = std::thread::hardware_concurrency();
     }
 }
 
+ThreadPool::ThreadPool(const ElasticOptions& options)
+    : m_threadNum(options.min_threads), m_mode(Mode::SHARED), m_elastic(true), m_elasticOptions(options) {
+    if (!m_elasticOptions.max_threads) {
+        m_elasticOptions.max_threads = std::max<size_t>(std::thread::hardware_concurrency(), options.min_threads);
+    }
+    CHECK_THROW(options.min_threads > 0, "elastic ThreadPool needs at least one thread");
+    CHECK_THROW(m_elasticOptions.max_threads >= options.min_threads,
+                "elastic ThreadPool max_threads:%zu less than min_threads:%zu",
+                m_elasticOptions.max_threads, options.min_threads);
+}
+
 ThreadPool::~ThreadPool() {
     if (!m_isTerminate) {
         Shutdown();
     }
 }
 
+/**
+ * @description: 按分布方式排列候选 CPU
+ */
+static std::vector<int> PlacementOrder(std::vector<CpuInfo> cpus, ThreadPool::CpuPlacement placement) {
+    // 同一物理核内的序号(0 为第一个超线程)与物理核在 socket 内的序号
+    std::vector<std::pair<int, int>> ranks(cpus.size());
+    std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& lhs, const CpuInfo& rhs) {
+        return std::tie(lhs.package, lhs.core, lhs.cpu) < std::tie(rhs.package, rhs.core, rhs.cpu);
+    });
+    if (placement == ThreadPool::CpuPlacement::PACK) {
+        std::vector<int> order{};
+        for (auto &info : cpus) {
+            order.push_back(info.cpu);
+        }
+        return order;
+    }
+    int sibling = 0;
+    int core = 0;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        if (i && cpus[i].package != cpus[i - 1].package) {
+            core = 0;
+            sibling = 0;
+        } else if (i && cpus[i].core != cpus[i - 1].core) {
+            ++core;
+            sibling = 0;
+        } else if (i) {
+            ++sibling;
+        }
+        ranks[i] = {sibling, core};
+    }
+    std::vector<size_t> idx(cpus.size());
+    std::iota(idx.begin(), idx.end(), 0);
+    std::sort(idx.begin(), idx.end(), [&](size_t lhs, size_t rhs) {
+        return std::tie(ranks[lhs].first, ranks[lhs].second, cpus[lhs].package) <
+               std::tie(ranks[rhs].first, ranks[rhs].second, cpus[rhs].package);
+    });
+    std::vector<int> order{};
+    for (auto i : idx) {
+        order.push_back(cpus[i].cpu);
+    }
+    return order;
+}
+
 void ThreadPool::Start() {
     std::lock_guard<std::mutex> lock(m_threadMtx);
     CHECK_THROW(m_threads.empty(), "m_threads not empty");
+    if (m_workerOptions.placement != CpuPlacement::NONE) {
+        const auto &allowed = m_workerOptions.thread.cpus;
+        int node = m_workerOptions.thread.numa_node;
+        std::vector<CpuInfo> candidates{};
+        for (auto &info : CpuTopology::GetCpus()) {
+            if ((allowed.empty() || std::find(allowed.begin(), allowed.end(), info.cpu) != allowed.end()) &&
+                (node < 0 || info.numa_node == node)) {
+                candidates.push_back(info);
+            }
+        }
+        CHECK_THROW(!candidates.empty(), "no cpu available for ThreadPool workers");
+        m_placement = PlacementOrder(std::move(candidates), m_workerOptions.placement);
+    }
+    if (m_mode == Mode::WORK_STEALING) {
+        for (size_t i = 0; i < m_threadNum; i++) {
+            m_workers.push_back(std::make_unique<Worker>());
+            m_workers.back()->seed = i * 0x9e3779b97f4a7c15ULL + 1;
+        }
+        for (size_t i = 0; i < m_threadNum; i++) {
+            m_threads.push_back(SpawnWorker(std::bind(&ThreadPool::RunStealing, this, i)));
+        }
+        return;
+    }
     for (size_t i = 0; i < m_threadNum; i++) {
-        m_threads.push_back(std::make_shared<std::thread>(std::bind(&ThreadPool::Run, this)));
+        m_threads.push_back(SpawnWorker(std::bind(&ThreadPool::Run, this)));
     }
+    // 之后弹性扩缩容在 m_taskMtx 保护下修改 m_threads
+    std::lock_guard<std::mutex> task_lock(m_taskMtx);
+    m_peakThreads = m_threadNum;
+    m_lastGrowNs = NowNs();
+    m_started = true;
 }
 
-void ThreadPool::Shutdown() {
-    while (1) {
-        std::unique_lock<std::mutex> lock(m_taskMtx);
-        if (m_taskLists.empty()) {
-            // lock.unlock();
-            break;
+void ThreadPool::Shutdown(ShutdownMode mode) {
+    CHECK_THROW(t_pool != this, "ThreadPool can not shutdown in its worker thread");
+    std::lock_guard<std::mutex> thread_lock(m_threadMtx);
+    if (m_isTerminate) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_taskMtx);
+    if (mode == ShutdownMode::FINISH_PENDING && !m_threads.empty()) {
+        m_idleCv.wait(lock, [this] {
+            return m_pending.load(std::memory_order_acquire) == 0;
+        });
+    }
+    Stop(lock);
+}
+
+bool ThreadPool::Shutdown(const std::chrono::steady_clock::time_point& deadline) {
+    CHECK_THROW(t_pool != this, "ThreadPool can not shutdown in its worker thread");
+    std::lock_guard<std::mutex> thread_lock(m_threadMtx);
+    if (m_isTerminate) {
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(m_taskMtx);
+    bool finished = m_pending.load(std::memory_order_acquire) == 0;
+    if (!m_threads.empty()) {
+        finished = m_idleCv.wait_until(lock, deadline, [this] {
+            return m_pending.load(std::memory_order_acquire) == 0;
+        });
+    }
+    Stop(lock);
+    return finished;
+}
+
+void ThreadPool::Stop(std::unique_lock<std::mutex>& lock) {
+    m_cancelPending.store(true, std::memory_order_relaxed);
+    if (m_threads.empty()) {
+        // 没有启动工作线程,直接丢弃队列中的任务,析构时可能执行 future 的回调,不能持有锁
+        std::vector<Task> dropped{};
+        while (!m_taskLists.Empty()) {
+            dropped.push_back(m_taskLists.TakeFront());
+        }
+        for (auto &queue : m_priorityQueues) {
+            for (auto &item : queue) {
+                dropped.push_back(std::move(item.task));
+            }
+            queue.clear();
+        }
+        for (auto &arrivals : m_priorityArrivals) {
+            arrivals.fifo.Clear();
+            arrivals.taken.clear();
         }
+        m_prioritySize = 0;
+        m_pending.fetch_sub(dropped.size(), std::memory_order_acq_rel);
         lock.unlock();
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        dropped.clear();
+        lock.lock();
+    } else {
+        // 唤醒阻塞的工作线程丢弃剩余任务
+        ++m_wakeGen;
+        m_cv.notify_all();
+        m_idleCv.wait(lock, [this] {
+            return m_pending.load(std::memory_order_acquire) == 0;
+        });
     }
-    std::lock_guard<std::mutex> lock(m_threadMtx);
     m_isTerminate = true;
+    lock.unlock();
     m_cv.notify_all();
+    // 不再扩缩容,已经退出但还没有回收的线程也在这里 join
     for (auto thread : m_threads) {
-        thread->join();
+        thread->Join();
     }
 }
 
-ThreadPool::TaskPtr ThreadPool::GetTask() {
+void ThreadPool::WaitIdle() {
+    CHECK_THROW(t_pool != this, "ThreadPool can not wait idle in its worker thread");
     std::unique_lock<std::mutex> lock(m_taskMtx);
-    // 任务队列不为空或者线程池已经终止时才解除阻塞
-    m_cv.wait(lock, [this] {
-        return !m_taskLists.empty() || m_isTerminate;
+    m_idleCv.wait(lock, [this] {
+        return m_pending.load(std::memory_order_acquire) == 0;
     });
+}
+
+void ThreadPool::Execute(Task& task) {
+    if (!m_cancelPending.load(std::memory_order_relaxed)) {
+        int64_t begin = NowNs();
+        try {
+            task();
+        } catch (...) {
+            if (m_exceptionHandler) {
+                m_exceptionHandler(std::current_exception());
+            } else {
+                try {
+                    throw;
+                } catch (const std::exception& e) {
+                    std::cerr << "ThreadPool task func exec error:" << e.what() << std::endl;
+                } catch (...) {
+                    std::cerr << "ThreadPool task func exec error: unknown exception" << std::endl;
+                }
+            }
+        }
+        ThreadRegistry::RecordTask(NowNs() - begin);
+    }
+    // 被取消的任务在这里析构
+    task.Reset();
+    if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // 加锁后再通知,避免等待的线程检查完条件还没有阻塞时丢失通知
+        std::lock_guard<std::mutex> lock(m_taskMtx);
+        m_idleCv.notify_all();
+    }
+}
+
+void ThreadPool::PushTask(Task&& task, TaskAttr* attr) {
+    CHECK_THROW(!attr || m_mode == Mode::PRIORITY, "task priority and deadline require Mode::PRIORITY");
+    if (m_mode == Mode::WORK_STEALING && t_pool == this) {
+        // 工作线程内提交的任务放入自己的队列,无锁
+        Worker& self = *m_workers[t_workerIdx];
+        Task* node = ObjectPool<Task>::New(std::move(task));
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        self.deque.Push(node);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleepers.load(std::memory_order_relaxed) > 0) {
+            WakeOne();
+        }
+        return;
+    }
+
+    // 放入任务
+    std::unique_lock<std::mutex> lock(m_taskMtx);
+    CHECK_THROW(!m_isTerminate, "ThreadPool has already shutdown");
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    if (m_mode == Mode::PRIORITY) {
+        PriorityTask item{std::move(task), nullptr, INT64_MAX, NowNs(), m_prioritySeq++};
+        size_t level = static_cast<size_t>(Priority::NORMAL);
+        if (attr) {
+            level = std::min(static_cast<size_t>(attr->priority), kPriorityLevels - 1);
+            item.on_expired = std::move(attr->on_expired);
+            if (attr->deadline != TimePoint::max()) {
+                item.deadline_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    attr->deadline.time_since_epoch()).count();
+            }
+        }
+        m_priorityArrivals[level].fifo.PushBack(item.seq, item.enqueue_ns);
+        auto &queue = m_priorityQueues[level];
+        queue.push_back(std::move(item));
+        std::push_heap(queue.begin(), queue.end(), PriorityLess);
+        ++m_prioritySize;
+    } else {
+        m_taskLists.PushBack(std::move(task));
+    }
+    if (m_elastic) {
+        int64_t now = NowNs();
+        m_enqueueNs.PushBack(now);
+        MaybeGrow(now);
+    }
+    ++m_wakeGen;
+    lock.unlock();
+
+    // 唤醒一个线程
+    m_cv.notify_one();
+}
+
+void ThreadPool::WakeOne() {
+    {
+        std::lock_guard<std::mutex> lock(m_taskMtx);
+        ++m_wakeGen;
+    }
+    m_cv.notify_one();
+}
+
+bool ThreadPool::GetTask(Task& task) {
+    std::unique_lock<std::mutex> lock(m_taskMtx);
+    // 任务队列不为空或者线程池已经终止时才解除阻塞
+    while (QueueEmpty() && !m_isTerminate) {
+        if (!m_elastic) {
+            m_cv.wait(lock);
+            continue;
+        }
+        ++m_idleThreads;
+        auto status = m_cv.wait_for(lock, m_elasticOptions.idle_timeout);
+        --m_idleThreads;
+        if (status == std::cv_status::timeout && m_taskLists.Empty() && !m_isTerminate && CanRetire(NowNs())) {
+            // 空闲超时,线程退出,由下一次扩容或者 Shutdown 回收
+            --m_threadNum;
+            ++m_shrinks;
+            m_retired.push_back(ThisThread::GetID());
+            return false;
+        }
+    }
     if (m_isTerminate) {
-        return nullptr;
+        return false;
+    }
+    CHECK_THROW((QueueEmpty() == false), "task list is empty!");
+    if (m_mode == Mode::PRIORITY) {
+        TakePriorityTask(task);
+        return true;
+    }
+    task = m_taskLists.TakeFront();
+    if (m_elastic) {
+        int64_t now = NowNs();
+        m_queueWait.Record(now - m_enqueueNs.TakeFront());
+        MaybeGrow(now);
+    }
+
+    return true;
+}
+
+bool ThreadPool::PriorityLess(const PriorityTask& lhs, const PriorityTask& rhs) {
+    return lhs.deadline_ns != rhs.deadline_ns ? lhs.deadline_ns > rhs.deadline_ns : lhs.seq > rhs.seq;
+}
+
+bool ThreadPool::QueueEmpty() const {
+    return m_mode == Mode::PRIORITY ? m_prioritySize == 0 : m_taskLists.Empty();
+}
+
+int64_t ThreadPool::OldestEnqueueNs(size_t level) {
+    auto &arrivals = m_priorityArrivals[level];
+    auto &taken = arrivals.taken;
+    // seq 按提交顺序递增,已取走的任务到达队首时和 taken 的堆顶相同
+    while (!taken.empty() && taken.front() == arrivals.fifo.Front().first) {
+        std::pop_heap(taken.begin(), taken.end(), std::greater<uint64_t>());
+        taken.pop_back();
+        arrivals.fifo.PopFront();
     }
-    CHECK_THROW((m_taskLists.empty() == false), "task list is empty!");
-    auto task = m_taskLists.front();
-    m_taskLists.pop_front();
+    return arrivals.fifo.Front().second;
+}
 
-    return task;
+void ThreadPool::TakePriorityTask(Task& task) {
+    int64_t now = NowNs();
+    size_t best = kPriorityLevels;
+    int64_t best_score = 0;
+    for (size_t level = 0; level < kPriorityLevels; ++level) {
+        auto &queue = m_priorityQueues[level];
+        if (queue.empty()) {
+            continue;
+        }
+        // 每等待 aging 时间相当于提升一个优先级,相同时高优先级优先;按该优先级中等待最久的任务计算
+        int64_t score = m_agingNs > 0 ? static_cast<int64_t>(level) * m_agingNs - (now - OldestEnqueueNs(level))
+                                      : static_cast<int64_t>(level);
+        if (best == kPriorityLevels || score < best_score) {
+            best = level;
+            best_score = score;
+        }
+    }
+    auto &queue = m_priorityQueues[best];
+    std::pop_heap(queue.begin(), queue.end(), PriorityLess);
+    PriorityTask item = std::move(queue.back());
+    queue.pop_back();
+    --m_prioritySize;
+    auto &arrivals = m_priorityArrivals[best];
+    if (queue.empty()) {
+        arrivals.fifo.Clear();
+        arrivals.taken.clear();
+    } else {
+        arrivals.taken.push_back(item.seq);
+        std::push_heap(arrivals.taken.begin(), arrivals.taken.end(), std::greater<uint64_t>());
+        // 及时移除已经到达队首的记录,不开启 aging 时也不会累积
+        OldestEnqueueNs(best);
+    }
+    m_queueWait.Record(now - item.enqueue_ns);
+    if (item.deadline_ns >= now) {
+        task = std::move(item.task);
+        return;
+    }
+    // 过期的任务不执行,在工作线程中析构(可能触发 future 的回调)并通知使用者,不持有锁
+    ++m_expiredTasks;
+    task = Task([expired = std::move(item.task), callback = std::move(item.on_expired)]() mutable {
+        expired.Reset();
+        if (callback) {
+            callback();
+        }
+    });
 }
 
 void ThreadPool::Run() {
-    while (!m_isTerminate) {
-        auto task = GetTask();
-        if (task) {
-            try {
-                task->func();
-            } catch (const std::exception& e) {
-                CHECK_THROW(false, "task func exec error:%s", e.what());
-            }
+    t_pool = this;
+    ThreadRegistry::MarkWorker();
+    while (true) {
+        Task task{};
+        // 线程池终止或者弹性模式下空闲退出
+        if (!GetTask(task)) {
+            break;
+        }
+        Execute(task);
+    }
+    t_pool = nullptr;
+}
+
+int64_t ThreadPool::NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ThreadPool::MaybeGrow(int64_t now_ns) {
+    if (!m_started || m_isTerminate || m_idleThreads || m_taskLists.Empty() ||
+        m_threadNum >= m_elasticOptions.max_threads) {
+        return;
+    }
+    if (now_ns - m_enqueueNs.Front() <= m_elasticOptions.target_queue_wait.count() ||
+        now_ns - m_lastGrowNs < m_elasticOptions.grow_interval.count()) {
+        return;
+    }
+    ReapRetired();
+    m_threads.push_back(SpawnWorker(std::bind(&ThreadPool::Run, this)));
+    ++m_threadNum;
+    ++m_grows;
+    m_peakThreads = std::max<size_t>(m_peakThreads, m_threadNum);
+    m_lastGrowNs = now_ns;
+}
+
+ThreadOptions ThreadPool::MakeThreadOptions(size_t idx) const {
+    ThreadOptions options = m_workerOptions.thread;
+    options.name = (options.name.empty() ? "pool" : options.name) + "_" + std::to_string(idx);
+    if (!m_placement.empty()) {
+        options.cpus = {m_placement[idx % m_placement.size()]};
+    }
+    return options;
+}
+
+ThreadPool::ThreadPtr ThreadPool::SpawnWorker(std::function<void()> func) {
+    return std::make_shared<Thread>(std::move(func), MakeThreadOptions(m_spawned++));
+}
+
+bool ThreadPool::CanRetire(int64_t now_ns) const {
+    return m_threadNum > m_elasticOptions.min_threads &&
+           now_ns - m_lastGrowNs >= m_elasticOptions.idle_timeout.count();
+}
+
+void ThreadPool::ReapRetired() {
+    for (auto id : m_retired) {
+        auto iter = std::find_if(m_threads.begin(), m_threads.end(), [id](const ThreadPtr& thread) {
+            return thread->GetPid() == id;
+        });
+        // 退出的线程已经释放了锁,join 不会等待太久
+        (*iter)->Join();
+        m_threads.erase(iter);
+    }
+    m_retired.clear();
+}
+
+ThreadPool::Stats ThreadPool::GetStats() {
+    Stats stats{};
+    {
+        std::lock_guard<std::mutex> lock(m_taskMtx);
+        stats.idle_threads = m_idleThreads;
+        stats.peak_threads = m_started ? m_peakThreads : 0;
+        stats.grows = m_grows;
+        stats.shrinks = m_shrinks;
+        stats.expired = m_expiredTasks;
+    }
+    stats.threads = GetThreadNum();
+    stats.pending = GetPendingCount();
+    stats.queue_wait_p50_ns = m_queueWait.Percentile(0.5);
+    stats.queue_wait_p99_ns = m_queueWait.Percentile(0.99);
+    stats.queue_wait_max_ns = m_queueWait.Max();
+    return stats;
+}
+
+bool ThreadPool::HasStealingWork() {
+    for (auto &worker : m_workers) {
+        if (!worker->deque.Empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::FindTask(size_t idx, Task& task) {
+    Worker& self = *m_workers[idx];
+    Task* node = nullptr;
+    bool found = self.deque.Pop(node);
+    if (!found) {
+        std::lock_guard<std::mutex> lock(m_taskMtx);
+        if (!m_taskLists.Empty()) {
+            task = m_taskLists.TakeFront();
+            return true;
         }
     }
+
+    // 从随机位置开始尝试窃取每一个其他线程
+    size_t n = m_workers.size();
+    if (!found) {
+        self.seed ^= self.seed << 13;
+        self.seed ^= self.seed >> 7;
+        self.seed ^= self.seed << 17;
+        size_t start = self.seed % n;
+        for (size_t i = 0; i < n && !found; ++i) {
+            size_t victim = (start + i) % n;
+            found = victim != idx && m_workers[victim]->deque.Steal(node);
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    // 节点由执行它的线程释放,被窃取的节点通过对象池归还给提交它的线程
+    task = std::move(*node);
+    ObjectPool<Task>::Delete(node);
+    return true;
+}
+
+void ThreadPool::RunStealing(size_t idx) {
+    t_pool = this;
+    ThreadRegistry::MarkWorker();
+    t_workerIdx = idx;
+    int spins = 0;
+    while (true) {
+        Task task{};
+        if (FindTask(idx, task)) {
+            spins = 0;
+            Execute(task);
+            continue;
+        }
+        if (m_isTerminate) {
+            break;
+        }
+        if (++spins < kSpinCount) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // 阻塞前登记并再次检查,与 PushTask 中先入队再检查 m_sleepers 配合,避免丢失唤醒
+        std::unique_lock<std::mutex> lock(m_taskMtx);
+        uint64_t gen = m_wakeGen;
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_taskLists.Empty() && !HasStealingWork()) {
+            m_cv.wait(lock, [this, gen] {
+                return m_wakeGen != gen || m_isTerminate;
+            });
+        }
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        spins = 0;
+    }
+    t_pool = nullptr;
 }
 
-}
\ No newline at end of file
+}
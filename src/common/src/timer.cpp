@@ -1,68 +1,602 @@
 /*
  * @Author: wuhanyi
  * @Date: 2022-04-29 16:21:56
- * @LastEditTime: 2022-05-04 14:06:46
+ * @LastEditTime: 2026-10-19 14:30:00
  * @FilePath: /basic_library/src/common/src/timer.cpp
- * @Description: 
- * 
- * Copyright (c) 2022 by wuhanyi, All Rights Reserved. 
+ * @Description:
+ *
+ * Copyright (c) 2022 by wuhanyi, All Rights Reserved.
  */
 #include "common.h"
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 namespace why {
 using namespace Timer;
 
-TimerQueue::TimerQueue(int pool_size) : m_threadPool(pool_size) {
-    
+static constexpr uint64_t kSlotMask = TimingWheel::kSlots - 1;
+// 时间轮能直接表示的最大 tick 间隔
+static constexpr uint64_t kMaxDelta = 1ULL << (TimingWheel::kSlotBits * TimingWheel::kLevels);
+
+void TimingWheel::Link(Node* node, int level, size_t slot) {
+    node->level = level;
+    node->slot = slot;
+    node->prev = nullptr;
+    node->next = m_slots[level][slot];
+    if (node->next) {
+        node->next->prev = node;
+    }
+    m_slots[level][slot] = node;
+    m_bitmap[level][slot >> 6] |= 1ULL << (slot & 63);
+}
+
+void TimingWheel::Insert(Node* node) {
+    CHECK_THROW(!node->linked, "timer node already inserted");
+    uint64_t expire = std::max(node->expire, m_current);
+    uint64_t delta = expire - m_current;
+    if (delta >= kMaxDelta) {
+        // 超出范围的先放在最高层能表示的最远位置,级联时再重新计算
+        expire = m_current + kMaxDelta - 1;
+        delta = kMaxDelta - 1;
+    }
+    int level = 0;
+    while (delta >= (1ULL << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+    Link(node, level, (expire >> (kSlotBits * level)) & kSlotMask);
+    node->linked = true;
+    ++m_size;
+}
+
+void TimingWheel::Remove(Node* node) {
+    CHECK_THROW(node->linked, "timer node not inserted");
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        m_slots[node->level][node->slot] = node->next;
+        if (!node->next) {
+            m_bitmap[node->level][node->slot >> 6] &= ~(1ULL << (node->slot & 63));
+        }
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    node->prev = node->next = nullptr;
+    node->linked = false;
+    --m_size;
+}
+
+size_t TimingWheel::FindNextSlot(int level, size_t start) const {
+    size_t offset = 0;
+    while (offset < kSlots) {
+        size_t idx = (start + offset) & kSlotMask;
+        uint64_t word = m_bitmap[level][idx >> 6] >> (idx & 63);
+        if (word) {
+            offset += __builtin_ctzll(word);
+            return offset < kSlots ? offset : kSlots;
+        }
+        offset += 64 - (idx & 63);
+    }
+    return kSlots;
+}
+
+uint64_t TimingWheel::NextTick() const {
+    if (!m_size) {
+        return UINT64_MAX;
+    }
+    uint64_t next = UINT64_MAX;
+    for (int level = 0; level < kLevels; ++level) {
+        // 第 level 层的槽只在低位全为 0 的 tick 处理(第 0 层每个 tick 都处理)
+        int shift = kSlotBits * level;
+        uint64_t block = (m_current + (1ULL << shift) - 1) >> shift;
+        size_t offset = FindNextSlot(level, block & kSlotMask);
+        if (offset < kSlots) {
+            next = std::min(next, (block + offset) << shift);
+        }
+    }
+    return next;
+}
+
+void TimingWheel::Cascade(int level, size_t slot) {
+    Node* node = m_slots[level][slot];
+    m_slots[level][slot] = nullptr;
+    m_bitmap[level][slot >> 6] &= ~(1ULL << (slot & 63));
+    while (node) {
+        Node* next = node->next;
+        node->linked = false;
+        --m_size;
+        Insert(node);
+        node = next;
+    }
+}
+
+void TimingWheel::Advance(uint64_t now, std::vector<Node*>& expired) {
+    while (m_current <= now) {
+        uint64_t tick = NextTick();
+        if (tick > now) {
+            // 中间的 tick 都没有节点,直接跳过
+            m_current = now + 1;
+            return;
+        }
+        m_current = tick;
+        // 从高层往低层级联,高层的节点可能落到低层本次要处理的槽里
+        int top = 0;
+        while (top + 1 < kLevels && !(tick & ((1ULL << (kSlotBits * (top + 1))) - 1))) {
+            ++top;
+        }
+        for (int level = top; level > 0; --level) {
+            Cascade(level, (tick >> (kSlotBits * level)) & kSlotMask);
+        }
+        size_t slot = tick & kSlotMask;
+        Node* node = m_slots[0][slot];
+        m_slots[0][slot] = nullptr;
+        m_bitmap[0][slot >> 6] &= ~(1ULL << (slot & 63));
+        while (node) {
+            Node* next = node->next;
+            node->prev = node->next = nullptr;
+            node->linked = false;
+            --m_size;
+            expired.push_back(node);
+            node = next;
+        }
+        m_current = tick + 1;
+    }
+}
+
+void TimingWheel::TakeAll(std::vector<Node*>& out) {
+    for (int level = 0; level < kLevels; ++level) {
+        for (size_t slot = 0; slot < kSlots; ++slot) {
+            for (Node* node = m_slots[level][slot]; node; ) {
+                Node* next = node->next;
+                node->prev = node->next = nullptr;
+                node->linked = false;
+                out.push_back(node);
+                node = next;
+            }
+            m_slots[level][slot] = nullptr;
+        }
+        for (auto &word : m_bitmap[level]) {
+            word = 0;
+        }
+    }
+    m_size = 0;
+}
+
+bool TimerId::Cancel() {
+    auto queue = m_queue.lock();
+    return queue && m_task && queue->Cancel(m_task);
+}
+
+bool TimerId::ResetNs(std::chrono::nanoseconds interval) {
+    auto queue = m_queue.lock();
+    return queue && m_task && queue->Reset(m_task, interval);
+}
+
+bool TimerId::SetSlackNs(std::chrono::nanoseconds slack) {
+    auto queue = m_queue.lock();
+    return queue && m_task && queue->SetSlack(m_task, slack);
+}
+
+bool TimerId::IsActive() const {
+    auto queue = m_queue.lock();
+    if (!queue || !m_task) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(queue->m_taskMtx);
+    return m_task->state != Task::State::DONE && !m_task->cancelled;
+}
+
+TimerQueue::TimerQueue(int pool_size, std::chrono::nanoseconds tick)
+    : TimerQueue(Options{pool_size, tick}) {
+
+}
+
+TimerQueue::TimerQueue(const Options& options)
+    : m_tickNs(std::max<int64_t>(options.tick.count(), 1)),
+      m_start(std::chrono::steady_clock::now()),
+      m_clock(options.clock),
+      m_driverThread(options.driver_thread),
+      m_defaultSlack(options.default_slack),
+      m_spinGuard(options.spin_guard),
+      m_cpu(options.cpu),
+      m_threadPool(options.pool_size) {
+    CHECK_THROW(m_driverThread || m_clock == ClockSource::TIMERFD, "timer without driver thread requires TIMERFD clock");
+    CHECK_THROW(m_spinGuard.count() >= 0, "timer spin guard must not be negative");
+    if (m_clock == ClockSource::TIMERFD) {
+        m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        CHECK_THROW(m_timerFd >= 0, "timerfd_create error:%s", strerror(errno));
+    }
+    // 第一个任务需要设置时钟源
+    m_nextWake = UINT64_MAX;
+}
+
+TimerQueue::~TimerQueue() {
+    // 没有调用 Shutdown 时线程池中可能还有 RunTask/OnFired,先等它们结束,再释放它们访问的成员和 timerfd
+    m_threadPool.Shutdown();
+    std::vector<TimingWheel::Node*> nodes{};
+    m_wheel.TakeAll(nodes);
+    for (auto node : nodes) {
+        static_cast<Task*>(node)->self.reset();
+    }
+    if (m_timerFd >= 0) {
+        close(m_timerFd);
+    }
 }
 
 void TimerQueue::Start() {
     m_threadPool.Start();
-    std::thread(&TimerQueue::LocalRun, shared_from_this()).detach();
+    if (m_driverThread) {
+        std::thread driver(&TimerQueue::LocalRun, shared_from_this());
+        if (m_cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(m_cpu, &set);
+            int ret = pthread_setaffinity_np(driver.native_handle(), sizeof(set), &set);
+            if (ret != 0) {
+                // 驱动线程持有 shared_from_this,先让它退出并停止线程池,否则队列永远不会释放
+                {
+                    std::lock_guard<std::mutex> lock(m_taskMtx);
+                    m_isTerminate = true;
+                    ArmClock(0);
+                }
+                m_cv.notify_all();
+                driver.join();
+                m_threadPool.Shutdown();
+                CHECK_THROW(false, "pthread_setaffinity_np failed, cpu:%d ret is:%d", m_cpu, ret);
+            }
+        }
+        driver.detach();
+    }
 }
 
 void TimerQueue::Shutdown() {
     std::unique_lock<std::mutex> lock(m_taskMtx);
-    m_cv.wait(lock, [this] {
-        return m_tasks.empty();
-    });
-    CHECK_THROW(m_tasks.empty(), "m_task not empty");
     CHECK_THROW((m_isTerminate == false), "TimerQueue has already shutdown");
+    m_isStopping = true;
+    // 无限次的周期定时器永远不会结束,直接取消
+    std::vector<TimingWheel::Node*> nodes{};
+    m_wheel.TakeAll(nodes);
+    for (auto node : nodes) {
+        Task* task = static_cast<Task*>(node);
+        if (task->remain == kInfinite) {
+            task->cancelled = true;
+            task->state = Task::State::DONE;
+            task->self.reset();
+        } else {
+            m_wheel.Insert(task);
+        }
+    }
+    m_drainCv.wait(lock, [this] {
+        return m_wheel.Empty() && !m_inflight;
+    });
     m_isTerminate = true;
     // 唤醒 demon 线程
     m_cv.notify_all();
+    if (m_clock == ClockSource::TIMERFD) {
+        ArmClock(0);
+    }
+    lock.unlock();
     m_threadPool.Shutdown();
 }
 
-void TimerQueue::LocalRun() {
-    while(!m_isTerminate) {
-        std::unique_lock<std::mutex> lock(m_taskMtx);
-        m_cv.wait(lock, [this] {
-            return !m_tasks.empty() || m_isTerminate;
-        });
-        if (m_isTerminate) {
+size_t TimerQueue::GetPendingCount() {
+    std::lock_guard<std::mutex> lock(m_taskMtx);
+    return m_wheel.Size();
+}
+
+TimerStats TimerQueue::GetStats() const {
+    TimerStats stats{};
+    stats.wakeups = m_wakeups.load(std::memory_order_relaxed);
+    stats.fired = m_lateness.Count();
+    stats.elapsed_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    stats.wakeups_per_sec = stats.elapsed_sec > 0 ? stats.wakeups / stats.elapsed_sec : 0;
+    stats.lateness_p50_ns = m_lateness.Percentile(0.5);
+    stats.lateness_p90_ns = m_lateness.Percentile(0.9);
+    stats.lateness_p99_ns = m_lateness.Percentile(0.99);
+    stats.lateness_p999_ns = m_lateness.Percentile(0.999);
+    stats.lateness_max_ns = m_lateness.Max();
+    stats.spin_sec = m_spinNs.load(std::memory_order_relaxed) / 1e9;
+    stats.late_wakeups = m_lateWakeups.load(std::memory_order_relaxed);
+    stats.failed = m_failed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t TimerQueue::ToTick(const TimePoint& timepoint) const {
+    if (timepoint <= m_start) {
+        return 0;
+    }
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timepoint - m_start).count();
+    return (ns + m_tickNs - 1) / m_tickNs;
+}
+
+uint64_t TimerQueue::ExpireTick(const Task* task) const {
+    uint64_t lo = ToTick(task->timepoint);
+    if (task->slack.count() <= 0) {
+        return lo;
+    }
+    auto latest = task->timepoint + std::chrono::duration_cast<TimePoint::duration>(task->slack);
+    if (latest <= m_start) {
+        return lo;
+    }
+    uint64_t hi = std::chrono::duration_cast<std::chrono::nanoseconds>(latest - m_start).count() / m_tickNs;
+    if (hi <= lo) {
+        return lo;
+    }
+    // lo 与 hi 从最高的不同位开始,hi 的这一位为 1、lo 为 0,清掉 hi 更低的位后仍然在 [lo, hi] 内
+    int bit = 63 - __builtin_clzll(lo ^ hi);
+    return hi & ~((1ULL << bit) - 1);
+}
+
+uint64_t TimerQueue::NowTick() const {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+    return ns / m_tickNs;
+}
+
+TimerQueue::TimePoint TimerQueue::TickToTime(uint64_t tick) const {
+    return m_start + std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds(tick * m_tickNs));
+}
+
+void TimerQueue::ArmClock(uint64_t tick) {
+    if (m_clock != ClockSource::TIMERFD) {
+        return;
+    }
+    struct itimerspec spec{};
+    if (tick != UINT64_MAX) {
+        // steady_clock 就是 CLOCK_MONOTONIC
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(TickToTime(tick).time_since_epoch()).count();
+        ns = std::max<int64_t>(ns, 1);
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+    }
+    int rt = timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    CHECK_THROW(rt == 0, "timerfd_settime error:%s", strerror(errno));
+}
+
+TimerId TimerQueue::Schedule(Func&& func, const TimePoint& timepoint, std::chrono::nanoseconds interval,
+                             size_t repeat, RepeatMode mode) {
+    auto task = ObjectPool<Task>::MakeShared();
+    task->func = std::move(func);
+    task->timepoint = timepoint;
+    task->interval = interval;
+    task->remain = repeat;
+    task->mode = mode;
+    task->slack = m_defaultSlack;
+    std::lock_guard<std::mutex> lock(m_taskMtx);
+    CHECK_THROW(!m_isTerminate, "TimerQueue has already shutdown");
+    task->self = task;
+    Arm(task.get());
+    return TimerId(weak_from_this(), std::move(task));
+}
+
+void TimerQueue::Arm(Task* task) {
+    task->expire = ExpireTick(task);
+    task->state = Task::State::PENDING;
+    m_wheel.Insert(task);
+    // 只有比驱动线程计划醒来更早的任务才需要唤醒它,这里实际上只会有一个线程阻塞在这个条件变量上面
+    if (task->expire < m_nextWake) {
+        if (m_clock == ClockSource::TIMERFD) {
+            // 直接把 timerfd 提前,驱动线程不需要醒来重新计算
+            m_nextWake = task->expire;
+            ArmClock(task->expire);
+        } else {
+            m_nextWake = 0;
+            m_cv.notify_one();
+        }
+    }
+}
+
+bool TimerQueue::Cancel(const TaskPtr& task) {
+    std::lock_guard<std::mutex> lock(m_taskMtx);
+    if (task->cancelled || task->state == Task::State::DONE) {
+        return false;
+    }
+    task->cancelled = true;
+    if (task->state == Task::State::PENDING) {
+        m_wheel.Remove(task.get());
+        task->state = Task::State::DONE;
+        task->self.reset();
+        if (m_wheel.Empty() && !m_inflight) {
+            m_drainCv.notify_all();
+        }
+    }
+    // RUNNING 状态由 OnFired 结束
+    return true;
+}
+
+bool TimerQueue::Reset(const TaskPtr& task, std::chrono::nanoseconds interval) {
+    CHECK_THROW(interval.count() >= 0, "timer interval must not be negative");
+    std::lock_guard<std::mutex> lock(m_taskMtx);
+    if (task->cancelled || task->state == Task::State::DONE) {
+        return false;
+    }
+    if (task->interval.count()) {
+        CHECK_THROW(interval.count() > 0, "repeat interval must be positive");
+        task->interval = interval;
+    }
+    auto timepoint = std::chrono::steady_clock::now() + std::chrono::duration_cast<TimePoint::duration>(interval);
+    if (task->state == Task::State::PENDING) {
+        m_wheel.Remove(task.get());
+        task->timepoint = timepoint;
+        Arm(task.get());
+    } else {
+        // RUNNING 状态下回调结束后按新的时间重新放入,一次性定时器也会再触发一次
+        task->reset_timepoint = timepoint;
+    }
+    return true;
+}
+
+bool TimerQueue::SetSlack(const TaskPtr& task, std::chrono::nanoseconds slack) {
+    CHECK_THROW(slack.count() >= 0, "timer slack must not be negative");
+    std::lock_guard<std::mutex> lock(m_taskMtx);
+    if (task->cancelled || task->state == Task::State::DONE) {
+        return false;
+    }
+    task->slack = slack;
+    if (task->state == Task::State::PENDING) {
+        m_wheel.Remove(task.get());
+        Arm(task.get());
+    }
+    return true;
+}
+
+void TimerQueue::OnFired(const TaskPtr& task) {
+    std::lock_guard<std::mutex> lock(m_taskMtx);
+    --m_inflight;
+    if (task->remain != kInfinite) {
+        --task->remain;
+    }
+    auto reset_timepoint = task->reset_timepoint;
+    task->reset_timepoint.reset();
+    if (reset_timepoint && !task->interval.count()) {
+        task->remain = 1;
+    }
+    bool rearm = (task->interval.count() || reset_timepoint) && task->remain && !task->cancelled &&
+                 !(m_isStopping && task->remain == kInfinite);
+    if (rearm) {
+        auto now = std::chrono::steady_clock::now();
+        auto interval = std::chrono::duration_cast<TimePoint::duration>(task->interval);
+        if (reset_timepoint) {
+            task->timepoint = *reset_timepoint;
+        } else if (task->mode == RepeatMode::FIXED_DELAY) {
+            task->timepoint = now + interval;
+        } else {
+            task->timepoint += interval;
+            if (task->timepoint <= now) {
+                // 跳过错过的周期
+                task->timepoint += ((now - task->timepoint) / interval + 1) * interval;
+            }
+        }
+        Arm(task.get());
+    } else {
+        task->state = Task::State::DONE;
+        task->self.reset();
+    }
+    if (m_wheel.Empty() && !m_inflight) {
+        m_drainCv.notify_all();
+    }
+}
+
+bool TimerQueue::DispatchExpired(std::unique_lock<std::mutex>& lock) {
+    m_wheel.Advance(NowTick(), m_expired);
+    if (m_expired.empty()) {
+        return false;
+    }
+    for (auto node : m_expired) {
+        Task* task = static_cast<Task*>(node);
+        task->state = Task::State::RUNNING;
+        m_running.push_back(task->self);
+    }
+    m_inflight += m_expired.size();
+    m_expired.clear();
+    lock.unlock();
+    for (auto &task : m_running) {
+        // 回调结束后再决定是否重新放入时间轮,同一个定时器的回调不会并发执行
+        if (m_clock == ClockSource::PRECISE) {
+            // 回调在驱动线程上执行,异常不能继续抛出,否则驱动线程退出且本批剩余的任务丢失
+            try {
+                RunTask(task);
+            } catch (const std::exception& e) {
+                std::cerr << "TimerQueue task func exec error:" << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "TimerQueue task func exec error: unknown exception" << std::endl;
+            }
+        } else {
+            m_threadPool.post([this, task = std::move(task)] {
+                RunTask(task);
+            });
+        }
+    }
+    m_running.clear();
+    lock.lock();
+    return true;
+}
+
+void TimerQueue::RunTask(const TaskPtr& task) {
+    m_lateness.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - task->timepoint).count());
+    try {
+        task->func();
+    } catch (...) {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        OnFired(task);
+        throw;
+    }
+    OnFired(task);
+}
+
+void TimerQueue::WaitPrecise(std::unique_lock<std::mutex>& lock, uint64_t next) {
+    if (next == UINT64_MAX) {
+        m_cv.wait(lock);
+        return;
+    }
+    auto deadline = TickToTime(next);
+    auto wake = deadline - std::chrono::duration_cast<TimePoint::duration>(m_spinGuard);
+    if (std::chrono::steady_clock::now() < wake) {
+        m_cv.wait_until(lock, wake);
+        // 有更早的任务、需要退出或者提前醒来时回到主循环重新计算
+        if (m_nextWake.load(std::memory_order_relaxed) != next || m_isTerminate ||
+            std::chrono::steady_clock::now() < wake) {
             return;
         }
-        CHECK_THROW((m_tasks.empty() == false), "m_task is empty");
-        if (!m_tasks.empty()) {
-            auto now = std::chrono::steady_clock::now();
-            for (auto task = m_tasks.begin(); task != m_tasks.end(); task++) {
-                auto diff = (*task)->timepoint - now;
-                auto taskptr = *task;
-                if (std::chrono::duration_cast<std::chrono::nanoseconds>(diff).count() > 0) {
-                    // std::cout << std::chrono::duration_cast<std::chrono::seconds>(diff).count() << std::endl;
-                    m_threadPool.execute([taskptr] {
-                        std::this_thread::sleep_until(taskptr->timepoint);
-                        taskptr->func();
-                    });
-                }
+    }
+    lock.unlock();
+    auto begin = std::chrono::steady_clock::now();
+    if (begin > deadline) {
+        m_lateWakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto now = begin;
+    while (now < deadline && m_nextWake.load(std::memory_order_relaxed) == next) {
+        CPU_RELAX();
+        now = std::chrono::steady_clock::now();
+    }
+    m_spinNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(now - begin).count(),
+                       std::memory_order_relaxed);
+    lock.lock();
+}
+
+void TimerQueue::HandleEvents() {
+    uint64_t expirations = 0;
+    while (read(m_timerFd, &expirations, sizeof(expirations)) > 0) {}
+    std::unique_lock<std::mutex> lock(m_taskMtx);
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    m_nextWake = 0;
+    while (DispatchExpired(lock)) {}
+    m_nextWake = m_isTerminate ? UINT64_MAX : m_wheel.NextTick();
+    ArmClock(m_nextWake);
+}
+
+void TimerQueue::LocalRun() {
+    std::unique_lock<std::mutex> lock(m_taskMtx);
+    while (!m_isTerminate) {
+        if (DispatchExpired(lock)) {
+            continue;
+        }
+
+        uint64_t next = m_wheel.NextTick();
+        m_nextWake = next;
+        if (m_clock == ClockSource::TIMERFD) {
+            ArmClock(next);
+            lock.unlock();
+            struct pollfd pfd{m_timerFd, POLLIN, 0};
+            if (poll(&pfd, 1, -1) > 0) {
+                uint64_t expirations = 0;
+                while (read(m_timerFd, &expirations, sizeof(expirations)) > 0) {}
             }
-            m_tasks.clear();
+            lock.lock();
+        } else if (m_clock == ClockSource::PRECISE) {
+            WaitPrecise(lock, next);
+        } else if (next == UINT64_MAX) {
+            m_cv.wait(lock);
+        } else {
+            m_cv.wait_until(lock, TickToTime(next));
         }
-        
-        // 唤醒可能因为调用 Shutdown 阻塞在 m_cv 上的线程
-        m_cv.notify_all();
+        m_nextWake = 0;
+        m_wakeups.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
-}
\ No newline at end of file
+}
@@ -1,9 +1,36 @@
 #include "config.h"
+#include <sys/stat.h>
+#include <fstream>
 
 namespace why {
 
-ConfigVarManager::ConfigVarMap ConfigVarManager::m_datas{};
-std::mutex ConfigVarManager::m_mtx{};
+/**
+ * @description: LoadFromConfDir 缓存的单个配置文件信息
+ */
+struct ConfFile {
+    int64_t mtime{0};
+    int64_t size{0};
+    int priority{0};
+    YAML::Node node;
+};
+
+// [目录, [文件路径, ConfFile]]
+static std::map<std::string, std::map<std::string, ConfFile>> s_confDirs;
+static std::mutex s_confDirMtx;
+
+// [文件后缀, ConfigSource]
+static std::unordered_map<std::string, ConfigSource::ptr> s_sources = {
+    {".yml", std::make_shared<YamlConfigSource>()},
+    {".yaml", std::make_shared<YamlConfigSource>()},
+    {".json", std::make_shared<JsonConfigSource>()},
+    {".properties", std::make_shared<PropertiesConfigSource>()},
+};
+static std::mutex s_sourceMtx;
+
+ConfigVarTable& ConfigVarManager::GetDatas() {
+    static ConfigVarTable s_datas{};
+    return s_datas;
+}
 
 void ConfigVarManager::ParseAllNodes(const std::string& prefix, 
                               const YAML::Node& node, 
@@ -42,4 +69,138 @@ void ConfigVarManager::LoadFromYaml(const YAML::Node& node) {
     }
 }
 
+static int ParsePriority(const std::string& filename) {
+    std::string name = FSUtil::Basename(filename);
+    name = name.substr(0, name.rfind('.'));
+    auto pos = name.rfind('@');
+    if (pos == std::string::npos || pos + 1 == name.size()) {
+        return 0;
+    }
+    const char* begin = name.c_str() + pos + 1;
+    char* end = nullptr;
+    long priority = strtol(begin, &end, 10);
+    return *end == '\0' ? static_cast<int>(priority) : 0;
+}
+
+static void MergeYaml(YAML::Node dst, const YAML::Node& src) {
+    for (auto iter = src.begin(); iter != src.end(); ++iter) {
+        const std::string& key = iter->first.Scalar();
+        YAML::Node sub = dst[key];
+        if (sub.IsMap() && iter->second.IsMap()) {
+            MergeYaml(sub, iter->second);
+        } else {
+            dst[key] = YAML::Clone(iter->second);
+        }
+    }
+}
+
+void ConfigVarManager::LoadFromConfDir(const std::string& path, bool force) {
+    std::vector<std::string> files{};
+    FSUtil::ListAllFile(files, path, ".yml");
+    FSUtil::ListAllFile(files, path, ".yaml");
+
+    LOCK_GUARD lock(s_confDirMtx);
+    auto &cache = s_confDirs[path];
+    bool changed = force || files.size() != cache.size();
+    std::map<std::string, ConfFile> cur{};
+    std::vector<std::string> dirty{};
+    for (auto &file : files) {
+        struct stat st;
+        if (stat(file.c_str(), &st) != 0) {
+            continue;
+        }
+        ConfFile info{};
+        info.mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+        info.size = st.st_size;
+        info.priority = ParsePriority(file);
+        auto iter = cache.find(file);
+        if (!force && iter != cache.end() && 
+            iter->second.mtime == info.mtime && iter->second.size == info.size) {
+            info.node = iter->second.node;
+        } else {
+            dirty.push_back(file);
+            changed = true;
+        }
+        cur.emplace(file, std::move(info));
+    }
+    if (!changed) {
+        return;
+    }
+
+    // 只有一个文件需要解析时没有必要创建线程
+    if (dirty.size() == 1) {
+        try {
+            cur[dirty[0]].node = YAML::LoadFile(dirty[0]);
+        } catch (const std::exception& e) {
+            CHECK_THROW(false, "load config file:%s failed, what:%s", dirty[0].c_str(), e.what());
+        }
+    } else if (!dirty.empty()) {
+        ThreadPool pool(std::max<size_t>(1, std::min<size_t>(dirty.size(), std::thread::hardware_concurrency())));
+        pool.Start();
+        std::vector<std::future<YAML::Node>> results{};
+        for (auto &file : dirty) {
+            results.push_back(pool.execute([&file] {
+                return YAML::LoadFile(file);
+            }));
+        }
+        for (size_t i = 0; i < dirty.size(); ++i) {
+            try {
+                cur[dirty[i]].node = results[i].get();
+            } catch (const std::exception& e) {
+                CHECK_THROW(false, "load config file:%s failed, what:%s", dirty[i].c_str(), e.what());
+            }
+        }
+    }
+
+    std::vector<const std::pair<const std::string, ConfFile>*> order{};
+    for (auto &i : cur) {
+        order.push_back(&i);
+    }
+    // std::map 已经按路径排好序, stable_sort 保证同优先级时按路径顺序合并
+    std::stable_sort(order.begin(), order.end(), [](auto l, auto r) {
+        return l->second.priority < r->second.priority;
+    });
+    YAML::Node merged(YAML::NodeType::Map);
+    for (auto i : order) {
+        if (i->second.node.IsMap()) {
+            MergeYaml(merged, i->second.node);
+        }
+    }
+    cache.swap(cur);
+    LoadFromYaml(merged);
+}
+
+void ConfigVarManager::LoadFromSource(const ConfigSource& source, std::string_view content) {
+    ConfigEntries entries{};
+    source.Parse(content, entries);
+    for (auto &i : entries.items) {
+        ConfigVarBase::ptr ptr = LookUpBase(ConfigKey(i.first));
+        if (ptr == nullptr) continue;
+        ptr->FromString(std::string(i.second));
+    }
+}
+
+void ConfigVarManager::LoadFromFile(const std::string& filename) {
+    auto pos = filename.rfind('.');
+    CHECK_THROW(pos != std::string::npos, "config file:%s has no suffix", filename.c_str());
+    ConfigSource::ptr source{};
+    {
+        LOCK_GUARD lock(s_sourceMtx);
+        auto iter = s_sources.find(ToLower(filename.substr(pos)));
+        CHECK_THROW(iter != s_sources.end(), "no ConfigSource for config file:%s", filename.c_str());
+        source = iter->second;
+    }
+
+    std::ifstream ifs{};
+    CHECK_THROW(FSUtil::OpenForRead(ifs, filename, std::ios::in | std::ios::binary), 
+                "open config file:%s failed", filename.c_str());
+    std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    LoadFromSource(*source, content);
+}
+
+void ConfigVarManager::RegisterSource(const std::string& suffix, ConfigSource::ptr source) {
+    LOCK_GUARD lock(s_sourceMtx);
+    s_sources[ToLower(suffix)] = source;
+}
+
 }
\ No newline at end of file
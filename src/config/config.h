@@ -25,9 +25,70 @@
 #include <unordered_set>
 #include <utility>
 #include <functional>
+#include <string_view>
+#include <typeinfo>
 #include "common.h"
+#include "config_source.h"
 namespace why {
 
+/**
+ * @description: 配置变量的 key,保存名称以及忽略大小写的 FNV-1a 哈希值
+ * @details 通过 WHY_CONFIG_KEY 宏构造时哈希在编译期完成,查找时不再需要拼接字符串与 tolower
+ */
+class ConfigKey {
+public:
+    constexpr ConfigKey(const char* name, size_t len, uint64_t hash)
+        : m_name(name, len), m_hash(hash) {}
+
+    explicit ConfigKey(std::string_view name)
+        : m_name(name), m_hash(Hash(name.data(), name.size())) {}
+
+    std::string_view GetName() const { return m_name; }
+    uint64_t GetHash() const { return m_hash; }
+
+    /**
+     * @description: 配置变量表插入新变量时用名称构造 key
+     */
+    explicit operator std::string() const { return std::string(m_name); }
+
+    static constexpr char ToLower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static constexpr uint64_t Hash(const char* str, size_t len) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < len; ++i) {
+            hash ^= static_cast<uint8_t>(ToLower(str[i]));
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    /**
+     * @description: 编译期使用,名称含有非法字符时抛异常,从而导致编译失败
+     */
+    static constexpr uint64_t CheckedHash(const char* str, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            char c = str[i];
+            if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '.' || c == '_')) {
+                throw "config key has invalid letter";
+            }
+        }
+        return Hash(str, len);
+    }
+
+private:
+    std::string_view m_name;
+    uint64_t m_hash{0};
+};
+
+/**
+ * @description: 构造编译期哈希的配置 key,如 WHY_CONFIG_KEY("fiber.stack_size")
+ */
+#define WHY_CONFIG_KEY(name) \
+    why::ConfigKey(name, sizeof(name) - 1, \
+                   std::integral_constant<uint64_t, why::ConfigKey::CheckedHash(name, sizeof(name) - 1)>::value)
+
 
 
 /**
@@ -248,12 +309,161 @@ public:
 
     virtual const char* GetTypeName() const = 0;
 
+    /**
+     * @description: 返回实际 ConfigVar 类型的 type_info,用于替代 dynamic_pointer_cast 的类型检查
+     */
+    virtual const std::type_info& GetTypeInfo() const = 0;
+
 protected:
     std::string m_name;
     std::string m_description;
 
 };
 
+/**
+ * @description: 配置变量的只读视图,持有不可变快照的引用计数
+ * @details 配置变量更新时会生成新的快照,已经取到的视图仍然指向旧快照,因此可以无锁、无拷贝地长期持有
+ */
+template<typename T>
+class ConfigValueView {
+public:
+    using Snapshot = T;
+
+    ConfigValueView(std::shared_ptr<const Snapshot> snapshot) : m_snapshot(std::move(snapshot)) {}
+
+    const T& operator*() const { return *m_snapshot; }
+    const T* operator->() const { return m_snapshot.get(); }
+
+    static std::shared_ptr<const Snapshot> MakeSnapshot(const T& val) {
+        return std::make_shared<const Snapshot>(val);
+    }
+
+private:
+    std::shared_ptr<const Snapshot> m_snapshot;
+};
+
+/**
+ * @description: std::string 配置变量的视图,以 string_view 访问
+ */
+class ConfigStringView {
+public:
+    using Snapshot = std::string;
+
+    ConfigStringView(std::shared_ptr<const Snapshot> snapshot) : m_snapshot(std::move(snapshot)) {}
+
+    std::string_view View() const { return *m_snapshot; }
+    operator std::string_view() const { return *m_snapshot; }
+    const char* data() const { return m_snapshot->data(); }
+    size_t size() const { return m_snapshot->size(); }
+    bool empty() const { return m_snapshot->empty(); }
+
+    static std::shared_ptr<const Snapshot> MakeSnapshot(const std::string& val) {
+        return std::make_shared<const Snapshot>(val);
+    }
+
+private:
+    std::shared_ptr<const Snapshot> m_snapshot;
+};
+
+/**
+ * @description: std::vector 配置变量的视图,类似 span 的连续只读访问
+ */
+template<typename E>
+class ConfigSpanView {
+public:
+    using Snapshot = std::vector<E>;
+    using const_iterator = const E*;
+
+    ConfigSpanView(std::shared_ptr<const Snapshot> snapshot) : m_snapshot(std::move(snapshot)) {}
+
+    const E* data() const { return m_snapshot->data(); }
+    size_t size() const { return m_snapshot->size(); }
+    bool empty() const { return m_snapshot->empty(); }
+    const E& operator[](size_t idx) const { return (*m_snapshot)[idx]; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+
+    static std::shared_ptr<const Snapshot> MakeSnapshot(const std::vector<E>& val) {
+        return std::make_shared<const Snapshot>(val);
+    }
+
+private:
+    std::shared_ptr<const Snapshot> m_snapshot;
+};
+
+/**
+ * @description: 以 string 为 key 的 map 配置变量的视图,快照为按 key 排序的扁平数组,二分查找
+ */
+template<typename V>
+class ConfigFlatMapView {
+public:
+    using value_type = std::pair<std::string, V>;
+    using Snapshot = std::vector<value_type>;
+    using const_iterator = typename Snapshot::const_iterator;
+
+    ConfigFlatMapView(std::shared_ptr<const Snapshot> snapshot) : m_snapshot(std::move(snapshot)) {}
+
+    /**
+     * @description: 查找 key,不存在返回 nullptr
+     */
+    const V* Find(std::string_view key) const {
+        auto iter = std::lower_bound(m_snapshot->begin(), m_snapshot->end(), key, 
+                                     [](const value_type& l, std::string_view r) {
+            return std::string_view(l.first) < r;
+        });
+        if (iter == m_snapshot->end() || iter->first != key) {
+            return nullptr;
+        }
+        return &iter->second;
+    }
+
+    bool Contains(std::string_view key) const { return Find(key) != nullptr; }
+    size_t size() const { return m_snapshot->size(); }
+    bool empty() const { return m_snapshot->empty(); }
+    const_iterator begin() const { return m_snapshot->begin(); }
+    const_iterator end() const { return m_snapshot->end(); }
+
+    template<typename Map>
+    static std::shared_ptr<const Snapshot> MakeSnapshot(const Map& val) {
+        auto snapshot = std::make_shared<Snapshot>(val.begin(), val.end());
+        std::sort(snapshot->begin(), snapshot->end(), [](const value_type& l, const value_type& r) {
+            return l.first < r.first;
+        });
+        return snapshot;
+    }
+
+private:
+    std::shared_ptr<const Snapshot> m_snapshot;
+};
+
+/**
+ * @description: 配置变量类型到视图类型的映射
+ */
+template<typename T>
+struct ConfigViewTraits {
+    using View = ConfigValueView<T>;
+};
+
+template<>
+struct ConfigViewTraits<std::string> {
+    using View = ConfigStringView;
+};
+
+template<typename E>
+struct ConfigViewTraits<std::vector<E>> {
+    using View = ConfigSpanView<E>;
+};
+
+template<typename V>
+struct ConfigViewTraits<std::map<std::string, V>> {
+    using View = ConfigFlatMapView<V>;
+};
+
+template<typename V>
+struct ConfigViewTraits<std::unordered_map<std::string, V>> {
+    using View = ConfigFlatMapView<V>;
+};
+
 /**
  * @description: 管理[配置变量]的实体
  */
@@ -264,6 +474,7 @@ class ConfigVar : public ConfigVarBase {
 public:
     using ptr = std::shared_ptr<ConfigVar>;
     using OnChangeCb = std::function<void(const T& old_val, const T& new_val)>;
+    using View = typename ConfigViewTraits<T>::View;
     ConfigVar(const std::string& name,
               const T& default_value,
               const std::string& description)
@@ -294,6 +505,8 @@ public:
 
     const char* GetTypeName() const override { return TypeToName<T>();}
 
+    const std::type_info& GetTypeInfo() const override { return typeid(ConfigVar); }
+
     const T& GetValue() { 
         LOCK_GUARD lock(m_mtx);
         return m_val;
@@ -309,6 +522,24 @@ public:
             cb.second(m_val, val);
         }
         m_val = val;
+        // 旧快照由已经取到的视图继续持有,下次 GetView 时重新生成
+        std::atomic_store(&m_snapshot, std::shared_ptr<const typename View::Snapshot>());
+    }
+
+    /**
+     * @description: 获取当前值的只读视图,快照未失效时无锁且不拷贝
+     */
+    View GetView() {
+        auto snapshot = std::atomic_load(&m_snapshot);
+        if (snapshot == nullptr) {
+            LOCK_GUARD lock(m_mtx);
+            snapshot = std::atomic_load(&m_snapshot);
+            if (snapshot == nullptr) {
+                snapshot = View::MakeSnapshot(m_val);
+                std::atomic_store(&m_snapshot, snapshot);
+            }
+        }
+        return View(std::move(snapshot));
     }
 
     uint64_t AddListener(const OnChangeCb& cb) {
@@ -334,70 +565,94 @@ public:
 
 private:
     T m_val;// 特定类型的配置变量
+    // m_val 的不可变快照,为空表示需要重新生成
+    std::shared_ptr<const typename View::Snapshot> m_snapshot;
     std::map<uint64_t, OnChangeCb> m_cbs;
     std::mutex m_mtx;
 };
 
+/**
+ * @description: 配置变量表的哈希函数,ConfigKey 直接使用预计算的哈希,与 ConfigKey::Hash 结果一致
+ */
+struct ConfigKeyHash {
+    using is_transparent = void;
+
+    uint64_t operator()(const ConfigKey& key) const { return key.GetHash(); }
+    uint64_t operator()(std::string_view name) const { return ConfigKey::Hash(name.data(), name.size()); }
+};
+
+/**
+ * @description: 表中保存的名称在 ConfigVarBase 中已经统一转换为小写,与 ConfigKey 比较时忽略大小写
+ */
+struct ConfigKeyEqual {
+    using is_transparent = void;
+
+    bool operator()(const std::string& name, const ConfigKey& key) const {
+        std::string_view str = key.GetName();
+        if (name.size() != str.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < str.size(); ++i) {
+            if (name[i] != ConfigKey::ToLower(str[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator()(const std::string& lhs, const std::string& rhs) const { return lhs == rhs; }
+};
+
+// [配置变量名, ConfigVar],查找只加分片读锁
+using ConfigVarTable = ConcurrentHashMap<std::string, ConfigVarBase::ptr, ConfigKeyHash, ConfigKeyEqual>;
+
 /**
  * @description: 配置模块,ConfigVar 的管理类,提供接口访问、管理 ConfigVar
  */
 class ConfigVarManager : public Noncopyable {
 public:
-    using ConfigVarMap = std::unordered_map<std::string, ConfigVarBase::ptr>;
-    
     ConfigVarManager() = delete;
     ~ConfigVarManager() = delete;
     
     /**
-     * @description: 查找名称为 name 的配置变量，找不到则创建一个配置变量并插入
+     * @description: 查找 key 对应的配置变量，找不到则创建一个配置变量并插入
      * @return: 注意返回值是子类的智能指针
      */
     template<typename T>
-    static typename ConfigVar<T>::ptr LookUp(const std::string& name, 
+    static typename ConfigVar<T>::ptr LookUp(const ConfigKey& key, 
                                              const T& default_value,
                                              const std::string& desc = "") {
-        UNIQUE_LOCK lock(m_mtx);
-        auto iter = m_datas.find(name);
-        if (iter != m_datas.end()) {
-            lock.unlock();
-            auto tmp = std::dynamic_pointer_cast<ConfigVar<T>>(iter->second);
-            if (tmp == nullptr) {
-                CHECK_THROW(false, "ConfigVar of name:%s exists, but realtype is:%s, cur type is:%s", 
-                            name.c_str(), iter->second->GetTypeName(), TypeToName<T>());
-                return nullptr;
-            } else {
-                return tmp;
-            }
-        }                                                
-        
-        if (name.find_first_not_of(kKeyRegularLetter) != std::string::npos) {
-            lock.unlock();
+        auto var = GetDatas().Find(key);
+        if (var) {
+            return CastTo<T>(*var);
+        }
+
+        if (key.GetName().find_first_not_of(kKeyRegularLetter) != std::string_view::npos) {
             CHECK_THROW(false, "record ConfigVar:%s failed, cause it's name has invalid letter which not belong %s",
-                      name.c_str(), kKeyRegularLetter);
+                      std::string(key.GetName()).c_str(), kKeyRegularLetter);
             return nullptr;
         }
 
-        const auto &ret = m_datas.emplace(name, std::make_shared<ConfigVar<T>>(name, default_value, desc));
-        return std::dynamic_pointer_cast<ConfigVar<T>>(ret.first->second);
+        // 并发创建同名变量时只有一个会被插入,其他线程拿到的是已插入的变量
+        auto ret = GetDatas().GetOrCreate(key, [&key, &default_value, &desc]() -> ConfigVarBase::ptr {
+            return std::make_shared<ConfigVar<T>>(std::string(key.GetName()), default_value, desc);
+        });
+        return CastTo<T>(ret);
     }
 
-    // /**
-    //  * @description: 查找名称(name)对应的配置变量,找不到返回 nullptr,注意调用此接口时必须显示指定模板参数
-    //  */
-    // template<typename T>
-    // static typename ConfigVar<T>::ptr LookUp(const std::string& name) {
-    //     LOCK_GUARD lock(m_mtx);
-    //     auto iter = m_datas.find(name);
-    //     if (iter == m_datas.end()) {
-    //         return nullptr;
-    //     }
-    //     return std::dynamic_pointer_cast<ConfigVar<T>>(iter->second);
-    // }
+    template<typename T>
+    static typename ConfigVar<T>::ptr LookUp(const std::string& name, 
+                                             const T& default_value,
+                                             const std::string& desc = "") {
+        return LookUp<T>(ConfigKey(name), default_value, desc);
+    }
+
+    static ConfigVarBase::ptr LookUpBase(const ConfigKey& key) {
+        return GetDatas().Find(key).value_or(nullptr);
+    }
 
     static ConfigVarBase::ptr LookUpBase(const std::string& name) {
-        LOCK_GUARD lock(m_mtx);
-        auto iter = m_datas.find(name);
-        return iter == m_datas.end() ? nullptr : iter->second;
+        return LookUpBase(ConfigKey(name));
     }
 
     /**
@@ -405,6 +660,32 @@ public:
      */
     static void LoadFromYaml(const YAML::Node& node);
 
+    /**
+     * @description: 加载 path 目录(递归)下所有 .yml/.yaml 配置文件,各文件在线程池中并行解析,合并后一次性应用
+     * @details 合并顺序: 先按文件名中的优先级后缀(如 log@10.yml,无后缀为 0)升序,再按路径字典序,
+     *          后合并的文件覆盖先合并的同名配置; map 递归合并,其他类型整体覆盖
+     *          mtime 与 size 都没有变化的文件复用上次的解析结果,目录下没有任何文件变化时直接返回
+     * @param {string&} path 配置目录
+     * @param {bool} force 为 true 时忽略缓存,重新解析并应用所有文件
+     */
+    static void LoadFromConfDir(const std::string& path, bool force = false);
+
+    /**
+     * @description: 使用指定的 ConfigSource 解析 content 并应用,解析全部成功后才会修改配置变量
+     */
+    static void LoadFromSource(const ConfigSource& source, std::string_view content);
+
+    /**
+     * @description: 按文件后缀选择已注册的 ConfigSource 加载配置文件
+     * @details 默认注册了 .yml/.yaml/.json/.properties
+     */
+    static void LoadFromFile(const std::string& filename);
+
+    /**
+     * @description: 为文件后缀(如 ".json")注册 ConfigSource,已存在时覆盖
+     */
+    static void RegisterSource(const std::string& suffix, ConfigSource::ptr source);
+
 private:
     /**
      * @description: 解析出 YAML::Node 所有可能的中间变量
@@ -417,10 +698,45 @@ private:
                               const YAML::Node& node, 
                               std::vector<std::pair<std::string, YAML::Node>>& output); 
 
+    /**
+     * @description: 通过 type_info 比较做类型检查,避免 dynamic_pointer_cast
+     */
+    template<typename T>
+    static typename ConfigVar<T>::ptr CastTo(const ConfigVarBase::ptr& var) {
+        if (var->GetTypeInfo() != typeid(ConfigVar<T>)) {
+            CHECK_THROW(false, "ConfigVar of name:%s exists, but realtype is:%s, cur type is:%s", 
+                        var->GetName().c_str(), var->GetTypeName(), TypeToName<T>());
+            return nullptr;
+        }
+        return std::static_pointer_cast<ConfigVar<T>>(var);
+    }
+
+    /**
+     * @description: 所有配置变量,第一次使用时构造
+     * @details 其他编译单元(如 thread_config.cpp)在静态初始化期间就会 LookUp,不能依赖静态成员的初始化顺序
+     */
+    static ConfigVarTable& GetDatas();
+
 private:
     static constexpr auto kKeyRegularLetter = "abcdefghijklmnopqrstuvwxyz0123456789._";
-    static ConfigVarMap m_datas;
-    static std::mutex m_mtx;
+};
+
+/**
+ * @description: 类型化的配置变量句柄,构造时解析一次,之后访问不再查表、加全局锁与做类型检查
+ * @details 用法: static ConfigVarHandle<int> g_port(WHY_CONFIG_KEY("system.port"), 8080, "system port");
+ */
+template<typename T>
+class ConfigVarHandle {
+public:
+    ConfigVarHandle(const ConfigKey& key, const T& default_value, const std::string& desc = "")
+        : m_var(ConfigVarManager::LookUp<T>(key, default_value, desc)) {}
+
+    ConfigVar<T>* operator->() const { return m_var.get(); }
+
+    const typename ConfigVar<T>::ptr& Get() const { return m_var; }
+
+private:
+    typename ConfigVar<T>::ptr m_var;
 };
 
 }
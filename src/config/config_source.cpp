@@ -0,0 +1,355 @@
+#include "config_source.h"
+#include "common.h"
+#include <sstream>
+#include <yaml-cpp/yaml.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace why {
+
+static void ParseYamlNode(std::string& prefix, const YAML::Node& node, ConfigEntries& out) {
+    if (!prefix.empty()) {
+        if (node.IsScalar()) {
+            out.items.emplace_back(prefix, out.Store(std::string(node.Scalar())));
+        } else {
+            std::stringstream ss;
+            ss << node;
+            out.items.emplace_back(prefix, out.Store(ss.str()));
+        }
+    }
+    if (node.IsMap()) {
+        size_t len = prefix.size();
+        for (auto iter = node.begin(); iter != node.end(); ++iter) {
+            if (len) {
+                prefix += '.';
+            }
+            prefix += iter->first.Scalar();
+            ParseYamlNode(prefix, iter->second, out);
+            prefix.resize(len);
+        }
+    }
+}
+
+void YamlConfigSource::Parse(std::string_view content, ConfigEntries& out) const {
+    YAML::Node node = YAML::Load(std::string(content));
+    std::string prefix{};
+    ParseYamlNode(prefix, node, out);
+}
+
+/**
+ * @description: 返回 [p, end) 中第一个 '"' 或 '\\' 的位置,没有则返回 end
+ */
+static const char* FindQuoteOrEscape(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    for (; p + 16 <= end; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                  _mm_cmpeq_epi8(chunk, escape)));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == '"' || *p == '\\') {
+            return p;
+        }
+    }
+    return end;
+}
+
+/**
+ * @description: 返回 [p, end) 中第一个结构字符('"' '[' ']' '{' '}')的位置,没有则返回 end
+ */
+static const char* FindStructural(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i square_open = _mm_set1_epi8('[');
+    const __m128i square_close = _mm_set1_epi8(']');
+    const __m128i curly_open = _mm_set1_epi8('{');
+    const __m128i curly_close = _mm_set1_epi8('}');
+    for (; p + 16 <= end; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i square = _mm_or_si128(_mm_cmpeq_epi8(chunk, square_open), _mm_cmpeq_epi8(chunk, square_close));
+        __m128i curly = _mm_or_si128(_mm_cmpeq_epi8(chunk, curly_open), _mm_cmpeq_epi8(chunk, curly_close));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_or_si128(square, curly)));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        char c = *p;
+        if (c == '"' || c == '[' || c == ']' || c == '{' || c == '}') {
+            return p;
+        }
+    }
+    return end;
+}
+
+static void AppendUtf8(std::string& str, uint32_t code) {
+    if (code < 0x80) {
+        str += static_cast<char>(code);
+    } else if (code < 0x800) {
+        str += static_cast<char>(0xc0 | (code >> 6));
+        str += static_cast<char>(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        str += static_cast<char>(0xe0 | (code >> 12));
+        str += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        str += static_cast<char>(0x80 | (code & 0x3f));
+    } else {
+        str += static_cast<char>(0xf0 | (code >> 18));
+        str += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+        str += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        str += static_cast<char>(0x80 | (code & 0x3f));
+    }
+}
+
+/**
+ * @description: 递归下降的 JSON 解析器,只展开 object,其余值以原始文本输出
+ */
+class JsonParser {
+public:
+    JsonParser(std::string_view content, ConfigEntries& out)
+        : m_begin(content.data()), m_cur(content.data()),
+          m_end(content.data() + content.size()), m_out(out) {}
+
+    void Parse() {
+        SkipSpace();
+        Expect('{');
+        std::string prefix{};
+        ParseObject(prefix);
+        SkipSpace();
+        CHECK_THROW(m_cur == m_end, "json parse error at offset:%zu, unexpected trailing content", Offset());
+    }
+
+private:
+    size_t Offset() const { return m_cur - m_begin; }
+
+    void SkipSpace() {
+        while (m_cur < m_end && (*m_cur == ' ' || *m_cur == '\n' || *m_cur == '\r' || *m_cur == '\t')) {
+            ++m_cur;
+        }
+    }
+
+    void Expect(char c) {
+        CHECK_THROW(m_cur < m_end && *m_cur == c, "json parse error at offset:%zu, expect '%c'", Offset(), c);
+        ++m_cur;
+    }
+
+    /**
+     * @description: m_cur 指向起始的 '"',返回字符串内容,不含转义时直接引用原始内容
+     */
+    std::string_view ParseString() {
+        Expect('"');
+        const char* start = m_cur;
+        const char* p = FindQuoteOrEscape(m_cur, m_end);
+        CHECK_THROW(p < m_end, "json parse error at offset:%zu, unterminated string", Offset());
+        if (*p == '"') {
+            m_cur = p + 1;
+            return std::string_view(start, p - start);
+        }
+
+        std::string str(start, p - start);
+        while (true) {
+            CHECK_THROW(p < m_end, "json parse error at offset:%zu, unterminated string", Offset());
+            if (*p == '"') {
+                break;
+            }
+            // *p == '\\'
+            CHECK_THROW(p + 1 < m_end, "json parse error at offset:%zu, unterminated string", Offset());
+            char c = p[1];
+            p += 2;
+            switch (c) {
+                case '"': str += '"'; break;
+                case '\\': str += '\\'; break;
+                case '/': str += '/'; break;
+                case 'b': str += '\b'; break;
+                case 'f': str += '\f'; break;
+                case 'n': str += '\n'; break;
+                case 'r': str += '\r'; break;
+                case 't': str += '\t'; break;
+                case 'u': {
+                    uint32_t code = ParseHex4(p);
+                    p += 4;
+                    if (code >= 0xd800 && code < 0xdc00 && p + 6 <= m_end && p[0] == '\\' && p[1] == 'u') {
+                        uint32_t low = ParseHex4(p + 2);
+                        if (low >= 0xdc00 && low < 0xe000) {
+                            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                            p += 6;
+                        }
+                    }
+                    AppendUtf8(str, code);
+                    break;
+                }
+                default:
+                    m_cur = p;
+                    CHECK_THROW(false, "json parse error at offset:%zu, invalid escape '\\%c'", Offset(), c);
+            }
+            const char* next = FindQuoteOrEscape(p, m_end);
+            str.append(p, next - p);
+            p = next;
+        }
+        m_cur = p + 1;
+        return m_out.Store(std::move(str));
+    }
+
+    uint32_t ParseHex4(const char* p) {
+        CHECK_THROW(p + 4 <= m_end, "json parse error at offset:%zu, invalid unicode escape", Offset());
+        uint32_t code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = p[i];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                code |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                code |= c - 'A' + 10;
+            } else {
+                CHECK_THROW(false, "json parse error at offset:%zu, invalid unicode escape", Offset());
+            }
+        }
+        return code;
+    }
+
+    /**
+     * @description: m_cur 指向 '{' 之后
+     */
+    void ParseObject(std::string& prefix) {
+        SkipSpace();
+        if (m_cur < m_end && *m_cur == '}') {
+            ++m_cur;
+            return;
+        }
+        size_t len = prefix.size();
+        while (true) {
+            SkipSpace();
+            std::string_view name = ParseString();
+            if (len) {
+                prefix += '.';
+            }
+            prefix.append(name.data(), name.size());
+            SkipSpace();
+            Expect(':');
+            SkipSpace();
+            ParseMember(prefix);
+            prefix.resize(len);
+
+            SkipSpace();
+            CHECK_THROW(m_cur < m_end, "json parse error at offset:%zu, unterminated object", Offset());
+            if (*m_cur == ',') {
+                ++m_cur;
+                continue;
+            }
+            Expect('}');
+            return;
+        }
+    }
+
+    void ParseMember(const std::string& key) {
+        CHECK_THROW(m_cur < m_end, "json parse error at offset:%zu, expect value", Offset());
+        char c = *m_cur;
+        if (c == '"') {
+            std::string_view val = ParseString();
+            m_out.items.emplace_back(key, val);
+        } else if (c == '{') {
+            // 先占位,保证父节点在子节点之前输出
+            size_t idx = m_out.items.size();
+            m_out.items.emplace_back(key, std::string_view{});
+            const char* start = m_cur++;
+            std::string prefix = key;
+            ParseObject(prefix);
+            m_out.items[idx].second = std::string_view(start, m_cur - start);
+        } else if (c == '[') {
+            const char* start = m_cur;
+            SkipArray();
+            m_out.items.emplace_back(key, std::string_view(start, m_cur - start));
+        } else {
+            const char* start = m_cur;
+            while (m_cur < m_end && *m_cur != ',' && *m_cur != '}' && *m_cur != ']' &&
+                   *m_cur != ' ' && *m_cur != '\n' && *m_cur != '\r' && *m_cur != '\t') {
+                ++m_cur;
+            }
+            CHECK_THROW(m_cur > start, "json parse error at offset:%zu, expect value", Offset());
+            m_out.items.emplace_back(key, std::string_view(start, m_cur - start));
+        }
+    }
+
+    /**
+     * @description: 只做括号匹配跳过整个数组,数组内容由 LexicalCast 解析
+     */
+    void SkipArray() {
+        int depth = 0;
+        const char* p = m_cur;
+        while (true) {
+            p = FindStructural(p, m_end);
+            if (p == m_end) {
+                break;
+            }
+            char c = *p++;
+            if (c == '"') {
+                while (true) {
+                    p = FindQuoteOrEscape(p, m_end);
+                    if (p == m_end || *p == '"') {
+                        break;
+                    }
+                    p += 2;
+                }
+                if (p >= m_end) {
+                    break;
+                }
+                ++p;
+            } else if (c == '[' || c == '{') {
+                ++depth;
+            } else if (--depth == 0) {
+                m_cur = p;
+                return;
+            }
+        }
+        m_cur = m_end;
+        CHECK_THROW(false, "json parse error at offset:%zu, unterminated array", Offset());
+    }
+
+private:
+    const char* m_begin;
+    const char* m_cur;
+    const char* m_end;
+    ConfigEntries& m_out;
+};
+
+void JsonConfigSource::Parse(std::string_view content, ConfigEntries& out) const {
+    JsonParser(content, out).Parse();
+}
+
+static std::string_view Trim(std::string_view str) {
+    size_t begin = str.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return std::string_view{};
+    }
+    size_t end = str.find_last_not_of(" \t\r");
+    return str.substr(begin, end - begin + 1);
+}
+
+void PropertiesConfigSource::Parse(std::string_view content, ConfigEntries& out) const {
+    size_t line_no = 0;
+    while (!content.empty()) {
+        ++line_no;
+        size_t pos = content.find('\n');
+        std::string_view line = Trim(content.substr(0, pos));
+        content = (pos == std::string_view::npos) ? std::string_view{} : content.substr(pos + 1);
+        if (line.empty() || line[0] == '#' || line[0] == '!') {
+            continue;
+        }
+        size_t eq = line.find('=');
+        CHECK_THROW(eq != std::string_view::npos, "properties parse error at line:%zu, expect '='", line_no);
+        std::string_view key = Trim(line.substr(0, eq));
+        CHECK_THROW(!key.empty(), "properties parse error at line:%zu, empty key", line_no);
+        out.items.emplace_back(std::string(key), Trim(line.substr(eq + 1)));
+    }
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 10:20:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 10:20:00
+ * @FilePath: /cpp_basic_library/src/config/config_source.h
+ * @Description: 配置来源,将不同格式的配置内容解析为 [配置名, 值字符串] 序列
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_CONFIG_SOURCE_H__
+#define __WHY_CONFIG_SOURCE_H__
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <utility>
+
+namespace why {
+
+/**
+ * @description: ConfigSource 的解析结果
+ * @details value 尽量直接指向原始内容(零拷贝),需要转义等处理的值保存在 storage 中
+ */
+struct ConfigEntries {
+    // [以 '.' 连接的配置名, 可以直接交给 ConfigVarBase::FromString 的值]
+    std::vector<std::pair<std::string, std::string_view>> items;
+    std::deque<std::string> storage;
+
+    /**
+     * @description: 保存一个需要自己持有内存的值
+     */
+    std::string_view Store(std::string&& val) {
+        storage.push_back(std::move(val));
+        return storage.back();
+    }
+};
+
+/**
+ * @description: 配置来源的抽象,每种配置格式实现一个子类
+ * @details 解析时与 LoadFromYaml 相同,map 的每一层都会输出一项,先输出父节点再输出子节点,
+ *          序列与 map 的值以 YAML 可以解析的文本输出,交由 LexicalCast 转换
+ */
+class ConfigSource {
+public:
+    using ptr = std::shared_ptr<ConfigSource>;
+
+    virtual ~ConfigSource() = default;
+
+    /**
+     * @description: 解析 content,结果追加到 out 中,content 需要比 out 的生命周期长
+     */
+    virtual void Parse(std::string_view content, ConfigEntries& out) const = 0;
+
+    virtual const char* GetName() const = 0;
+};
+
+/**
+ * @description: 基于 yaml-cpp 的配置来源
+ */
+class YamlConfigSource : public ConfigSource {
+public:
+    void Parse(std::string_view content, ConfigEntries& out) const override;
+    const char* GetName() const override { return "yaml"; }
+};
+
+/**
+ * @description: 手写的 JSON 配置来源
+ * @details 标量与不含转义的字符串直接引用原始内容; 数组不展开,
+ *          支持 SSE2 时用 SIMD 扫描结构字符以快速跳过数组与字符串
+ */
+class JsonConfigSource : public ConfigSource {
+public:
+    void Parse(std::string_view content, ConfigEntries& out) const override;
+    const char* GetName() const override { return "json"; }
+};
+
+/**
+ * @description: 扁平的 a.b.c=value 格式配置来源,以 '#' 或 '!' 开头的行为注释
+ */
+class PropertiesConfigSource : public ConfigSource {
+public:
+    void Parse(std::string_view content, ConfigEntries& out) const override;
+    const char* GetName() const override { return "properties"; }
+};
+
+}
+
+#endif
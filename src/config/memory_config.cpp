@@ -0,0 +1,70 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 23:00:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 23:00:00
+ * @FilePath: /cpp_basic_library/src/config/memory_config.cpp
+ * @Description: 大页分配器的配置
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#include "memory_config.h"
+#include <sstream>
+
+namespace why {
+
+HugePageAllocator::Config LexicalCast<std::string, HugePageAllocator::Config>::operator()(const std::string& val) {
+    YAML::Node node = YAML::Load(val);
+    HugePageAllocator::Config config{};
+    if (!node.IsMap()) {
+        CHECK_THROW(false, "huge page config must be a map, it's [%s]", val.c_str());
+    }
+    if (node["enabled"].IsDefined()) {
+        config.enabled = node["enabled"].as<bool>();
+    }
+    if (node["region_size"].IsDefined()) {
+        config.region_size = node["region_size"].as<size_t>();
+        CHECK_THROW(config.region_size > 0, "huge page region_size must be positive");
+    }
+    auto &options = config.options;
+    if (node["hugetlb"].IsDefined()) {
+        options.hugetlb = node["hugetlb"].as<bool>();
+    }
+    if (node["transparent"].IsDefined()) {
+        options.transparent = node["transparent"].as<bool>();
+    }
+    if (node["lock"].IsDefined()) {
+        options.lock = node["lock"].as<bool>();
+    }
+    if (node["prefault"].IsDefined()) {
+        options.prefault = node["prefault"].as<bool>();
+    }
+    return config;
+}
+
+std::string LexicalCast<HugePageAllocator::Config, std::string>::operator()(const HugePageAllocator::Config& config) {
+    YAML::Node node(YAML::NodeType::Map);
+    node["enabled"] = config.enabled;
+    node["region_size"] = config.region_size;
+    node["hugetlb"] = config.options.hugetlb;
+    node["transparent"] = config.options.transparent;
+    node["lock"] = config.options.lock;
+    node["prefault"] = config.options.prefault;
+    return (std::stringstream() << node).str();
+}
+
+static ConfigVar<HugePageAllocator::Config>::ptr g_huge_page_config =
+    ConfigVarManager::LookUp("memory.huge_pages", HugePageAllocator::Config(), "huge page allocator config");
+
+struct HugePageConfigIniter {
+    HugePageConfigIniter() {
+        g_huge_page_config->AddListener([](const HugePageAllocator::Config& old_val,
+                                           const HugePageAllocator::Config& new_val) {
+            HugePageAllocator::Configure(new_val);
+        });
+    }
+};
+
+static HugePageConfigIniter huge_page_config_initer;
+
+}
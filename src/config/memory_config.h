@@ -0,0 +1,43 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 23:00:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 23:00:00
+ * @FilePath: /cpp_basic_library/src/config/memory_config.h
+ * @Description: 大页分配器的配置
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_MEMORY_CONFIG_H__
+#define __WHY_MEMORY_CONFIG_H__
+
+#include <string>
+#include "config.h"
+
+namespace why {
+
+/**
+ * @description: HugePageAllocator 配置与 YAML 字符串的相互转换,配置变化时立即调用 HugePageAllocator::Configure
+ * @details 格式:
+ *          memory:
+ *            huge_pages:
+ *              enabled: true          # 默认 false,ObjectPool 的 slab 等常驻内存从大页区域分配
+ *              region_size: 33554432  # 每次向系统映射的区域大小
+ *              hugetlb: true          # 先尝试 MAP_HUGETLB
+ *              transparent: true      # 再尝试 madvise(MADV_HUGEPAGE)
+ *              lock: false            # mlock
+ *              prefault: false        # 映射后立即访问每一页
+ */
+template<>
+struct LexicalCast<std::string, HugePageAllocator::Config> {
+    HugePageAllocator::Config operator()(const std::string& val);
+};
+
+template<>
+struct LexicalCast<HugePageAllocator::Config, std::string> {
+    std::string operator()(const HugePageAllocator::Config& config);
+};
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 19:00:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 19:00:00
+ * @FilePath: /cpp_basic_library/src/config/thread_config.cpp
+ * @Description: 线程池工作线程参数的配置
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#include "thread_config.h"
+#include <sstream>
+
+namespace why {
+
+static const char* kPlacementNames[] = {"none", "spread", "pack"};
+static const char* kPolicyNames[] = {"other", "batch", "idle", "fifo", "rr"};
+
+template<typename E, size_t N>
+static E FromName(const char* const (&names)[N], std::string val, const char* what) {
+    std::transform(val.begin(), val.end(), val.begin(), ::tolower);
+    for (size_t i = 0; i < N; ++i) {
+        if (val == names[i]) {
+            return static_cast<E>(i);
+        }
+    }
+    CHECK_THROW(false, "unknown %s:%s", what, val.c_str());
+    return static_cast<E>(0);
+}
+
+ThreadPool::WorkerOptions LexicalCast<std::string, ThreadPool::WorkerOptions>::operator()(const std::string& val) {
+    YAML::Node node = YAML::Load(val);
+    ThreadPool::WorkerOptions options{};
+    if (!node.IsMap()) {
+        CHECK_THROW(false, "thread pool config must be a map, it's [%s]", val.c_str());
+    }
+    auto &thread = options.thread;
+    if (node["name"].IsDefined()) {
+        thread.name = node["name"].as<std::string>();
+    }
+    if (node["placement"].IsDefined()) {
+        options.placement = FromName<ThreadPool::CpuPlacement>(kPlacementNames, node["placement"].Scalar(), "placement");
+    }
+    if (node["cpus"].IsDefined()) {
+        if (node["cpus"].IsSequence()) {
+            for (size_t i = 0; i < node["cpus"].size(); ++i) {
+                thread.cpus.push_back(node["cpus"][i].as<int>());
+            }
+        } else {
+            thread.cpus = CpuTopology::ParseCpuList(node["cpus"].Scalar());
+        }
+    }
+    if (node["numa_node"].IsDefined()) {
+        thread.numa_node = node["numa_node"].as<int>();
+    }
+    if (node["policy"].IsDefined()) {
+        thread.policy = FromName<SchedPolicy>(kPolicyNames, node["policy"].Scalar(), "sched policy");
+    }
+    if (node["priority"].IsDefined()) {
+        thread.priority = node["priority"].as<int>();
+    }
+    if (node["nice"].IsDefined()) {
+        thread.nice = node["nice"].as<int>();
+    }
+    if (node["stack_size"].IsDefined()) {
+        thread.stack_size = node["stack_size"].as<size_t>();
+    }
+    return options;
+}
+
+std::string LexicalCast<ThreadPool::WorkerOptions, std::string>::operator()(const ThreadPool::WorkerOptions& options) {
+    YAML::Node node(YAML::NodeType::Map);
+    auto &thread = options.thread;
+    if (!thread.name.empty()) {
+        node["name"] = thread.name;
+    }
+    node["placement"] = kPlacementNames[static_cast<int>(options.placement)];
+    if (!thread.cpus.empty()) {
+        YAML::Node cpus(YAML::NodeType::Sequence);
+        for (int cpu : thread.cpus) {
+            cpus.push_back(cpu);
+        }
+        node["cpus"] = cpus;
+    }
+    node["numa_node"] = thread.numa_node;
+    node["policy"] = kPolicyNames[static_cast<int>(thread.policy)];
+    node["priority"] = thread.priority;
+    node["nice"] = thread.nice;
+    node["stack_size"] = thread.stack_size;
+    return (std::stringstream() << node).str();
+}
+
+static ConfigVar<std::map<std::string, ThreadPool::WorkerOptions>>::ptr g_thread_pool_config =
+    ConfigVarManager::LookUp("threadpools", std::map<std::string, ThreadPool::WorkerOptions>(), "thread pool workers config");
+
+ThreadPool::WorkerOptions GetWorkerOptions(const std::string& pool) {
+    auto view = g_thread_pool_config->GetView();
+    auto options = view.Find(pool);
+    return options ? *options : ThreadPool::WorkerOptions{};
+}
+
+}
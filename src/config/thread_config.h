@@ -0,0 +1,51 @@
+/*
+ * @Author: wuhanyi1 874864297@qq.com
+ * @Date: 2026-10-19 19:00:00
+ * @LastEditors: wuhanyi1 874864297@qq.com
+ * @LastEditTime: 2026-10-19 19:00:00
+ * @FilePath: /cpp_basic_library/src/config/thread_config.h
+ * @Description: 线程池工作线程参数的配置
+ *
+ * Copyright (c) 2026 by wuhanyi1 874864297@qq.com, All Rights Reserved.
+ */
+#ifndef __WHY_THREAD_CONFIG_H__
+#define __WHY_THREAD_CONFIG_H__
+
+#include <string>
+#include "config.h"
+
+namespace why {
+
+/**
+ * @description: 工作线程参数与 YAML 字符串的相互转换
+ * @details 格式:
+ *          threadpools:
+ *            io:
+ *              name: io               # 线程名前缀
+ *              placement: spread      # none/spread/pack
+ *              cpus: 0-3,8            # CPU 列表,也可以写成序列 [0, 1, 2]
+ *              numa_node: 0
+ *              policy: fifo           # other/batch/idle/fifo/rr
+ *              priority: 10
+ *              nice: 0
+ *              stack_size: 1048576
+ */
+template<>
+struct LexicalCast<std::string, ThreadPool::WorkerOptions> {
+    ThreadPool::WorkerOptions operator()(const std::string& val);
+};
+
+template<>
+struct LexicalCast<ThreadPool::WorkerOptions, std::string> {
+    std::string operator()(const ThreadPool::WorkerOptions& options);
+};
+
+/**
+ * @description: 配置 threadpools.<pool> 中的工作线程参数,没有配置时返回默认值
+ * @details 用法: pool.SetWorkerOptions(GetWorkerOptions("io")); pool.Start();
+ */
+ThreadPool::WorkerOptions GetWorkerOptions(const std::string& pool);
+
+}
+
+#endif
@@ -80,8 +80,9 @@ private:
     std::mutex m_mutex;
     Config m_config;
     std::shared_ptr<rpc::server> m_server;
-    std::unordered_map<std::string, std::shared_ptr<PublisherInfo>> m_pubs;
-    std::unordered_map<std::string, std::shared_ptr<SubscriberInfo>> m_subs;
+    // [topic_name, info],注册表自身分片加锁,m_mutex 只保护 m_server
+    ConcurrentHashMap<std::string, std::shared_ptr<PublisherInfo>> m_pubs;
+    ConcurrentHashMap<std::string, std::shared_ptr<SubscriberInfo>> m_subs;
 };
 
 }
@@ -19,14 +19,9 @@ void ServiceManager::Start() {
 }
 
 void ServiceManager::RegisterPublisher(const PublisherInfo &pub_info) {
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        auto iter = m_pubs.find(pub_info.topic_name);
-        if (iter != m_pubs.end()) {
-            LOG_WARN("publisher:%s register repeatitively", pub_info.topic_name.c_str());
-            return;
-        }
-        m_pubs[pub_info.topic_name] = std::make_shared<PublisherInfo>(pub_info);
+    if (!m_pubs.Insert(pub_info.topic_name, std::make_shared<PublisherInfo>(pub_info))) {
+        LOG_WARN("publisher:%s register repeatitively", pub_info.topic_name.c_str());
+        return;
     }
 
     
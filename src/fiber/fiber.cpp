@@ -2,6 +2,9 @@
 #include "common.h"
 #include "config.h"
 #include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace why {
 
@@ -16,18 +19,84 @@ static constexpr uint64_t kKeyDefaultStackSize = 128 * 1024;
 ConfigVar<uint64_t>::ptr g_stack_size_config = 
     ConfigVarManager::LookUp("fiber.stack_size", kKeyDefaultStackSize, "fiber stack size");
 
+// malloc 或 huge_page,huge_page 需要同时开启 memory.huge_pages
+ConfigVar<std::string>::ptr g_stack_allocator_config =
+    ConfigVarManager::LookUp("fiber.stack_allocator", std::string("malloc"), "fiber stack allocator");
+
 class MallocStackAllocator {
 public:
-    static void* Allocate(uint32_t size) {
+    static void* Allocate(uint64_t size) {
         return malloc(size);
     }
 
-    static void Dealloc(void* ptr) {
+    static void Dealloc(void* ptr, uint64_t) {
         free(ptr);
     }
 };
 
-using StackAllocator = MallocStackAllocator;
+/**
+ * @description: 从 HugePageAllocator 的大页区域切分协程栈,减少栈切换后的 TLB miss
+ * @details 大页区域不能单独释放,释放的栈按大小缓存起来给之后的协程复用;HugePageAllocator 未开启时返回 nullptr
+ */
+class HugePageStackAllocator {
+public:
+    static void* Allocate(uint64_t size) {
+        auto& cache = GetCache();
+        {
+            LOCK_GUARD_T(Mutex) lock(cache.mutex);
+            auto& stacks = cache.stacks[size];
+            if (!stacks.empty()) {
+                void* ptr = stacks.back();
+                stacks.pop_back();
+                return ptr;
+            }
+        }
+        return HugePageAllocator::Allocate(size);
+    }
+
+    static void Dealloc(void* ptr, uint64_t size) {
+        auto& cache = GetCache();
+        LOCK_GUARD_T(Mutex) lock(cache.mutex);
+        cache.stacks[size].push_back(ptr);
+    }
+
+private:
+    struct Cache {
+        Mutex mutex;
+        std::unordered_map<uint64_t, std::vector<void*>> stacks;
+    };
+
+    static Cache& GetCache() {
+        static Cache* s_cache = new Cache();
+        return *s_cache;
+    }
+};
+
+/**
+ * @description: 按 fiber.stack_allocator 选择栈的分配方式,大页不可用时回退到 malloc
+ */
+class StackAllocator {
+public:
+    static void* Allocate(uint64_t size, bool& huge_page) {
+        huge_page = false;
+        if (g_stack_allocator_config->GetValue() == "huge_page") {
+            void* ptr = HugePageStackAllocator::Allocate(size);
+            if (ptr) {
+                huge_page = true;
+                return ptr;
+            }
+        }
+        return MallocStackAllocator::Allocate(size);
+    }
+
+    static void Dealloc(void* ptr, uint64_t size, bool huge_page) {
+        if (huge_page) {
+            HugePageStackAllocator::Dealloc(ptr, size);
+        } else {
+            MallocStackAllocator::Dealloc(ptr, size);
+        }
+    }
+};
 
 Fiber::Fiber(std::function<void()>& cb, uint64_t stk_size) : 
     m_cb(cb), 
@@ -42,8 +111,19 @@ Fiber::Fiber(std::function<void()>& cb, uint64_t stk_size) :
         CHECK_THROW(false, "Fiber::Fiber failed");
     }
 
-    m_stkPtr = StackAllocator::Allocate(m_stkSize);
+    m_stkPtr = StackAllocator::Allocate(m_stkSize, m_stkHugePage);
+
+}
+
+Fiber::~Fiber() {
+    --s_fiber_num;
+    if (m_stkPtr) {
+        StackAllocator::Dealloc(m_stkPtr, m_stkSize, m_stkHugePage);
+    }
+}
 
+Fiber::ptr Fiber::Create(std::function<void()> cb, uint64_t stk_size) {
+    return ObjectPool<Fiber>::MakeShared(cb, stk_size);
 }
 
 Fiber::Fiber() {
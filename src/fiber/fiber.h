@@ -40,6 +40,12 @@ public:
     State GetState() const { return m_state; }
 
 public:
+    /**
+     * @description: 创建协程,Fiber 对象与 shared_ptr 控制块从 ObjectPool 中分配
+     * @param {uint64_t} stk_size 为 0 时使用配置 fiber.stack_size
+     */
+    static Fiber::ptr Create(std::function<void()> cb, uint64_t stk_size = 0);
+
     /**
      * @description: 将 f 设置为当前线程的运行协程
      */
@@ -77,6 +83,8 @@ private:
     uint64_t m_stkSize{0};
     uint64_t m_id{-1};
     void* m_stkPtr{nullptr};
+    // 栈是否从大页区域分配,见 fiber.stack_allocator
+    bool m_stkHugePage{false};
     State m_state{State::INIT};
     ucontext_t m_ctx{};
     std::function<void()> m_cb;
@@ -543,7 +543,7 @@ void LogFormatter::Format(LogEvent::ptr event,  std::ostream &ofs) {
 }
 
 void LogAppender::SetFormatter(LogFormatter::ptr val) {
-    LOCK_GUARD lock(m_mutex);
+    LOCK_GUARD_T(Mutex) lock(m_mutex);
     m_formatter = val;
     if (!m_hasFormatter) {
         m_hasFormatter = true;
@@ -551,19 +551,19 @@ void LogAppender::SetFormatter(LogFormatter::ptr val) {
 }
 
 LogFormatter::ptr LogAppender::GetFormatter() {
-    LOCK_GUARD lock(m_mutex);
+    LOCK_GUARD_T(Mutex) lock(m_mutex);
     return m_formatter;
 }
 
 void StdOutLogAppender::Log(LogEvent::ptr event, LogLevel::Level level) {
     if (level >= m_level) {
-        LOCK_GUARD lock(m_mutex);
+        LOCK_GUARD_T(Mutex) lock(m_mutex);
         m_formatter->Format(event, std::cout);
     }
 }
 
 std::string StdOutLogAppender::ToYamlString() {
-    LOCK_GUARD lock(m_mutex);
+    LOCK_GUARD_T(Mutex) lock(m_mutex);
     YAML::Node node;
     node["type"] = kKeyStdOutAppender;
     if(m_level != LogLevel::UNKNOWN) {
@@ -583,7 +583,7 @@ FileLogAppender::FileLogAppender(const std::string& filename)
 }
 
 bool FileLogAppender::Reopen() {
-    LOCK_GUARD lock(m_mutex);
+    LOCK_GUARD_T(Mutex) lock(m_mutex);
     if(m_filestream) {
         m_filestream.close();
     }
@@ -599,13 +599,13 @@ void FileLogAppender::Log(LogEvent::ptr event, LogLevel::Level level) {
             Reopen();
             m_lastTime = now;
         }
-        LOCK_GUARD lock(m_mutex);
+        LOCK_GUARD_T(Mutex) lock(m_mutex);
         m_formatter->Format(event, m_filestream);
     }
 }
 
 std::string FileLogAppender::ToYamlString() {
-    LOCK_GUARD lock(m_mutex);
+    LOCK_GUARD_T(Mutex) lock(m_mutex);
     YAML::Node node;
     node["type"] = kKeyFileAppender;
     node["file"] = m_filename;
@@ -634,32 +634,24 @@ std::stringstream& LogEventWrap::GetSS() {
 
 LoggerManager::LoggerManager() : m_root(std::make_shared<Logger>(kKeyRootLoggerName)) {
     m_root->AddAppender(std::make_shared<StdOutLogAppender>());
-    m_loggers[kKeyRootLoggerName] = m_root;
+    m_loggers.Insert(kKeyRootLoggerName, m_root);
 }
 
-Logger::ptr LoggerManager::GetLogger(const std::string &name) {
-    LOCK_GUARD lock(m_mutex);
-    auto iter = m_loggers.find(name);
-    if (iter != m_loggers.end()) {
-        return iter->second;
-    }
-
-    Logger::ptr logger = std::make_shared<Logger>(name, m_root);
-    m_loggers[name] = logger;
-    return logger;
+Logger::ptr LoggerManager::GetLogger(std::string_view name) {
+    return m_loggers.GetOrCreate(name, [this, name]() {
+        return std::make_shared<Logger>(std::string(name), m_root);
+    });
 }
 
-void LoggerManager::DelLogger(const std::string& name) {
-    LOCK_GUARD lock(m_mutex);
-    m_loggers.erase(name);
+void LoggerManager::DelLogger(std::string_view name) {
+    m_loggers.Erase(name);
 }
 
 std::string LoggerManager::ToYamlString() {
-    LOCK_GUARD lock(m_mutex);
     YAML::Node node;
-    for(auto& i : m_loggers) {
-        node.push_back(YAML::Load(i.second->ToYamlString()));
-    }
+    m_loggers.ForEach([&node](const std::string&, const Logger::ptr& logger) {
+        node.push_back(YAML::Load(logger->ToYamlString()));
+    });
     std::stringstream ss;
     ss << node;
     return ss.str();
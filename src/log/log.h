@@ -27,7 +27,7 @@
  */
 #define WHY_LOG_LEVEL_WITH_STREAM(logger, level) \
     if (logger->GetLevel() <= level) \
-        why::LogEventWrap(std::make_shared<why::LogEvent>(logger, level, __FILE__, __LINE__, \
+        why::LogEventWrap(why::ObjectPool<why::LogEvent>::MakeShared(logger, level, __FILE__, __LINE__, \
             0, 0, 0, why::GetCurrentSec(), why::ThisThread::GetName().c_str())).GetSS()
 
 #define WHY_LOG_DEBUG_WITH_STREAM(logger) WHY_LOG_LEVEL_WITH_STREAM(logger, why::LogLevel::DEBUG)
@@ -45,7 +45,7 @@
  */
 #define WHY_LOG_LEVEL(logger, level, ...)                                                                        \
     if (level >= logger->GetLevel()) {                                                                                \
-        auto event = std::make_shared<why::LogEvent>(logger, level, __FILE__, __LINE__, 0, 0, 0,                   \
+        auto event = why::ObjectPool<why::LogEvent>::MakeShared(logger, level, __FILE__, __LINE__, 0, 0, 0,                   \
             why::GetCurrentSec(), why::ThisThread::GetName().c_str());                                              \
         event->Format(__VA_ARGS__);                                                                              \
         logger->Log(event, level);                                                                                    \
@@ -253,8 +253,8 @@ public:
 protected:
     LogLevel::Level m_level{LogLevel::DEBUG};
     bool m_hasFormatter{false};
-    // TODO: 这里的临界区的时间较短，后面需要改成自旋锁
-    std::mutex m_mutex;
+    // 临界区很短,使用先自旋再阻塞的 Mutex
+    Mutex m_mutex;
     LogFormatter::ptr m_formatter{nullptr};
 };
 
@@ -359,11 +359,11 @@ public:
     /**
      * @description: 获取指定名称的 Logger,没有就创建一个对应名字的 Logger
      */
-    Logger::ptr GetLogger(const std::string &name);
+    Logger::ptr GetLogger(std::string_view name);
 
     Logger::ptr GetRoot() const { return m_root; }
 
-    void DelLogger(const std::string &name);
+    void DelLogger(std::string_view name);
 
     /**
      * @description: 将所有的日志器配置转成YAML String
@@ -375,9 +375,8 @@ private:
 
 private:
     static constexpr auto kKeyRootLoggerName = "root";
-    std::mutex m_mutex;
-    // 日志器容器
-    std::unordered_map<std::string, Logger::ptr> m_loggers;
+    // 日志器容器,GetLogger 命中时只加分片读锁
+    ConcurrentHashMap<std::string, Logger::ptr> m_loggers;
     // 主日志器
     Logger::ptr m_root;
 };
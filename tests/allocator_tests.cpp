@@ -0,0 +1,238 @@
+#include "common.h"
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @description: 统计存活对象个数,检查池中对象和 Arena 中对象的析构
+ */
+struct Counted {
+    static std::atomic<int> s_alive;
+
+    explicit Counted(int v = 0) : value(v) { s_alive++; }
+    ~Counted() { s_alive--; }
+
+    int value;
+    char payload[40];
+};
+std::atomic<int> Counted::s_alive{0};
+
+struct alignas(64) Aligned {
+    char data[64];
+};
+
+void test_object_pool() {
+    using Pool = why::ObjectPool<Counted>;
+    std::vector<Counted*> objs{};
+    for (int i = 0; i < 1000; ++i) {
+        objs.push_back(Pool::New(i));
+    }
+    ASSERT(Counted::s_alive == 1000);
+    ASSERT(std::set<Counted*>(objs.begin(), objs.end()).size() == objs.size());
+    for (auto obj : objs) {
+        Pool::Delete(obj);
+    }
+    ASSERT(Counted::s_alive == 0);
+
+    // 稳定状态下反复分配释放不再申请 slab
+    size_t blocks = Pool::GetStats().blocks;
+    ASSERT(blocks >= 1000);
+    for (int round = 0; round < 100; ++round) {
+        objs.clear();
+        for (int i = 0; i < 1000; ++i) {
+            objs.push_back(Pool::New(i));
+        }
+        for (auto obj : objs) {
+            Pool::Delete(obj);
+        }
+    }
+    ASSERT(Pool::GetStats().blocks == blocks);
+
+    {
+        auto unique = Pool::MakeUnique(1);
+        auto shared = Pool::MakeShared(2);
+        ASSERT(unique->value == 1 && shared->value == 2 && Counted::s_alive == 2);
+    }
+    ASSERT(Counted::s_alive == 0);
+
+    auto aligned = why::ObjectPool<Aligned>::New();
+    ASSERT(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+    why::ObjectPool<Aligned>::Delete(aligned);
+}
+
+/**
+ * @description: 生产者分配、消费者释放,块通过归还栈回到生产者,容量不随传递的对象数增长
+ */
+void test_cross_thread() {
+    using Pool = why::ObjectPool<std::string>;
+    constexpr int kItems = 200000;
+    why::SpscQueue<std::string*> queue(256);
+    std::thread consumer([&queue] {
+        int count = 0;
+        std::string* str = nullptr;
+        while (count < kItems) {
+            if (!queue.TryPop(str)) {
+                std::this_thread::yield();
+                continue;
+            }
+            ASSERT(*str == std::to_string(count));
+            Pool::Delete(str);
+            ++count;
+        }
+    });
+    for (int i = 0; i < kItems; ++i) {
+        auto str = Pool::New(std::to_string(i));
+        while (!queue.TryPush(str)) {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    ASSERT(Pool::GetStats().blocks < 4096);
+
+    // 线程退出后它持有的块回到全局,缓存被之后的线程复用
+    std::vector<Counted*> objs(100);
+    std::thread worker([&objs] {
+        for (auto& obj : objs) {
+            obj = why::ObjectPool<Counted>::New();
+        }
+    });
+    worker.join();
+    for (auto obj : objs) {
+        why::ObjectPool<Counted>::Delete(obj);
+    }
+    size_t blocks = why::ObjectPool<Counted>::GetStats().blocks;
+    std::vector<std::thread> threads{};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 100; ++i) {
+                why::ObjectPool<Counted>::Delete(why::ObjectPool<Counted>::New());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT(Counted::s_alive == 0 && why::ObjectPool<Counted>::GetStats().blocks <= blocks * 4);
+}
+
+void test_arena() {
+    {
+        why::Arena arena(256);
+        auto ints = arena.AllocateArray<int>(10);
+        for (int i = 0; i < 10; ++i) {
+            ints[i] = i;
+        }
+        auto aligned = arena.Create<Aligned>();
+        ASSERT(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+        for (int i = 0; i < 100; ++i) {
+            ASSERT(arena.Create<Counted>(i)->value == i);
+        }
+        // 大块单独分配,不影响当前块
+        auto big = static_cast<char*>(arena.Allocate(10000));
+        big[9999] = 1;
+        ASSERT(Counted::s_alive == 100 && ints[9] == 9);
+        ASSERT(arena.GetUsed() >= 10000 + 100 * sizeof(Counted));
+
+        size_t capacity = arena.GetCapacity();
+        arena.Reset();
+        ASSERT(Counted::s_alive == 0 && arena.GetUsed() == 0 && arena.GetCapacity() < capacity);
+        // 保留的块可以放下同样规模的小对象,不再申请内存
+        capacity = arena.GetCapacity();
+        for (int i = 0; i < 10; ++i) {
+            arena.Create<Counted>(i);
+        }
+        ASSERT(arena.GetCapacity() == capacity);
+    }
+    // 析构时也会析构 Create 的对象
+    ASSERT(Counted::s_alive == 0);
+
+    alignas(16) char buffer[4096];
+    why::Arena arena(buffer, sizeof(buffer));
+    why::ArenaResource resource(arena);
+    {
+        std::pmr::vector<int> vec(&resource);
+        for (int i = 0; i < 100; ++i) {
+            vec.push_back(i);
+        }
+        std::pmr::string str("a string longer than the small string buffer", &resource);
+        ASSERT(vec[99] == 99 && str.size() > 20);
+    }
+    ASSERT(arena.GetCapacity() == 0);
+    std::pmr::vector<int> large(4096, 1, &resource);
+    ASSERT(arena.GetCapacity() > 0 && large[4095] == 1);
+    why::ArenaResource other(arena);
+    ASSERT(resource == other);
+}
+
+void test_huge_page_region() {
+    size_t huge = why::HugePageRegion::GetHugePageSize();
+    ASSERT(huge >= 4096 && (huge & (huge - 1)) == 0);
+    why::HugePageOptions options{};
+    options.prefault = true;
+    options.lock = true;
+    why::HugePageRegion region(huge + 1, options);
+    // 无论回退到哪一种方式都能使用,大页方式下长度是大页的整数倍
+    ASSERT(region.GetData() && region.GetSize() > huge);
+    ASSERT(region.GetBacking() != why::HugePageRegion::Backing::NONE);
+    if (region.GetBacking() != why::HugePageRegion::Backing::NORMAL) {
+        ASSERT(region.GetSize() % huge == 0 && reinterpret_cast<uintptr_t>(region.GetData()) % huge == 0);
+    }
+    static_cast<char*>(region.GetData())[region.GetSize() - 1] = 1;
+    std::cout << "huge page region backing:" << why::HugePageRegion::BackingToString(region.GetBacking())
+              << " locked:" << region.IsLocked() << std::endl;
+
+    why::HugePageRegion moved(std::move(region));
+    ASSERT(!region.GetData() && moved.GetSize() > huge);
+
+    options = why::HugePageOptions{};
+    options.hugetlb = false;
+    options.transparent = false;
+    why::HugePageRegion normal(100, options);
+    ASSERT(normal.GetBacking() == why::HugePageRegion::Backing::NORMAL && normal.GetSize() == 4096);
+
+    // Arena 可以直接使用大页区域作为初始缓冲区
+    why::Arena arena(moved.GetData(), moved.GetSize());
+    arena.Allocate(huge);
+    ASSERT(arena.GetCapacity() == 0);
+}
+
+/**
+ * @description: 开启 HugePageAllocator 后 ObjectPool 的 slab 从大页区域分配
+ */
+void test_huge_page_allocator() {
+    struct Block {
+        char data[128];
+    };
+    why::HugePageAllocator::Config config{};
+    config.enabled = true;
+    config.region_size = 4 << 20;
+    config.options.hugetlb = false;
+    why::HugePageAllocator::Configure(config);
+    auto block = why::ObjectPool<Block>::New();
+    auto stats = why::HugePageAllocator::GetStats();
+    ASSERT(stats.used_bytes >= sizeof(Block) && stats.mapped_bytes >= config.region_size);
+    ASSERT(stats.hugetlb_regions == 0 && stats.transparent_regions + stats.normal_regions == 1);
+    why::ObjectPool<Block>::Delete(block);
+
+    // 超过 region_size 的请求单独映射
+    ASSERT(why::HugePageAllocator::Allocate(8 << 20, 64) != nullptr);
+    ASSERT(why::HugePageAllocator::GetStats().mapped_bytes >= (12 << 20));
+    config.enabled = false;
+    why::HugePageAllocator::Configure(config);
+    ASSERT(why::HugePageAllocator::Allocate(64) == nullptr);
+}
+
+int main() {
+    test_object_pool();
+    test_cross_thread();
+    test_arena();
+    test_huge_page_region();
+    test_huge_page_allocator();
+    std::cout << "allocator_tests passed" << std::endl;
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include "config.h"
 #include "log.h"
+#include "thread_config.h"
+#include "memory_config.h"
 #include <yaml-cpp/yaml.h>
 
 struct Person {
@@ -24,6 +26,8 @@ why::ConfigVar<std::list<int>>::ptr int_list_config_val =
 why::ConfigVar<std::map<std::string, int>>::ptr int_map_config_val = 
         why::ConfigVarManager::LookUp("system.map", (std::map<std::string, int>){{"value1", 22}, {"value2", 33}}, "system map");
 
+why::ConfigVarHandle<int> int_config_handle(WHY_CONFIG_KEY("system.port"), (int)8080, "system port");
+
 why::ConfigVar<std::vector<Person>>::ptr person_class_config_val = 
         why::ConfigVarManager::LookUp("system.class", (std::vector<Person>){(Person){18, 185, "Tom"}, (Person){19, 183, "Nick"}}, "system class");
 
@@ -164,6 +168,81 @@ void test_config() {
 }
 
 
+void test_config_handle() {
+    // 编译期哈希的 key 与运行时字符串 key 查到的是同一个配置变量
+    ASSERT(int_config_handle.Get() == int_config_val);
+    ASSERT(why::ConfigVarManager::LookUpBase(WHY_CONFIG_KEY("system.port")) == int_config_val);
+    ASSERT(why::ConfigVarManager::LookUpBase("SYSTEM.PORT") == int_config_val);
+    ASSERT(why::ConfigVarManager::LookUpBase(WHY_CONFIG_KEY("system.not_exist")) == nullptr);
+    WHY_LOG_INFO_WITH_STREAM(LOG_ROOT()) << "int_config_handle value is:" << int_config_handle->GetValue();
+}
+
+void test_config_dir() {
+    const std::string dir = "/tmp/why_config_tests.d";
+    why::FSUtil::Rm(dir);
+    why::FSUtil::Mkdir(dir + "/module");
+    std::ofstream(dir + "/system.yml") << "system:\n    port: 9001\n    value: 1.5\n";
+    std::ofstream(dir + "/module/override@10.yml") << "system:\n    port: 9002\n";
+    std::ofstream(dir + "/module/map.yaml") << "system:\n    map:\n        value1: 1\n";
+
+    why::ConfigVarManager::LoadFromConfDir(dir);
+    // 带优先级后缀的文件覆盖同名配置, 其余配置合并
+    ASSERT(int_config_val->GetValue() == 9002);
+    ASSERT(float_config_val->GetValue() == 1.5f);
+    ASSERT(int_map_config_val->GetValue().at("value1") == 1);
+
+    // 文件未变化时不会重新应用
+    int_config_val->SetValue(8080);
+    why::ConfigVarManager::LoadFromConfDir(dir);
+    ASSERT(int_config_val->GetValue() == 8080);
+
+    why::FSUtil::Rm(dir + "/module/override@10.yml");
+    why::ConfigVarManager::LoadFromConfDir(dir);
+    ASSERT(int_config_val->GetValue() == 9001);
+    why::FSUtil::Rm(dir);
+}
+
+void test_config_source() {
+    why::ConfigVarManager::LoadFromSource(why::JsonConfigSource(), R"({
+        "system": {
+            "port": 9100, "value": 2.5,
+            "array": [3, 4, 5],
+            "map": {"value1": 7, "value\u0032": 8},
+            "class": [{"name": "Tom \"3\"", "age": 30, "height": 170}]
+        }
+    })");
+    ASSERT(int_config_val->GetValue() == 9100);
+    ASSERT(float_config_val->GetValue() == 2.5f);
+    ASSERT(int_vec_config_val->GetValue() == std::vector<int>({3, 4, 5}));
+    ASSERT(int_map_config_val->GetValue().at("value2") == 8);
+    ASSERT(person_class_config_val->GetValue().at(0).m_name == "Tom \"3\"");
+
+    why::ConfigVarManager::LoadFromSource(why::PropertiesConfigSource(), 
+        "# comment\n"
+        "system.port = 9200\n"
+        "system.list=[9, 10]\n");
+    ASSERT(int_config_val->GetValue() == 9200);
+    ASSERT(int_list_config_val->GetValue() == std::list<int>({9, 10}));
+}
+
+void test_config_view() {
+    int_vec_config_val->SetValue({1, 2, 3});
+    auto vec_view = int_vec_config_val->GetView();
+    int_vec_config_val->SetValue({4, 5});
+    // 旧视图仍然指向更新前的快照
+    ASSERT(vec_view.size() == 3 && vec_view[2] == 3);
+    ASSERT(int_vec_config_val->GetView().size() == 2);
+
+    int_map_config_val->SetValue({{"b", 2}, {"a", 1}});
+    auto map_view = int_map_config_val->GetView();
+    ASSERT(map_view.Find("a") != nullptr && *map_view.Find("a") == 1);
+    ASSERT(map_view.Find("c") == nullptr);
+    ASSERT(map_view.begin()->first == "a");
+
+    auto str_config_val = why::ConfigVarManager::LookUp("system.name", std::string("why"), "system name");
+    ASSERT(str_config_val->GetView().View() == "why");
+}
+
 void test_log_config() {
     YAML::Node root = YAML::LoadFile("../conf/log.yaml");
     why::ConfigVarManager::LoadFromYaml(root);
@@ -176,6 +255,65 @@ void test_logger() {
     WHY_LOG_LEVEL(sys_logger, why::LogLevel::ERROR, "system log test");
 }
 
+void test_thread_config() {
+    YAML::Node root = YAML::Load(R"(
+threadpools:
+  io:
+    name: io
+    placement: spread
+    cpus: 0-1
+    policy: other
+    nice: 1
+    stack_size: 1048576
+)");
+    why::ConfigVarManager::LoadFromYaml(root);
+    auto options = why::GetWorkerOptions("io");
+    ASSERT(options.placement == why::ThreadPool::CpuPlacement::SPREAD);
+    ASSERT((options.thread.cpus == std::vector<int>{0, 1}) && options.thread.nice == 1);
+    ASSERT(options.thread.stack_size == 1048576 && options.thread.name == "io");
+    ASSERT(why::GetWorkerOptions("unknown") == why::ThreadPool::WorkerOptions{});
+    // 序列化后可以还原
+    auto str = why::LexicalCast<why::ThreadPool::WorkerOptions, std::string>()(options);
+    ASSERT((why::LexicalCast<std::string, why::ThreadPool::WorkerOptions>()(str) == options));
+
+    // 工作线程绑定到配置的 CPU 上
+    options.thread.cpus = {0};
+    why::ThreadPool pool(2);
+    pool.SetWorkerOptions(options);
+    pool.Start();
+    auto name = pool.submit([] {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+        return CPU_COUNT(&set) == 1 && CPU_ISSET(0, &set) ? why::ThisThread::GetName() : std::string();
+    }).Get();
+    pool.Shutdown();
+    ASSERT(name == "io_0" || name == "io_1");
+    WHY_LOG_INFO_WITH_STREAM(LOG_ROOT()) << "threadpools config:" << str;
+}
+
+void test_memory_config() {
+    ASSERT(!why::HugePageAllocator::IsEnabled());
+    YAML::Node root = YAML::Load(R"(
+memory:
+  huge_pages:
+    enabled: true
+    region_size: 4194304
+    hugetlb: false
+    prefault: true
+)");
+    why::ConfigVarManager::LoadFromYaml(root);
+    auto config = why::HugePageAllocator::GetConfig();
+    ASSERT(why::HugePageAllocator::IsEnabled() && config.region_size == 4194304);
+    ASSERT(!config.options.hugetlb && config.options.transparent && config.options.prefault);
+    auto str = why::LexicalCast<why::HugePageAllocator::Config, std::string>()(config);
+    ASSERT((why::LexicalCast<std::string, why::HugePageAllocator::Config>()(str) == config));
+
+    root = YAML::Load("memory: {huge_pages: {enabled: false}}");
+    why::ConfigVarManager::LoadFromYaml(root);
+    ASSERT(!why::HugePageAllocator::IsEnabled() && why::HugePageAllocator::Allocate(64) == nullptr);
+}
+
 int main() {
     // LOG_INFO("ConfigVar:%s, value is:%d, string fmt is:%s", int_config_val->GetName().c_str(), int_config_val->GetValue(), int_config_val->ToString().c_str());
     // LOG_INFO("ConfigVar:%s, value is:%f, string fmt is:%s", float_config_val->GetName().c_str(), float_config_val->GetValue(), float_config_val->ToString().c_str());
@@ -184,8 +322,14 @@ int main() {
     // WHY_LOG_INFO_WITH_STREAM(LOG_ROOT()) << root.IsMap();
     // WHY_LOG_INFO_WITH_STREAM(LOG_ROOT()) << root["logs"];
 
+    test_config_handle();
+    test_config_dir();
+    test_config_source();
+    test_config_view();
     test_log_config();
     test_logger();
+    test_thread_config();
+    test_memory_config();
 
     // test_config();
     
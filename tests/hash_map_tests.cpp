@@ -0,0 +1,194 @@
+#include "common.h"
+#include "config.h"
+#include "log.h"
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @description: 统计存活对象个数,检查删除、扩容和析构时元素被正确销毁
+ */
+struct Counted {
+    static std::atomic<int> s_alive;
+
+    Counted(int v = 0) : value(v) { s_alive++; }
+    Counted(const Counted& rhs) : value(rhs.value) { s_alive++; }
+    Counted(Counted&& rhs) : value(rhs.value) { s_alive++; }
+    Counted& operator=(const Counted& rhs) = default;
+    ~Counted() { s_alive--; }
+
+    int value;
+};
+std::atomic<int> Counted::s_alive{0};
+
+template<typename Func>
+void RunThreads(int num, Func&& func) {
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < num; ++i) {
+        threads.emplace_back(func, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void test_basic() {
+    why::ConcurrentHashMap<std::string, int> map(4);
+    ASSERT(map.GetShardCount() == 4 && map.Empty());
+    ASSERT(map.Insert("a", 1) && !map.Insert("a", 2));
+    ASSERT(!map.InsertOrAssign("a", 3) && map.InsertOrAssign("b", 4));
+    ASSERT(map.Find("a").value() == 3 && map.Find("b").value() == 4 && !map.Find("c"));
+
+    // std::string_view/const char* 查找不构造 std::string
+    std::string buffer = "a.b.c";
+    std::string_view view(buffer.data(), 1);
+    ASSERT(map.Contains(view) && map.Find(std::string_view("b")).value() == 4);
+    int visited = 0;
+    ASSERT(map.Visit(view, [&visited](const int& val) { visited = val; }) && visited == 3);
+    ASSERT(map.GetOrCreate(std::string_view("c"), [] { return 5; }) == 5);
+    ASSERT(map.GetOrCreate("c", [] { return 6; }) == 5 && map.Size() == 3);
+
+    ASSERT(map.Erase(view) && !map.Erase("a") && map.Size() == 2);
+    std::map<std::string, int> items{};
+    map.ForEach([&items](const std::string& key, const int& val) { items[key] = val; });
+    ASSERT(items == (std::map<std::string, int>{{"b", 4}, {"c", 5}}));
+    map.Clear();
+    ASSERT(map.Empty() && !map.Find("b"));
+}
+
+/**
+ * @description: 与 std::map 对照随机插入删除,覆盖扩容、墓碑复用和墓碑过多时的原地重建
+ */
+void test_random_ops() {
+    why::ConcurrentHashMap<uint64_t, Counted> map(2);
+    std::map<uint64_t, int> expected{};
+    std::mt19937_64 rng(42);
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t key = rng() % 2000;
+        int op = rng() % 3;
+        if (op == 0) {
+            ASSERT(map.Insert(key, Counted(i)) == expected.emplace(key, i).second);
+        } else if (op == 1) {
+            ASSERT(map.Erase(key) == (expected.erase(key) == 1));
+        } else {
+            auto val = map.Find(key);
+            auto iter = expected.find(key);
+            ASSERT(val.has_value() == (iter != expected.end()));
+            ASSERT(!val || val->value == iter->second);
+        }
+    }
+    ASSERT(map.Size() == expected.size());
+    size_t count = 0;
+    map.ForEach([&](const uint64_t& key, const Counted& val) {
+        ASSERT(expected.at(key) == val.value);
+        ++count;
+    });
+    ASSERT(count == expected.size() && Counted::s_alive == int(expected.size()));
+    map.Clear();
+    ASSERT(Counted::s_alive == 0);
+    {
+        why::ConcurrentHashMap<int, Counted> other(1, 100);
+        for (int i = 0; i < 100; ++i) {
+            other.Insert(i, Counted(i));
+        }
+    }
+    ASSERT(Counted::s_alive == 0);
+}
+
+/**
+ * @description: 多线程同时 GetOrCreate 同一批 key,每个 key 只创建一次,所有线程拿到同一个对象
+ */
+void test_concurrent_get_or_create() {
+    constexpr int kThreads = 4;
+    constexpr int kKeys = 1000;
+    why::ConcurrentHashMap<std::string, std::shared_ptr<int>> map{};
+    std::atomic<int> created{0};
+    std::vector<std::vector<int*>> results(kThreads, std::vector<int*>(kKeys));
+    RunThreads(kThreads, [&](int idx) {
+        for (int i = 0; i < kKeys; ++i) {
+            int key = (i + idx * 97) % kKeys;
+            results[idx][key] = map.GetOrCreate(std::to_string(key), [&created, key] {
+                created++;
+                return std::make_shared<int>(key);
+            }).get();
+        }
+    });
+    ASSERT(created == kKeys && map.Size() == kKeys);
+    for (int i = 0; i < kKeys; ++i) {
+        for (int t = 1; t < kThreads; ++t) {
+            ASSERT(results[t][i] == results[0][i] && *results[0][i] == i);
+        }
+    }
+}
+
+/**
+ * @description: 写者反复插入删除临时 key 触发扩容与墓碑清理,读者始终能找到常驻 key
+ */
+void test_concurrent_read_write() {
+    why::ConcurrentHashMap<uint64_t, uint64_t> map(4);
+    constexpr uint64_t kResident = 512;
+    for (uint64_t i = 0; i < kResident; ++i) {
+        map.Insert(i, i * 2);
+    }
+    std::atomic<bool> stop{false};
+    std::atomic<bool> missing{false};
+    RunThreads(4, [&](int idx) {
+        if (idx == 0) {
+            for (uint64_t round = 0; round < 50; ++round) {
+                for (uint64_t i = 0; i < 1000; ++i) {
+                    map.Insert(kResident + round * 1000 + i, i);
+                }
+                for (uint64_t i = 0; i < 1000; ++i) {
+                    map.Erase(kResident + round * 1000 + i);
+                }
+                std::this_thread::yield();
+            }
+            stop = true;
+            return;
+        }
+        while (!stop) {
+            for (uint64_t i = 0; i < kResident; ++i) {
+                auto val = map.Find(i);
+                if (!val || *val != i * 2) {
+                    missing = true;
+                }
+            }
+            std::this_thread::yield();
+        }
+    });
+    ASSERT(!missing && map.Size() == kResident);
+}
+
+/**
+ * @description: 迁移到 ConcurrentHashMap 之后的注册表行为不变
+ */
+void test_registries() {
+    auto& mgr = why::LoggerManager::LoggerMgr::Instance();
+    std::string name = "hash_map_tests.logger";
+    auto logger = mgr.GetLogger(name);
+    ASSERT(mgr.GetLogger(std::string_view(name)) == logger && mgr.GetLogger("root") == mgr.GetRoot());
+    ASSERT(YAML::Load(mgr.ToYamlString()).size() >= 2);
+    mgr.DelLogger(name);
+    ASSERT(mgr.GetLogger(name) != logger);
+
+    auto var = why::ConfigVarManager::LookUp<int>("hash_map_tests.port", 8080);
+    ASSERT(why::ConfigVarManager::LookUp<int>(WHY_CONFIG_KEY("hash_map_tests.port"), 0) == var);
+    ASSERT(why::ConfigVarManager::LookUpBase("Hash_Map_Tests.Port") == var);
+    ASSERT(why::ConfigVarManager::LookUpBase("hash_map_tests.none") == nullptr);
+}
+
+int main() {
+    test_basic();
+    test_random_ops();
+    test_concurrent_get_or_create();
+    test_concurrent_read_write();
+    test_registries();
+    std::cout << "hash_map_tests passed" << std::endl;
+    return 0;
+}
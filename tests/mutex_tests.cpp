@@ -0,0 +1,206 @@
+#include "common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+constexpr int kThreads = 4;
+
+template<typename Func>
+void RunThreads(int num, Func&& func) {
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < num; ++i) {
+        threads.emplace_back(func, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void test_mutex() {
+    why::Mutex mutex;
+    uint64_t counter = 0;
+    RunThreads(kThreads, [&](int) {
+        for (int i = 0; i < 100000; ++i) {
+            std::lock_guard<why::Mutex> lock(mutex);
+            ++counter;
+        }
+    });
+    ASSERT(counter == kThreads * 100000);
+    ASSERT(mutex.try_lock() && !mutex.try_lock());
+    mutex.unlock();
+}
+
+/**
+ * @description: 写者在锁内维护 a == b,读者在读锁内不会看到中间状态
+ */
+void test_rw_mutex() {
+    why::RWMutex mutex;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    std::atomic<bool> torn{false};
+    RunThreads(kThreads, [&](int idx) {
+        for (int i = 0; i < 20000; ++i) {
+            if (idx == 0 && i % 10 == 0) {
+                std::unique_lock<why::RWMutex> lock(mutex);
+                ++a;
+                std::this_thread::yield();
+                ++b;
+            } else {
+                std::shared_lock<why::RWMutex> lock(mutex);
+                if (a != b) {
+                    torn = true;
+                }
+            }
+        }
+    });
+    ASSERT(!torn && a == 2000 && b == 2000);
+
+    ASSERT(mutex.try_lock_shared() && !mutex.try_lock());
+    mutex.unlock_shared();
+    ASSERT(mutex.try_lock() && !mutex.try_lock_shared());
+    mutex.unlock();
+}
+
+void test_semaphore() {
+    why::Semaphore items(0);
+    why::Semaphore slots(8);
+    std::atomic<uint64_t> sum{0};
+    constexpr int kItems = 50000;
+    std::thread consumer([&] {
+        for (int i = 0; i < kItems; ++i) {
+            items.Wait();
+            sum += i;
+            slots.Post();
+        }
+    });
+    for (int i = 0; i < kItems; ++i) {
+        slots.Wait();
+        items.Post();
+    }
+    consumer.join();
+    ASSERT(sum == uint64_t(kItems) * (kItems - 1) / 2);
+    ASSERT(!items.TryWait() && slots.TryWait());
+}
+
+void test_latch_barrier_event() {
+    why::Latch latch(kThreads);
+    std::atomic<int> started{0};
+    why::Barrier barrier(kThreads);
+    std::atomic<int> serial{0};
+    std::atomic<int> round_counter{0};
+    std::atomic<bool> mismatch{false};
+    why::Event event;
+    std::atomic<int> woken{0};
+
+    std::thread setter([&] {
+        latch.Wait();
+        ASSERT(started == kThreads);
+        event.Set();
+    });
+    RunThreads(kThreads, [&](int) {
+        started++;
+        latch.CountDown();
+        event.Wait();
+        woken++;
+        for (int round = 0; round < 100; ++round) {
+            round_counter++;
+            if (barrier.ArriveAndWait()) {
+                serial++;
+            }
+            // 所有线程都完成了这一轮的计数
+            if (round_counter.load() < (round + 1) * kThreads) {
+                mismatch = true;
+            }
+            barrier.ArriveAndWait();
+        }
+    });
+    setter.join();
+    ASSERT(latch.TryWait() && woken == kThreads && event.IsSet());
+    ASSERT(serial == 100 && !mismatch);
+    event.Reset();
+    ASSERT(!event.IsSet());
+}
+
+/**
+ * @description: 直接使用 LOCK_GUARD/UNIQUE_LOCK 在 WHY_LOCK_PROFILING 下展开的类型,不依赖编译选项
+ */
+void test_lock_profiler() {
+    static why::LockSite s_guardSite{"mutex_tests.cpp", 1};
+    static why::LockSite s_uniqueSite{"mutex_tests.cpp", 2};
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool ready = false;
+    RunThreads(kThreads, [&](int) {
+        for (int i = 0; i < 1000; ++i) {
+            why::ProfiledLockGuard<&s_guardSite> lock(mutex);
+        }
+    });
+
+    // 主线程持有锁时其他线程一定竞争;这是第 kThreads * 1000 次加锁,是 kHoldSampleRate 的倍数,会采样持有时间
+    std::thread waiter{};
+    {
+        why::ProfiledLockGuard<&s_guardSite> lock(mutex);
+        waiter = std::thread([&] {
+            why::ProfiledUniqueLock<&s_uniqueSite> lock(mutex);
+            cv.wait(lock, [&] { return ready; });
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    {
+        why::ProfiledUniqueLock<&s_uniqueSite> lock(mutex);
+        ready = true;
+        cv.notify_all();
+    }
+    waiter.join();
+
+    // why::Mutex 等其他锁类型通过 LOCK_GUARD_T/UNIQUE_LOCK_T 统计
+    static why::LockSite s_mutexSite{"mutex_tests.cpp", 3};
+    why::Mutex fast;
+    RunThreads(kThreads, [&](int) {
+        for (int i = 0; i < 1000; ++i) {
+            if (i % 2) {
+                why::ProfiledLockGuard<&s_mutexSite, why::Mutex> lock(fast);
+            } else {
+                why::ProfiledUniqueLock<&s_mutexSite, why::Mutex> lock(fast);
+            }
+        }
+    });
+
+    auto top = why::LockProfiler::GetTopContended(0);
+    auto find = [&top](const std::string& site) {
+        return std::find_if(top.begin(), top.end(), [&site](const why::LockSiteStats& stats) {
+            return stats.site == site;
+        });
+    };
+    auto guard = find("mutex_tests.cpp:1");
+    auto unique = find("mutex_tests.cpp:2");
+    ASSERT(guard != top.end() && unique != top.end());
+    ASSERT(guard->acquisitions == kThreads * 1000 + 1 && guard->hold_max_ns >= 10000000);
+    ASSERT(unique->acquisitions == 2 && unique->contended >= 1 && unique->wait_max_ns >= 10000000);
+    auto custom = find("mutex_tests.cpp:3");
+    ASSERT(custom != top.end() && custom->acquisitions == kThreads * 1000);
+    // 按总等待时间排序,等待了 20ms 的位置排在前面
+    ASSERT(why::LockProfiler::GetTopContended(1).front().site == "mutex_tests.cpp:2");
+    ASSERT(YAML::Load(why::LockProfiler::ToYamlString()).IsSequence());
+
+    why::LockProfiler::Reset();
+    for (auto& stats : why::LockProfiler::GetTopContended(0)) {
+        ASSERT(stats.acquisitions == 0 && stats.contended == 0);
+    }
+}
+
+int main() {
+    test_mutex();
+    test_rw_mutex();
+    test_semaphore();
+    test_latch_barrier_event();
+    test_lock_profiler();
+    std::cout << "mutex_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @description: 统计存活对象个数,检查队列析构和出队时元素被正确销毁
+ */
+struct Counted {
+    static std::atomic<int> s_alive;
+
+    Counted(uint64_t v = 0) : value(v) { s_alive++; }
+    Counted(const Counted& rhs) : value(rhs.value) { s_alive++; }
+    Counted& operator=(const Counted& rhs) = default;
+    ~Counted() { s_alive--; }
+
+    uint64_t value;
+};
+std::atomic<int> Counted::s_alive{0};
+
+void test_spsc() {
+    constexpr uint64_t kItems = 1000000;
+    why::SpscQueue<uint64_t> queue(1000);
+    ASSERT(queue.Capacity() == 1024);
+    std::thread producer([&] {
+        uint64_t batch[16];
+        uint64_t next = 0;
+        while (next < kItems) {
+            if (next % 3 == 0) {
+                size_t n = std::min<uint64_t>(16, kItems - next);
+                for (size_t i = 0; i < n; ++i) {
+                    batch[i] = next + i;
+                }
+                size_t pushed = queue.TryPushBatch(batch, n);
+                next += pushed;
+                if (!pushed) {
+                    std::this_thread::yield();
+                }
+            } else if (queue.TryPush(next)) {
+                ++next;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    uint64_t batch[8];
+    while (expected < kItems) {
+        size_t n = queue.TryPopBatch(batch, 8);
+        if (!n) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT(batch[i] == expected);
+            ++expected;
+        }
+    }
+    producer.join();
+    ASSERT(queue.Empty());
+}
+
+/**
+ * @description: 每个生产者的元素按顺序出队,所有元素恰好出队一次
+ */
+template<typename Queue>
+void test_multi_producer(int consumers) {
+    constexpr int kProducers = 4;
+    constexpr uint64_t kPerProducer = 200000;
+    Queue queue(256);
+    std::vector<std::thread> threads{};
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&queue, p] {
+            uint64_t batch[4];
+            uint64_t i = 0;
+            while (i < kPerProducer) {
+                if (i % 2) {
+                    size_t n = std::min<uint64_t>(4, kPerProducer - i);
+                    for (size_t k = 0; k < n; ++k) {
+                        batch[k] = (uint64_t(p) << 32) | (i + k);
+                    }
+                    size_t pushed = queue.TryPushBatch(batch, n);
+                    i += pushed;
+                    if (!pushed) {
+                        std::this_thread::yield();
+                    }
+                } else if (queue.TryPush((uint64_t(p) << 32) | i)) {
+                    ++i;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::atomic<uint64_t> popped{0};
+    std::atomic<bool> disorder{false};
+    std::vector<std::vector<uint8_t>> seen(kProducers, std::vector<uint8_t>(kPerProducer, 0));
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            std::vector<uint64_t> last(kProducers, 0);
+            std::vector<bool> started(kProducers, false);
+            uint64_t batch[8];
+            while (popped.load() < kProducers * kPerProducer) {
+                size_t n = queue.TryPopBatch(batch, 8);
+                if (!n) {
+                    std::this_thread::yield();
+                }
+                for (size_t k = 0; k < n; ++k) {
+                    int p = batch[k] >> 32;
+                    uint64_t i = batch[k] & 0xffffffff;
+                    // 同一个消费者看到的同一生产者的元素是递增的
+                    if (started[p] && i <= last[p]) {
+                        disorder = true;
+                    }
+                    started[p] = true;
+                    last[p] = i;
+                    seen[p][i]++;
+                }
+                popped += n;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT(!disorder && queue.Empty());
+    for (auto& items : seen) {
+        for (auto cnt : items) {
+            ASSERT(cnt == 1);
+        }
+    }
+}
+
+void test_element_lifetime() {
+    {
+        why::MpmcQueue<Counted> mpmc(8);
+        why::SpscQueue<Counted> spsc(8);
+        for (int i = 0; i < 8; ++i) {
+            ASSERT(mpmc.TryPush(Counted(i)) && spsc.TryPush(Counted(i)));
+        }
+        ASSERT(!mpmc.TryPush(Counted(8)) && !spsc.TryEmplace(8));
+        Counted out{};
+        ASSERT(mpmc.TryPop(out) && out.value == 0 && spsc.TryPop(out) && out.value == 0);
+        ASSERT(Counted::s_alive == 1 + 7 + 7);
+    }
+    // 队列中剩余的元素在析构时销毁
+    ASSERT(Counted::s_alive == 0);
+
+    why::MpscQueue<std::unique_ptr<std::string>> queue(4);
+    ASSERT(queue.TryEmplace(new std::string("why")));
+    std::unique_ptr<std::string> str{};
+    ASSERT(queue.TryPop(str) && *str == "why" && !queue.TryPop(str));
+}
+
+void test_blocking_queue() {
+    constexpr int kItems = 100000;
+    why::BlockingQueue<why::MpmcQueue<int>> queue(16);
+    std::atomic<int64_t> sum{0};
+    std::vector<std::thread> consumers{};
+    for (int c = 0; c < 3; ++c) {
+        consumers.emplace_back([&] {
+            int batch[4];
+            size_t n = 0;
+            while ((n = queue.PopBatch(batch, 4)) > 0) {
+                for (size_t i = 0; i < n; ++i) {
+                    sum += batch[i];
+                }
+            }
+        });
+    }
+    std::vector<std::thread> producers{};
+    for (int p = 0; p < 2; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (int i = p; i < kItems; i += 2) {
+                ASSERT(queue.Push(i));
+            }
+        });
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    // 关闭后消费者取完剩余元素再退出
+    queue.Close();
+    for (auto& thread : consumers) {
+        thread.join();
+    }
+    ASSERT(sum == int64_t(kItems) * (kItems - 1) / 2);
+    ASSERT(!queue.Push(1) && !queue.TryPush(1));
+    int item = 0;
+    ASSERT(!queue.Pop(item));
+
+    // 队列满时阻塞的生产者被消费者唤醒
+    why::BlockingQueue<why::SpscQueue<int>> spsc(2);
+    std::thread producer([&spsc] {
+        for (int i = 0; i < 1000; ++i) {
+            spsc.Push(i);
+        }
+    });
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 100 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT(spsc.Pop(item) && item == i);
+    }
+    producer.join();
+}
+
+int main() {
+    test_spsc();
+    test_multi_producer<why::MpscQueue<uint64_t>>(1);
+    test_multi_producer<why::MpmcQueue<uint64_t>>(4);
+    test_element_lifetime();
+    test_blocking_queue();
+    std::cout << "queue_tests passed" << std::endl;
+    return 0;
+}
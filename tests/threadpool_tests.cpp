@@ -0,0 +1,607 @@
+#include "common.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_execute(why::ThreadPool::Mode mode) {
+    why::ThreadPool pool(4, mode);
+    pool.Start();
+    std::vector<std::future<int>> results{};
+    for (int i = 0; i < 1000; ++i) {
+        results.push_back(pool.execute([](int val) { return val * 2; }, i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT(results[i].get() == i * 2);
+    }
+    pool.Shutdown();
+}
+
+void test_nested_submit(why::ThreadPool::Mode mode) {
+    why::ThreadPool pool(4, mode);
+    pool.Start();
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 100; ++i) {
+        pool.execute([&pool, &counter] {
+            for (int j = 0; j < 100; ++j) {
+                pool.execute([&counter] { counter++; });
+            }
+        });
+    }
+    // Shutdown 会等待工作线程内派生的任务也执行完毕
+    pool.Shutdown();
+    ASSERT(counter == 100 * 100);
+}
+
+void test_post(why::ThreadPool::Mode mode) {
+    why::ThreadPool pool(2, mode);
+    pool.Start();
+    std::atomic<int> counter{0};
+    auto ptr = std::make_unique<int>(5);
+    // 只能移动的可调用对象
+    pool.post([&counter, ptr = std::move(ptr)] { counter += *ptr; });
+    pool.post([&counter](int val) { counter += val; }, 3);
+    pool.Shutdown();
+    ASSERT(counter == 8);
+}
+
+void test_unique_task() {
+    int val = 0;
+    auto small = [&val] { ++val; };
+    static_assert(why::UniqueTask::IsInline<decltype(small)>(), "small lambda should be stored inline");
+    char big_buf[128]{};
+    auto big = [&val, big_buf] { val += big_buf[0] + 1; };
+    static_assert(!why::UniqueTask::IsInline<decltype(big)>(), "big lambda should be stored on heap");
+
+    why::UniqueTask t1(small);
+    why::UniqueTask t2(big);
+    why::UniqueTask t3(std::move(t1));
+    t3();
+    t2 = std::move(t3);
+    t2();
+    ASSERT(val == 2 && !t1 && !t3);
+}
+
+void test_future() {
+    why::ThreadPool pool(2);
+    pool.Start();
+
+    // 回调链,最后一步在调用 Then 的线程上直接执行
+    auto chained = pool.submit([](int val) { return val + 1; }, 1)
+        .Then(pool, [](int val) { return std::to_string(val * 10); })
+        .Then([](std::string str) { return str + "!"; });
+    ASSERT(chained.Get() == "20!");
+
+    // 异常跳过后续回调直接传递
+    bool called = false;
+    auto failed = pool.submit([]() -> int { throw std::runtime_error("boom"); })
+        .Then(pool, [&called](int val) { called = true; return val; });
+    bool caught = false;
+    try {
+        failed.Get();
+    } catch (const std::runtime_error& e) {
+        caught = std::string(e.what()) == "boom";
+    }
+    ASSERT(caught && !called);
+
+    // Promise 未设置就析构
+    why::Future<void> broken{};
+    {
+        why::Promise<void> promise{};
+        broken = promise.GetFuture();
+    }
+    caught = false;
+    try {
+        broken.Get();
+    } catch (const std::future_error& e) {
+        caught = e.code() == std::future_errc::broken_promise;
+    }
+    ASSERT(caught);
+
+    std::vector<why::Future<int>> futures{};
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool.submit([i] { return i * i; }));
+    }
+    auto all = why::WhenAll(futures).Get();
+    ASSERT(all.size() == 100 && all[9] == 81);
+
+    why::Promise<int> slow{};
+    futures.push_back(slow.GetFuture());
+    futures.push_back(why::MakeReadyFuture<int>(7));
+    auto any = why::WhenAny(futures).Get();
+    ASSERT(any.first == 1 && any.second == 7);
+    slow.SetValue(1);
+
+    std::vector<why::Future<void>> voids{};
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 10; ++i) {
+        voids.push_back(pool.submit([&counter] { ++counter; }));
+    }
+    why::WhenAll(voids).Get();
+    ASSERT(counter == 10);
+
+    // 回调投递到已经关闭的线程池,post 的异常传递给返回的 Future,不影响完成上游的工作线程
+    why::ThreadPool closed(1);
+    closed.Start();
+    closed.Shutdown();
+    auto check_closed = [](why::Future<int>& future) {
+        try {
+            future.Get();
+        } catch (const why::Exception& e) {
+            return std::string(e.what()).find("already shutdown") != std::string::npos;
+        }
+        return false;
+    };
+    auto rejected = pool.submit([] { return 1; }).Then(closed, [](int val) { return val; });
+    ASSERT(check_closed(rejected));
+    auto ready = why::MakeReadyFuture<int>(1).Then(closed, [](int val) { return val; });
+    ASSERT(check_closed(ready));
+    why::Promise<int> upstream{};
+    auto pending = upstream.GetFuture().Then(closed, [](int val) { return val; });
+    upstream.SetValue(1);
+    ASSERT(check_closed(pending));
+    pool.Shutdown();
+}
+
+void test_timer_future() {
+    auto timer = std::make_shared<why::Timer::TimerQueue>(2);
+    timer->Start();
+    auto begin = std::chrono::steady_clock::now();
+    auto future = timer->AsyncAfterDuration(std::chrono::milliseconds(20), [](int val) { return val * 3; }, 5);
+    ASSERT(future.Get() == 15);
+    ASSERT(std::chrono::steady_clock::now() - begin >= std::chrono::milliseconds(20));
+    timer->Shutdown();
+}
+
+void test_parallel() {
+    why::ThreadPool pool(3);
+    pool.Start();
+    const size_t n = 100003;
+    std::vector<int64_t> data(n);
+    why::parallel_for(pool, size_t(0), n, [&data](size_t i) { data[i] = static_cast<int64_t>((i * 7919) % 1000); });
+    ASSERT(data[n - 1] == static_cast<int64_t>(((n - 1) * 7919) % 1000));
+
+    int64_t sum = why::parallel_reduce(pool, data.begin(), data.end(), int64_t(0));
+    ASSERT(sum == std::accumulate(data.begin(), data.end(), int64_t(0)));
+    // 非交换的操作也按原顺序合并
+    std::vector<std::string> words{"a", "b", "c", "d", "e", "f", "g"};
+    ASSERT(why::parallel_reduce(pool, words.begin(), words.end(), std::string(">"), std::plus<>{}, 2) == ">abcdefg");
+
+    std::vector<int64_t> doubled(n);
+    why::parallel_transform(pool, data.begin(), data.end(), doubled.begin(), [](int64_t v) { return v * 2; });
+    ASSERT(doubled[12345] == data[12345] * 2);
+
+    std::vector<int64_t> scanned(n);
+    std::vector<int64_t> expect(n);
+    why::parallel_scan(pool, data.begin(), data.end(), scanned.begin());
+    std::partial_sum(data.begin(), data.end(), expect.begin());
+    ASSERT(scanned == expect);
+
+    why::parallel_sort(pool, data.begin(), data.end());
+    ASSERT(std::is_sorted(data.begin(), data.end()));
+    why::parallel_sort(pool, data.begin(), data.end(), std::greater<>{}, 1000);
+    ASSERT(std::is_sorted(data.begin(), data.end(), std::greater<>{}));
+
+    // 每个工作线程内再嵌套调用,线程池被占满时也不会死锁
+    std::atomic<int> counter{0};
+    why::parallel_for(pool, 0, 16, [&pool, &counter](int) {
+        why::parallel_for(pool, 0, 100, [&counter](int) { counter++; }, 1);
+    }, 1);
+    ASSERT(counter == 1600);
+
+    bool caught = false;
+    try {
+        why::parallel_for(pool, 0, 1000, [](int i) {
+            if (i == 500) {
+                throw std::runtime_error("chunk failed");
+            }
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    ASSERT(caught);
+    pool.Shutdown();
+}
+
+void test_wait_idle(why::ThreadPool::Mode mode) {
+    why::ThreadPool pool(2, mode);
+    std::atomic<int> errors{0};
+    pool.SetExceptionHandler([&errors](std::exception_ptr) { errors++; });
+    pool.Start();
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 1000; ++i) {
+        pool.post([&counter] { counter++; });
+    }
+    pool.WaitIdle();
+    ASSERT(counter == 1000 && pool.GetPendingCount() == 0);
+
+    // 抛出异常的任务不会结束工作线程
+    pool.post([] { throw std::runtime_error("post"); });
+    auto failed = pool.submit([]() -> int { throw std::runtime_error("submit"); });
+    bool caught = false;
+    try {
+        failed.Get();
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    ASSERT(caught && pool.submit([] { return 1; }).Get() == 1);
+    pool.WaitIdle();
+    ASSERT(errors == 1);
+
+    // 没有积压任务时立即返回,不会轮询等待
+    auto begin = std::chrono::steady_clock::now();
+    pool.post([] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+    pool.Shutdown();
+    ASSERT(std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(300));
+}
+
+void test_shutdown_cancel(why::ThreadPool::Mode mode) {
+    why::ThreadPool pool(1, mode);
+    pool.Start();
+    std::atomic<bool> started{false};
+    pool.post([&started] {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    });
+    std::vector<why::Future<int>> futures{};
+    for (int i = 0; i < 10; ++i) {
+        futures.push_back(pool.submit([i] { return i; }));
+    }
+    while (!started) {
+        std::this_thread::yield();
+    }
+    pool.Shutdown(why::ThreadPool::ShutdownMode::CANCEL_PENDING);
+    for (auto &future : futures) {
+        bool broken = false;
+        try {
+            future.Get();
+        } catch (const std::future_error& e) {
+            broken = e.code() == std::future_errc::broken_promise;
+        }
+        ASSERT(broken);
+    }
+
+    // 超过 deadline 后丢弃剩余任务
+    why::ThreadPool slow(1, mode);
+    slow.Start();
+    std::atomic<int> done{0};
+    for (int i = 0; i < 20; ++i) {
+        slow.post([&done] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            done++;
+        });
+    }
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT(!slow.Shutdown(begin + std::chrono::milliseconds(35)));
+    ASSERT(done < 20 && slow.GetPendingCount() == 0);
+    ASSERT(std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(150));
+}
+
+void test_elastic() {
+    why::ThreadPool::ElasticOptions options{};
+    options.min_threads = 1;
+    options.max_threads = 4;
+    options.target_queue_wait = std::chrono::milliseconds(1);
+    options.grow_interval = std::chrono::nanoseconds(0);
+    options.idle_timeout = std::chrono::milliseconds(50);
+    why::ThreadPool pool(options);
+    pool.Start();
+    ASSERT(pool.IsElastic() && pool.GetThreadNum() == 1);
+
+    // 任务排队超过目标时间后扩容
+    for (int i = 0; i < 16; ++i) {
+        pool.post([] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+    }
+    pool.WaitIdle();
+    auto stats = pool.GetStats();
+    ASSERT(stats.grows > 0 && stats.peak_threads > 1 && stats.peak_threads <= 4);
+    ASSERT(stats.queue_wait_max_ns >= std::chrono::nanoseconds(std::chrono::milliseconds(1)).count());
+
+    // 空闲超时后缩回最小线程数
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (pool.GetThreadNum() > 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stats = pool.GetStats();
+    ASSERT(stats.threads == 1 && stats.shrinks == stats.grows);
+    ASSERT(pool.submit([] { return 7; }).Get() == 7);
+    pool.Shutdown();
+}
+
+/**
+ * @description: 唯一的工作线程被阻塞时提交任务,放开后检查执行顺序
+ */
+void test_priority() {
+    using Priority = why::ThreadPool::Priority;
+    why::ThreadPool pool(1, why::ThreadPool::Mode::PRIORITY);
+    pool.SetPriorityAging(std::chrono::nanoseconds(0));
+    pool.Start();
+    std::atomic<bool> started{false};
+    std::atomic<bool> open{false};
+    auto block = [&pool, &started, &open] {
+        started = false;
+        open = false;
+        pool.post(Priority::HIGH, [&started, &open] {
+            started = true;
+            while (!open) {
+                std::this_thread::yield();
+            }
+        });
+        while (!started) {
+            std::this_thread::yield();
+        }
+    };
+
+    std::vector<std::string> order{};
+    block();
+    auto now = std::chrono::steady_clock::now();
+    pool.post(Priority::LOW, [&order] { order.push_back("low"); });
+    pool.post([&order] { order.push_back("normal"); });
+    pool.post(now + std::chrono::seconds(3), [&order] { order.push_back("edf3"); });
+    pool.post(now + std::chrono::seconds(1), [&order] { order.push_back("edf1"); });
+    pool.post(why::ThreadPool::TaskAttr{Priority::NORMAL, now + std::chrono::seconds(2), nullptr},
+              [&order] { order.push_back("edf2"); });
+    auto high = pool.submit(Priority::HIGH, [&order] { order.push_back("high"); return 1; });
+    open = true;
+    pool.WaitIdle();
+    ASSERT(high.Get() == 1);
+    ASSERT((order == std::vector<std::string>{"high", "edf1", "edf2", "edf3", "normal", "low"}));
+
+    // 过期的任务不执行
+    block();
+    std::atomic<int> expired{0};
+    why::ThreadPool::TaskAttr attr{};
+    attr.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+    attr.on_expired = [&expired] { expired++; };
+    std::atomic<bool> ran{false};
+    pool.post(attr, [&ran] { ran = true; });
+    auto late = pool.submit(std::chrono::steady_clock::now() + std::chrono::milliseconds(1), [] { return 1; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    open = true;
+    bool broken = false;
+    try {
+        late.Get();
+    } catch (const std::future_error& e) {
+        broken = e.code() == std::future_errc::broken_promise;
+    }
+    pool.WaitIdle();
+    ASSERT(broken && !ran && expired == 1 && pool.GetStats().expired == 2);
+    pool.Shutdown();
+
+    // 低优先级任务排队足够久后先于新的高优先级任务执行
+    why::ThreadPool aging(1, why::ThreadPool::Mode::PRIORITY);
+    aging.SetPriorityAging(std::chrono::milliseconds(5));
+    aging.Start();
+    order.clear();
+    started = false;
+    open = false;
+    aging.post([&started, &open] {
+        started = true;
+        while (!open) {
+            std::this_thread::yield();
+        }
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+    aging.post(Priority::LOW, [&order] { order.push_back("low"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    aging.post(Priority::HIGH, [&order] { order.push_back("high"); });
+    open = true;
+    aging.Shutdown();
+    ASSERT((order == std::vector<std::string>{"low", "high"}));
+
+    // 堆顶是新提交的带截止时间的任务时,aging 仍然按该优先级中等待最久的任务计算
+    why::ThreadPool mixed(1, why::ThreadPool::Mode::PRIORITY);
+    mixed.SetPriorityAging(std::chrono::milliseconds(5));
+    mixed.Start();
+    order.clear();
+    started = false;
+    open = false;
+    mixed.post([&started, &open] {
+        started = true;
+        while (!open) {
+            std::this_thread::yield();
+        }
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+    mixed.post(Priority::LOW, [&order] { order.push_back("old"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    mixed.post(why::ThreadPool::TaskAttr{Priority::LOW, std::chrono::steady_clock::now() + std::chrono::seconds(10),
+                                         nullptr},
+               [&order] { order.push_back("fresh"); });
+    mixed.post(Priority::HIGH, [&order] { order.push_back("high"); });
+    open = true;
+    mixed.Shutdown();
+    ASSERT((order == std::vector<std::string>{"fresh", "old", "high"}));
+
+    // 其他模式不支持优先级
+    why::ThreadPool shared(1);
+    bool thrown = false;
+    try {
+        shared.post(Priority::HIGH, [] {});
+    } catch (const why::Exception&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+}
+
+void test_strand(why::ThreadPool::Mode mode) {
+    why::ThreadPool pool(4, mode);
+    pool.Start();
+    why::Strand strand(pool);
+    constexpr int kTasks = 10000;
+    // 不加锁的数据只由 strand 中的任务访问
+    std::vector<int> order{};
+    int running = 0;
+    bool overlap = false;
+    bool inside = true;
+    for (int i = 0; i < kTasks; ++i) {
+        strand.post([i, &strand, &order, &running, &overlap, &inside] {
+            if (running++) {
+                overlap = true;
+            }
+            inside = inside && strand.RunningInThisThread();
+            order.push_back(i);
+            running--;
+        });
+    }
+    auto last = strand.submit([&order] { return order.size(); });
+    ASSERT(last.Get() == kTasks && !overlap && inside && !strand.RunningInThisThread());
+    for (int i = 0; i < kTasks; ++i) {
+        ASSERT(order[i] == i);
+    }
+
+    // 抛出异常后后续任务继续执行,Then 的回调在 strand 中执行
+    std::atomic<bool> thrown{false};
+    pool.SetExceptionHandler([&thrown](std::exception_ptr) { thrown = true; });
+    strand.post([] { throw std::runtime_error("strand"); });
+    auto next = strand.submit([] { return 1; }).Then(strand, [&strand](int val) {
+        return strand.RunningInThisThread() ? val + 1 : -1;
+    });
+    ASSERT(next.Get() == 2);
+
+    // 相同 key 的任务按顺序执行
+    why::KeyedStrand<std::string> keyed(pool, 8);
+    constexpr int kKeys = 64;
+    std::vector<std::vector<int>> per_key(kKeys);
+    for (int i = 0; i < 100; ++i) {
+        for (int k = 0; k < kKeys; ++k) {
+            keyed.post("key" + std::to_string(k), [k, i, &per_key] { per_key[k].push_back(i); });
+        }
+    }
+    pool.WaitIdle();
+    for (auto &values : per_key) {
+        ASSERT(values.size() == 100 && std::is_sorted(values.begin(), values.end()));
+    }
+    pool.Shutdown();
+    ASSERT(thrown);
+
+    // 线程池停止后投递失败,任务不会留在队列中等之后执行
+    bool rejected = false;
+    try {
+        strand.post([] {});
+    } catch (const why::Exception& e) {
+        rejected = true;
+    }
+    ASSERT(rejected && strand.GetPendingCount() == 0);
+    auto orphan = why::MakeReadyFuture<int>(1).Then(strand, [](int val) { return val; });
+    rejected = false;
+    try {
+        orphan.Get();
+    } catch (const why::Exception& e) {
+        rejected = true;
+    }
+    ASSERT(rejected && strand.GetPendingCount() == 0);
+}
+
+void test_thread_options() {
+    why::ThreadOptions options{};
+    options.name = "opt_thread";
+    options.cpus = {0};
+    options.numa_node = 0;
+    options.stack_size = 256 * 1024;
+    std::atomic<int> cpu{-1};
+    why::Thread thread([&cpu] { cpu = sched_getcpu(); }, options);
+    thread.Join();
+    ASSERT(cpu == 0 && thread.GetName() == "opt_thread");
+
+    // 参数无法应用时构造函数抛出异常,不会执行回调
+    options.numa_node = -1;
+    options.cpus = {CPU_SETSIZE + 1};
+    bool thrown = false;
+    try {
+        why::Thread bad([&cpu] { cpu = -2; }, options);
+    } catch (const why::Exception&) {
+        thrown = true;
+    }
+    ASSERT(thrown && cpu == 0);
+
+    ASSERT((why::CpuTopology::ParseCpuList("0-2,5,7-8") == std::vector<int>{0, 1, 2, 5, 7, 8}));
+    ASSERT(!why::CpuTopology::GetCpus().empty());
+
+    why::ThreadPool pool(2);
+    why::ThreadPool::WorkerOptions worker{};
+    worker.placement = why::ThreadPool::CpuPlacement::PACK;
+    pool.SetWorkerOptions(worker);
+    pool.Start();
+    auto name = pool.submit([] { return why::ThisThread::GetName(); }).Get();
+    pool.Shutdown();
+    ASSERT(name == "pool_0" || name == "pool_1");
+}
+
+/**
+ * @description: 工作线程的任务数和 CPU 时间可以从注册表中采样,线程退出后自动注销
+ */
+void test_thread_stats() {
+    why::ThisThread::SetName("stats_main");
+    why::ThreadPool pool(2);
+    why::ThreadPool::WorkerOptions worker{};
+    worker.thread.name = "stats";
+    pool.SetWorkerOptions(worker);
+    pool.Start();
+    constexpr int kTasks = 100;
+    std::atomic<uint64_t> sink{0};
+    for (int i = 0; i < kTasks; ++i) {
+        pool.post([&sink] {
+            uint64_t x = 0;
+            for (uint64_t j = 0; j < 100000; ++j) {
+                x += j * j;
+            }
+            sink += x;
+        });
+    }
+    pool.WaitIdle();
+
+    uint64_t tasks = 0;
+    int workers = 0;
+    bool main_found = false;
+    for (auto& stats : why::ThreadRegistry::Sample()) {
+        if (stats.name.compare(0, 6, "stats_") == 0 && stats.worker) {
+            ++workers;
+            tasks += stats.tasks;
+            ASSERT(stats.busy_ns <= stats.wall_ns && stats.GetBusyRatio() <= 1);
+        } else if (stats.name == "stats_main") {
+            main_found = !stats.worker && stats.tid == why::ThisThread::GetID();
+            ASSERT(stats.cpu_ns > 0);
+        }
+    }
+    ASSERT(workers == 2 && tasks == kTasks && main_found);
+
+    auto yaml = YAML::Load(why::ThreadRegistry::ToYamlString());
+    ASSERT(yaml.IsSequence() && yaml.size() >= 3);
+    auto json = why::ThreadRegistry::ToJsonString();
+    ASSERT(json.front() == '[' && json.find("\"busy_ratio\"") != std::string::npos);
+
+    pool.Shutdown();
+    for (auto& stats : why::ThreadRegistry::Sample()) {
+        ASSERT(!stats.worker || stats.name.compare(0, 6, "stats_") != 0);
+    }
+}
+
+int main() {
+    test_unique_task();
+    test_future();
+    test_parallel();
+    test_timer_future();
+    test_elastic();
+    test_priority();
+    test_thread_options();
+    test_thread_stats();
+    for (auto mode : {why::ThreadPool::Mode::SHARED, why::ThreadPool::Mode::WORK_STEALING}) {
+        test_execute(mode);
+        test_nested_submit(mode);
+        test_post(mode);
+        test_wait_idle(mode);
+        test_shutdown_cancel(mode);
+        test_strand(mode);
+    }
+    std::cout << "threadpool_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,326 @@
+#include "common.h"
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+struct TestNode : public why::Timer::TimingWheel::Node {
+    uint64_t fired{UINT64_MAX};
+};
+
+/**
+ * @description: 随机插入跨越所有层(以及超出范围)的节点,检查每个节点恰好在到期的 tick 被取出
+ */
+void test_timing_wheel() {
+    why::Timer::TimingWheel wheel(12345);
+    std::mt19937_64 rng(42);
+    std::vector<TestNode> nodes(20000);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        uint64_t range = 1ULL << (8 * (i % 5) + 4);
+        nodes[i].expire = 12345 + rng() % range;
+        wheel.Insert(&nodes[i]);
+    }
+    // 删除一部分
+    for (size_t i = 0; i < nodes.size(); i += 7) {
+        wheel.Remove(&nodes[i]);
+    }
+    ASSERT(wheel.Size() == nodes.size() - (nodes.size() + 6) / 7);
+
+    std::vector<why::Timer::TimingWheel::Node*> expired{};
+    uint64_t now = 12345;
+    while (!wheel.Empty()) {
+        now += rng() % (1ULL << (rng() % 34));
+        wheel.Advance(now, expired);
+        uint64_t prev = 0;
+        for (auto node : expired) {
+            auto test = static_cast<TestNode*>(node);
+            ASSERT(test->expire <= now && test->expire >= prev);
+            prev = test->expire;
+            test->fired = now;
+        }
+        expired.clear();
+        // 下一个事件之后才会有节点到期
+        ASSERT(wheel.NextTick() > now);
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        ASSERT((i % 7 == 0) == (nodes[i].fired == UINT64_MAX));
+    }
+
+    // 逐 tick 推进时每个节点都在 expire 当前 tick 取出
+    why::Timer::TimingWheel exact(0);
+    for (size_t i = 0; i < 1000; ++i) {
+        nodes[i].expire = rng() % 200000;
+        exact.Insert(&nodes[i]);
+    }
+    for (uint64_t tick = 0; tick < 200000; ++tick) {
+        exact.Advance(tick, expired);
+        for (auto node : expired) {
+            ASSERT(node->expire == tick);
+        }
+        expired.clear();
+    }
+    ASSERT(exact.Empty());
+}
+
+void test_timer_queue() {
+    auto timer = std::make_shared<why::Timer::TimerQueue>(2);
+    timer->Start();
+    // 任务数远大于线程池大小,不会占用线程池等待
+    constexpr int kTasks = 10000;
+    std::atomic<int> fired{0};
+    std::atomic<int> early{0};
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTasks; ++i) {
+        auto tp = now + std::chrono::milliseconds(i % 50);
+        timer->AddTaskAtTimePoint(tp, [tp, &fired, &early] {
+            if (std::chrono::steady_clock::now() < tp) {
+                early++;
+            }
+            fired++;
+        });
+    }
+    // 已经过期的任务立即执行
+    timer->AddTaskAtTimePoint(now - std::chrono::seconds(1), [&fired] { fired++; });
+    timer->AddRepeatTask(std::chrono::milliseconds(5), 3, [&fired] { fired++; });
+    timer->Shutdown();
+    ASSERT(fired == kTasks + 4 && early == 0);
+    ASSERT(timer->GetPendingCount() == 0);
+}
+
+void test_timer_id() {
+    auto timer = std::make_shared<why::Timer::TimerQueue>(2);
+    timer->Start();
+    using namespace std::chrono;
+
+    std::atomic<int> cancelled{0};
+    auto id = timer->AddTaskAfterDuration(milliseconds(50), [&cancelled] { cancelled++; });
+    ASSERT(id.IsActive() && id.Cancel() && !id.Cancel() && !id.IsActive());
+
+    // 推迟一次性定时器
+    std::atomic<int64_t> fired_at{0};
+    auto begin = steady_clock::now();
+    auto delayed = timer->AddTaskAfterDuration(milliseconds(5), [&fired_at, begin] {
+        fired_at = duration_cast<milliseconds>(steady_clock::now() - begin).count();
+    });
+    ASSERT(delayed.Reset(milliseconds(40)));
+
+    // 有限次数的周期定时器只占用一个节点
+    std::atomic<int> repeat{0};
+    auto rid = timer->AddRepeatTask(milliseconds(2), 5, [&repeat] { repeat++; });
+    ASSERT(timer->GetPendingCount() == 2);
+
+    // 一次性定时器在自己的回调中 Reset,回调结束后再触发一次
+    std::atomic<int> self_reset{0};
+    why::Timer::TimerId self_id{};
+    std::atomic<why::Timer::TimerId*> self_ptr{nullptr};
+    self_id = timer->AddTaskAfterDuration(milliseconds(2), [&self_reset, &self_ptr] {
+        why::Timer::TimerId* id = nullptr;
+        while (!(id = self_ptr.load())) {
+            std::this_thread::yield();
+        }
+        if (self_reset++ == 0) {
+            ASSERT(id->Reset(milliseconds(5)));
+        }
+    });
+    self_ptr = &self_id;
+
+    // 无限周期定时器,回调耗时超过间隔时也不会并发执行
+    std::atomic<int> rate{0};
+    std::atomic<int> concurrent{0};
+    std::atomic<bool> overlap{false};
+    auto periodic = timer->AddPeriodicTask(milliseconds(1), why::Timer::RepeatMode::FIXED_RATE,
+                                           [&rate, &concurrent, &overlap] {
+        if (concurrent++) {
+            overlap = true;
+        }
+        std::this_thread::sleep_for(milliseconds(3));
+        rate++;
+        concurrent--;
+    });
+    std::atomic<int> delay{0};
+    auto delay_id = timer->AddPeriodicTask(milliseconds(1), why::Timer::RepeatMode::FIXED_DELAY, [&delay] { delay++; });
+    std::this_thread::sleep_for(milliseconds(60));
+    ASSERT(periodic.Cancel());
+    ASSERT(delay_id.Reset(milliseconds(2)));
+    int rate_snapshot = rate;
+    std::this_thread::sleep_for(milliseconds(10));
+    // 取消时正在执行的回调最多再完成一次
+    ASSERT(rate <= rate_snapshot + 1 && rate > 0 && !overlap);
+
+    // Shutdown 会取消无限周期定时器并等待其他定时器执行完
+    timer->Shutdown();
+    ASSERT(cancelled == 0 && repeat == 5 && !rid.IsActive());
+    ASSERT(fired_at >= 40 && delay > 0 && !delay_id.IsActive());
+    ASSERT(self_reset == 2 && !self_id.IsActive());
+}
+
+/**
+ * @description: 窗口重叠的定时器应该在很少的几次唤醒内全部执行
+ */
+void test_timer_slack(why::Timer::ClockSource clock) {
+    why::Timer::TimerQueue::Options options{};
+    options.pool_size = 1;
+    options.clock = clock;
+    options.default_slack = std::chrono::milliseconds(64);
+    auto timer = std::make_shared<why::Timer::TimerQueue>(options);
+    timer->Start();
+    std::atomic<int> fired{0};
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) {
+        timer->AddTaskAtTimePoint(now + std::chrono::milliseconds(i % 20), [&fired] { fired++; });
+    }
+    auto strict = timer->AddTaskAtTimePoint(now + std::chrono::milliseconds(30), [&fired] { fired++; });
+    ASSERT(strict.SetSlack(std::chrono::milliseconds(0)));
+    timer->Shutdown();
+    auto stats = timer->GetStats();
+    ASSERT(fired == 101 && stats.fired == 101);
+    ASSERT(stats.wakeups <= 8);
+    // 允许的延迟内执行,不会提前
+    ASSERT(stats.lateness_max_ns < std::chrono::nanoseconds(std::chrono::milliseconds(100)).count());
+}
+
+/**
+ * @description: 不创建驱动线程,把 timerfd 加入自己的 epoll
+ */
+void test_timer_external_epoll() {
+    why::Timer::TimerQueue::Options options{};
+    options.pool_size = 1;
+    options.clock = why::Timer::ClockSource::TIMERFD;
+    options.driver_thread = false;
+    auto timer = std::make_shared<why::Timer::TimerQueue>(options);
+    timer->Start();
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = timer->GetFd();
+    ASSERT(epoll_ctl(epfd, EPOLL_CTL_ADD, timer->GetFd(), &ev) == 0);
+
+    std::atomic<int> fired{0};
+    auto id = timer->AddRepeatTask(std::chrono::milliseconds(2), 3, [&fired] { fired++; });
+    timer->AddTaskAfterDuration(std::chrono::milliseconds(1), [&fired] { fired++; });
+    std::atomic<bool> stop{false};
+    std::thread loop([&] {
+        struct epoll_event events[4];
+        while (!stop) {
+            int n = epoll_wait(epfd, events, 4, 10);
+            if (n > 0) {
+                timer->HandleEvents();
+            }
+        }
+    });
+    timer->Shutdown();
+    stop = true;
+    loop.join();
+    close(epfd);
+    ASSERT(fired == 4 && !id.IsActive() && timer->GetStats().wakeups >= 2);
+
+    // 没有驱动线程持有队列,HandleEvents 之后不调用 Shutdown 直接析构,要等交给线程池的回调结束
+    auto unmanaged = std::make_shared<why::Timer::TimerQueue>(options);
+    unmanaged->Start();
+    std::atomic<int> slow{0};
+    unmanaged->AddTaskAfterDuration(std::chrono::milliseconds(1), [&slow] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        slow++;
+    });
+    struct pollfd pfd{unmanaged->GetFd(), POLLIN, 0};
+    ASSERT(poll(&pfd, 1, 1000) == 1);
+    unmanaged->HandleEvents();
+    unmanaged.reset();
+    ASSERT(slow == 1);
+}
+
+/**
+ * @description: 高精度模式下回调在驱动线程中按微秒级精度执行,不会提前
+ */
+void test_timer_precise() {
+    why::Timer::TimerQueue::Options options{};
+    options.pool_size = 1;
+    options.clock = why::Timer::ClockSource::PRECISE;
+    options.tick = std::chrono::microseconds(1);
+    options.spin_guard = std::chrono::microseconds(500);
+    options.cpu = 0;
+    auto timer = std::make_shared<why::Timer::TimerQueue>(options);
+    timer->Start();
+    constexpr int kTasks = 200;
+    std::atomic<int> fired{0};
+    std::atomic<int> early{0};
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTasks; ++i) {
+        auto tp = now + std::chrono::microseconds(1000 + i * 250);
+        timer->AddTaskAtTimePoint(tp, [tp, &fired, &early] {
+            if (std::chrono::steady_clock::now() < tp) {
+                early++;
+            }
+            fired++;
+        });
+    }
+    std::atomic<int> repeat{0};
+    timer->AddRepeatTask(std::chrono::microseconds(300), 10, [&repeat] { repeat++; });
+    timer->Shutdown();
+    auto stats = timer->GetStats();
+    ASSERT(fired == kTasks && early == 0 && repeat == 10);
+    ASSERT(stats.fired == kTasks + 10 && stats.spin_sec > 0);
+    ASSERT(stats.lateness_p50_ns < std::chrono::nanoseconds(std::chrono::milliseconds(1)).count());
+
+    // 绑定 CPU 失败时 Start 抛异常,驱动线程退出,不再持有队列
+    options.cpu = 1000;
+    auto unpinned = std::make_shared<why::Timer::TimerQueue>(options);
+    std::weak_ptr<why::Timer::TimerQueue> weak = unpinned;
+    bool thrown = false;
+    try {
+        unpinned->Start();
+    } catch (const why::Exception& e) {
+        thrown = true;
+    }
+    unpinned.reset();
+    ASSERT(thrown && weak.expired());
+}
+
+/**
+ * @description: 高精度模式下回调抛异常不会让驱动线程退出,同一批到期的其他任务照常执行
+ */
+void test_timer_precise_exception() {
+    why::Timer::TimerQueue::Options options{};
+    options.pool_size = 1;
+    options.clock = why::Timer::ClockSource::PRECISE;
+    options.tick = std::chrono::microseconds(1);
+    auto timer = std::make_shared<why::Timer::TimerQueue>(options);
+    timer->Start();
+    std::atomic<int> fired{0};
+    auto tp = std::chrono::steady_clock::now() + std::chrono::milliseconds(2);
+    for (int i = 0; i < 5; ++i) {
+        timer->AddTaskAtTimePoint(tp, [i, &fired] {
+            fired++;
+            if (i % 2 == 0) {
+                throw std::runtime_error("precise task error");
+            }
+        });
+    }
+    std::atomic<int> repeat{0};
+    timer->AddRepeatTask(std::chrono::microseconds(500), 3, [&repeat] {
+        repeat++;
+        throw 1;
+    });
+    timer->Shutdown();
+    auto stats = timer->GetStats();
+    ASSERT(fired == 5 && repeat == 3);
+    ASSERT(stats.fired == 8 && stats.failed == 6);
+}
+
+int main() {
+    test_timing_wheel();
+    test_timer_queue();
+    test_timer_id();
+    test_timer_slack(why::Timer::ClockSource::CONDVAR);
+    test_timer_slack(why::Timer::ClockSource::TIMERFD);
+    test_timer_external_epoll();
+    test_timer_precise();
+    test_timer_precise_exception();
+    std::cout << "timer_tests passed" << std::endl;
+    return 0;
+}